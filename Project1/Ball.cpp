@@ -1,155 +1,25 @@
 #include "Ball.h"
 #include "Constants.h"
 
+#include <algorithm>
+#include <cstddef>
 
-Ball::Ball(float x, float y, float z, float r, glm::vec3 col, int num)
-    : position(x, y, z),
-    velocity(0.0f, 0.0f, 0.0f),
-    radius(r),
-    color(col),
-    number(num),
-    mass(1.5f),
-    restitution(0.8f),
-    friction(0.25f),
-    pocketed(false) {
-    generateSphere();
-    setupBuffers();
-}
-
-void Ball::checkHolePocketed() {
-    // Hole positions
-    const std::vector<glm::vec2> holePositions = {
-        glm::vec2(-2.0f, 1.0f),    // Top-left corner
-        glm::vec2(0.0f, 1.0f),     // Top-middle
-        glm::vec2(2.0f, 1.0f),     // Top-right corner
-        glm::vec2(-2.0f, -1.0f),   // Bottom-left corner
-        glm::vec2(0.0f, -1.0f),    // Bottom-middle
-        glm::vec2(2.0f, -1.0f)     // Bottom-right corner
-    };
-
-    const float holeRadius = 0.15f;  // Same as hole radius in setupHoles()
-
-    // Check distance to each hole
-    for (const auto& holePos : holePositions) {
-        float distance = glm::length(glm::vec2(position.x, position.z) - holePos);
-        if (distance < holeRadius) {
-            pocketed = true;
-            // Move the ball below the table to hide it
-            position.y = -1.0f;
-            velocity = glm::vec3(0.0f);
-            break;
-        }
-    }
-}
-
-void Ball::update(float deltaTime) {
-    // Update position based on velocity
-    position += velocity * deltaTime;
-
-    // Apply friction to slow the ball
-    if (glm::length(velocity) > 0.0f) {
-        glm::vec3 frictionForce = -glm::normalize(velocity) * friction;
-        velocity += frictionForce * deltaTime;
-
-        // Stop the ball if velocity is very small
-        if (glm::length(velocity) < 0.01f) {
-            velocity = glm::vec3(0.0f);
-        }
-    }
-}
-
-bool Ball::checkCollision(Ball* other) {
-    if (pocketed || other->pocketed) return false;
-    float distance = glm::length(position - other->position);
-    return distance < (radius + other->radius);
-}
-
-void Ball::resolveCollision(Ball* other) {
-    glm::vec3 normal = glm::normalize(other->position - position);
-    glm::vec3 relativeVelocity = other->velocity - velocity;
-
-    float velocityAlongNormal = glm::dot(relativeVelocity, normal);
-
-    // Only resolve if balls are moving toward each other
-    if (velocityAlongNormal > 0) return;
-
-    float combinedRestitution = (restitution + other->restitution) * 0.5f;
-    float j = -(1.0f + combinedRestitution) * velocityAlongNormal;
-    j /= 1.0f / mass + 1.0f / other->mass;
-
-    glm::vec3 impulse = j * normal;
-    velocity -= impulse / mass;
-    other->velocity += impulse / other->mass;
 
-    // Separate balls to prevent sticking
-    float overlap = radius + other->radius - glm::length(other->position - position);
-    if (overlap > 0) {
-        glm::vec3 separation = normal * overlap * 0.5f;
-        position -= separation;
-        other->position += separation;
-    }
-}
-
-bool Ball::checkEdgeCollision(const Edge& edge) const {
-    if (pocketed) return false;
-
-    // Vector from edge start to ball center
-    glm::vec3 ballToEdgeStart = position - edge.start;
-
-    // Edge vector
-    glm::vec3 edgeVector = edge.end - edge.start;
-    float edgeLength = glm::length(edgeVector);
-    glm::vec3 edgeDirection = edgeVector / edgeLength;
-
-    // Project ball position onto edge
-    float t = glm::dot(ballToEdgeStart, edgeDirection);
-
-    // Find closest point on edge to ball
-    glm::vec3 closestPoint;
-    if (t < 0) closestPoint = edge.start;
-    else if (t > edgeLength) closestPoint = edge.end;
-    else closestPoint = edge.start + edgeDirection * t;
-
-    // Check distance from ball to closest point
-    float distance = glm::length(position - closestPoint);
-    return distance < (radius + edge.cushionWidth);
+Ball::Ball(float r, glm::vec3 col, int num)
+    : color(col),
+    radius(r),
+    number(num) {
 }
 
-void Ball::resolveEdgeCollision(const Edge& edge) {
-    // Find closest point on edge similar to collision check
-    glm::vec3 ballToEdgeStart = position - edge.start;
-    glm::vec3 edgeVector = edge.end - edge.start;
-    float edgeLength = glm::length(edgeVector);
-    glm::vec3 edgeDirection = edgeVector / edgeLength;
-    float t = glm::dot(ballToEdgeStart, edgeDirection);
-
-    glm::vec3 closestPoint;
-    if (t < 0) closestPoint = edge.start;
-    else if (t > edgeLength) closestPoint = edge.end;
-    else closestPoint = edge.start + edgeDirection * t;
-
-    // Calculate collision normal, but ensure it's only in the XZ plane
-    glm::vec3 collisionVector = position - closestPoint;
-    glm::vec3 collisionNormal = glm::normalize(glm::vec3(collisionVector.x, 0.0f, collisionVector.z));
-
-    // Only reflect the XZ components of velocity
-    float velocityAlongNormal = glm::dot(glm::vec3(velocity.x, 0.0f, velocity.z), collisionNormal);
-    if (velocityAlongNormal > 0) return; // Only bounce if moving toward edge
-
-    // Calculate new velocity, preserving any existing y-component
-    float yVelocity = velocity.y; // Store original y velocity
-    glm::vec3 reflectionVector = velocity - (1.0f + restitution) * velocityAlongNormal * collisionNormal;
-    velocity = glm::vec3(reflectionVector.x, yVelocity, reflectionVector.z);
-
-    // Move ball out of edge to prevent sticking, but only in XZ plane
-    float overlap = radius + edge.cushionWidth - glm::length(glm::vec2(collisionVector.x, collisionVector.z));
-    if (overlap > 0) {
-        position.x += collisionNormal.x * overlap;
-        position.z += collisionNormal.z * overlap;
-    }
+BallMesh::BallMesh() {
+    // The vertices only live on the GPU once uploaded
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    generateSphere(vertices, indices);
+    setupBuffers(vertices, indices);
 }
 
-void Ball::generateSphere() {
+void BallMesh::generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices) {
     const int segments = 32;
     const int rings = 16;
 
@@ -164,7 +34,7 @@ void Ball::generateSphere() {
             float y = cos(phi);
             float z = sin(phi) * sin(theta);
 
-            // Add vertex position (scaled by radius)
+            // Add vertex position (unit sphere; each instance scales it by its radius)
             vertices.push_back(x);
             vertices.push_back(y);
             vertices.push_back(z);
@@ -193,10 +63,13 @@ void Ball::generateSphere() {
     }
 }
 
-void Ball::setupBuffers() {
+void BallMesh::setupBuffers(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
+    indexCount = (GLsizei)indices.size();
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
+    glGenBuffers(1, &instanceVBO);
 
     glBindVertexArray(VAO);
 
@@ -212,10 +85,37 @@ void Ball::setupBuffers() {
     // Normal attribute
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+
+    // Per-instance centre and radius, then color, advancing once per ball
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(BallInstance), (void*)offsetof(BallInstance, centre));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(BallInstance), (void*)offsetof(BallInstance, color));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+
+    glBindVertexArray(0);
 }
 
-void Ball::cleanup() {
+int BallMesh::draw(const std::vector<BallInstance>& instances) {
+    if (instances.empty()) return 0;
+
+    // Orphan the old storage so the driver need not wait for last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    instanceCapacity = std::max(instanceCapacity, instances.size());
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(BallInstance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(BallInstance), instances.data());
+
+    glBindVertexArray(VAO);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, (GLsizei)instances.size());
+    glBindVertexArray(0);
+    return 1;
+}
+
+void BallMesh::cleanup() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
-}
\ No newline at end of file
+    glDeleteBuffers(1, &instanceVBO);
+}
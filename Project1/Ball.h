@@ -4,52 +4,42 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <vector>
-#include <memory>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "Shader.h"
-
-struct Edge {
-    glm::vec3 start;
-    glm::vec3 end;
-    glm::vec3 normal;
-    float cushionWidth;
-
-    Edge(glm::vec3 s, glm::vec3 e, glm::vec3 n, float w)
-        : start(s), end(e), normal(n), cushionWidth(w) {}
-};
-
+// Render-side ball: color only. Position and motion live in the physics World.
 struct Ball {
-    glm::vec3 position;
-    glm::vec3 velocity;
     glm::vec3 color;
 
     float radius;
-    float mass;
-    float restitution;
-    float friction;
-
     int number;
-    bool pocketed;
 
-    GLuint VAO, VBO, EBO;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-
-    std::unique_ptr<Shader> shader;
+    Ball(float r, glm::vec3 col, int num);
+};
 
-    Ball(float x, float y, float z, float r, glm::vec3 col, int num);
+// One ball to draw, as the instance buffer holds it: centre, radius and color
+struct BallInstance {
+    glm::vec3 centre;
+    float radius;
+    glm::vec3 color;
+};
 
-    void checkHolePocketed();
-    void update(float deltaTime);
-    bool checkCollision(Ball* other);
-    void resolveCollision(Ball* other);
-    bool checkEdgeCollision(const Edge& edge) const;
-    void resolveEdgeCollision(const Edge& edge);
-    void generateSphere();
-    void setupBuffers();
+// The unit sphere every ball is drawn from. The instances are streamed into a buffer of
+// their own each frame and drawn in one call, so the draw calls and GPU memory stay
+// the same however many balls there are. Draw with the ball shader (ball.vert).
+struct BallMesh {
+    GLuint VAO, VBO, EBO, instanceVBO;
+    GLsizei indexCount;
+    // Instances the buffer has room for; it grows to the largest frame so far
+    size_t instanceCapacity = 0;
+
+    BallMesh();
+
+    void generateSphere(std::vector<float>& vertices, std::vector<unsigned int>& indices);
+    void setupBuffers(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
+    // Returns the number of draw calls made: 1, or 0 for no instances
+    int draw(const std::vector<BallInstance>& instances);
     void cleanup();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "../Physics/NineBallAI.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+const char* difficultyNames[] = { "easy", "medium", "hard" };
+
+// Decisions made per difficulty; games are replayed from a fresh rack until then
+const int decisionsPerRun = 24;
+
+int objectBallsPocketed(const World& world) {
+    int count = 0;
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        count += world.balls.number[i] != cueBallNumber && world.balls.pocketed(i);
+    }
+    return count;
+}
+
+// One shot on the live table, the way the game plays it: step until rest, feed the
+// rules, then evaluate the turn and respot the cue ball after a foul
+TurnResult playShot(World& world, NineBallRules& rules, ShotCandidate shot) {
+    rules.beginShot();
+    strikeCueBall(world, shot);
+
+    int steps = 0;
+    do {
+        world.step(frameTime);
+        rules.processEvents(world, world.events);
+        world.events.clear();
+    } while (!world.isAtRest() && ++steps < 60 * 120);
+
+    TurnResult result = rules.evaluateTurn(world);
+    if (result.respotCueBall) {
+        int cueBall = world.findBall(cueBallNumber);
+        world.balls.setPosition(cueBall, rules.foulPosition);
+        world.balls.setVelocity(cueBall, glm::vec2(0.0f));
+        world.balls.setPocketed(cueBall, false);
+    }
+    return result;
+}
+
+}
+
+void runAIBenchmark() {
+    std::printf("%8s %10s %12s %12s %8s %8s %8s %8s\n",
+        "level", "decide/s", "shots/move", "ms/move", "fouls", "pots", "games", "p1 wins");
+
+    for (int level = AI_EASY; level <= AI_HARD; level++) {
+        // Both players at the same level, seeded apart
+        NineBallAI players[2] = { NineBallAI((AIDifficulty)level, 1), NineBallAI((AIDifficulty)level, 2) };
+
+        World world;
+        NineBallRules rules;
+        setupStandardTable(world);
+        rackNineBall(world);
+
+        size_t shotsEvaluated = 0;
+        int fouls = 0, pots = 0, games = 0, playerOneWins = 0;
+        double seconds = 0.0;
+
+        for (int decision = 0; decision < decisionsPerRun; decision++) {
+            AIDecision move = players[rules.currentPlayer - 1].chooseShot(world, rules);
+            shotsEvaluated += move.shotsEvaluated;
+            seconds += move.seconds;
+
+            int pocketedBefore = objectBallsPocketed(world);
+            TurnResult result = playShot(world, rules, move.shot);
+            fouls += rules.foulThisTurn;
+            pots += objectBallsPocketed(world) - pocketedBefore;
+
+            if (result.gameOver) {
+                games++;
+                playerOneWins += rules.playerWon == 1;
+                rules.reset();
+                rackNineBall(world);
+            }
+        }
+
+        std::printf("%8s %10.2f %12.0f %12.1f %8d %8d %8d %8d\n", difficultyNames[level],
+            decisionsPerRun / seconds, (double)shotsEvaluated / decisionsPerRun,
+            seconds * 1e3 / decisionsPerRun, fouls, pots, games, playerOneWins);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Physics/World.h"
+
+// Runs body() repeatedly until at least minSeconds have elapsed and returns the
+// average wall time of one call in nanoseconds.
+template <typename Body>
+double measureNanoseconds(Body body, double minSeconds = 0.2) {
+    typedef std::chrono::steady_clock Clock;
+
+    long long iterations = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+
+    do {
+        body();
+        iterations++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+
+    return elapsed * 1e9 / iterations;
+}
+
+// Each suite prints its own results to stdout
+void runKernelBenchmark();
+void runBroadPhaseBenchmark();
+void runEventBenchmark();
+void runCcdBenchmark();
+void runSleepBenchmark();
+void runShotBenchmark();
+void runAIBenchmark();
+void runDeterminismBenchmark();
+void runReplayBenchmark();
+void runBoundaryBenchmark();
+void runSchedulerBenchmark();
+void runThreadBenchmark();
+void runInputBenchmark();
+void runScenarioBenchmark();
+void runContactBenchmark();
+void runJobBenchmark();
+void runIntegratorBenchmark();
+void runSpinBenchmark();
+
+// One measured case for --json: numbers and text (e.g. hashes) by name
+struct BenchmarkRecord {
+    std::string suite;
+    std::string name;
+    std::vector<std::pair<std::string, double>> numbers;
+    std::vector<std::pair<std::string, std::string>> text;
+};
+
+// Keeps a case for the --json file; suites meant for tracking between builds call it
+void recordBenchmark(const BenchmarkRecord& record);
+
+// Four cushions without pockets around the origin, and count balls touching in a
+// hexagonal patch around centre, numbered after the others; shared by the scenarios
+// and contacts suites
+void setupBox(World& world, float length, float width);
+void addCluster(World& world, int count, glm::vec2 centre);
+
+// Where the scenarios suite finds its .scenario files (--scenarios <dir>)
+extern std::string scenarioDirectory;
+
+// Set by a suite whose cross-check fails; main() then returns 1
+extern bool benchmarkFailed;
+
+#endif
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Benchmark.h"
+#include "../Physics/BoundaryField.h"
+#include "../Physics/Table.h"
+#include "../Physics/TableGeometry.h"
+
+namespace {
+
+const int queryCount = 4096;
+const int accuracyPoints = 1 << 18;
+const int shotsPerRun = 100;
+
+// Degrees. Contact normals come from the shapes themselves, so they are only off in
+// the odd cell where a shape nearest none of its corners comes closest.
+const float maxNormalError99 = 0.5f;
+
+// The standard table with extra round jaws around each pocket mouth, standing in for
+// a table with many curved features
+TableGeometry tableWithJaws(int jawsPerPocket) {
+    TableGeometry table = standardTableGeometry();
+    for (const Pocket& pocket : table.pockets) {
+        for (int k = 0; k < jawsPerPocket; k++) {
+            float angle = 6.2832f * k / jawsPerPocket;
+            table.jaws.push_back({ pocket.position + glm::vec2(std::cos(angle), std::sin(angle)) * (pocket.radius + cushionWidth), 0.03f });
+        }
+    }
+    table.finalize();
+    return table;
+}
+
+struct FieldAccuracy {
+    float maxDistanceError = 0.0f;
+    // Degrees, at the points where a ball would touch the boundary. Where two shapes
+    // are equally close, such as along the diagonal of a corner, either normal is
+    // right but may not be the one exact() picks, so the worst case is large and the
+    // 99th percentile is the useful figure.
+    float normalError99 = 0.0f;
+};
+
+FieldAccuracy measureAccuracy(const BoundaryField& field, const std::vector<glm::vec2>& points) {
+    FieldAccuracy accuracy;
+    std::vector<float> normalErrors;
+    for (glm::vec2 p : points) {
+        BoundarySample sampled = field.sample(p);
+        BoundarySample exact = field.exact(p);
+        accuracy.maxDistanceError = std::max(accuracy.maxDistanceError, std::abs(sampled.distance - exact.distance));
+        if (exact.distance > 0.0f && exact.distance < ballRadius) {
+            float cosine = glm::clamp(glm::dot(sampled.normal, exact.normal), -1.0f, 1.0f);
+            normalErrors.push_back(std::acos(cosine) * 57.2958f);
+        }
+    }
+
+    if (!normalErrors.empty()) {
+        std::sort(normalErrors.begin(), normalErrors.end());
+        accuracy.normalError99 = normalErrors[normalErrors.size() * 99 / 100];
+    }
+    return accuracy;
+}
+
+struct ShotResult {
+    uint64_t history = 0;
+    int escapes = 0;
+    size_t steps = 0;
+    size_t awake = 0;
+    size_t skipped = 0;
+    double nanoseconds = 0.0;
+};
+
+// Breaks fired in every direction; with a field, none may end up past a cushion
+ShotResult fireBreaks(const TableGeometry& table, bool useField, CushionModel model, bool continuous) {
+    ShotResult result;
+    for (int shot = 0; shot < shotsPerRun; shot++) {
+        World world;
+        applyTableGeometry(world, table);
+        if (!useField) world.boundary.reset();
+        world.cushionModel = model;
+        world.continuousCollision = continuous;
+        world.deterministic = true;
+        rackNineBall(world);
+
+        float angle = shot * 0.0628f;
+        world.balls.setVelocity(0, glm::vec2(std::cos(angle), std::sin(angle)) * 20.0f);
+
+        typedef std::chrono::steady_clock Clock;
+        for (int s = 0; s < 120 * 30; s++) {
+            Clock::time_point start = Clock::now();
+            world.step(frameTime);
+            result.nanoseconds += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            result.steps++;
+            result.awake += world.stats.awakeBalls;
+            result.skipped += world.stats.cushionTestsSkipped;
+            world.events.clear();
+            if (world.isAtRest()) break;
+        }
+
+        for (size_t i = 0; i < world.balls.liveSize(); i++) {
+            if (std::abs(world.balls.x[i]) > tableHalfLength || std::abs(world.balls.z[i]) > tableHalfWidth) {
+                result.escapes++;
+                break;
+            }
+        }
+        result.history = hashCombine(result.history, world.historyHash);
+    }
+    return result;
+}
+
+}
+
+// Cost of one boundary query against the segments and through the field as the number
+// of shapes grows, the field's error, then breaks played with each cushion model.
+// The field used only to skip segment tests must not change any result.
+void runBoundaryBenchmark() {
+    std::mt19937 random(12);
+    std::uniform_real_distribution<float> alongX(-tableHalfLength, tableHalfLength);
+    std::uniform_real_distribution<float> alongZ(-tableHalfWidth, tableHalfWidth);
+    std::vector<glm::vec2> points(accuracyPoints);
+    for (glm::vec2& p : points) p = glm::vec2(alongX(random), alongZ(random));
+    std::vector<glm::vec2> queries(points.begin(), points.begin() + queryCount);
+
+    std::printf("%8s %10s %12s %12s %12s %12s\n", "shapes", "field KiB", "exact ns", "field ns", "max error", "normal p99");
+
+    const int jawCounts[] = { 0, 4, 16, 64 };
+    for (int jaws : jawCounts) {
+        TableGeometry table = tableWithJaws(jaws);
+        const BoundaryField& field = *table.boundary;
+
+        // Volatile so the loops are not optimised away
+        volatile float sink = 0.0f;
+        double exact = measureNanoseconds([&]() {
+            for (glm::vec2 p : queries) sink = sink + field.exact(p).distance;
+        }) / queryCount;
+        double sampled = measureNanoseconds([&]() {
+            for (glm::vec2 p : queries) sink = sink + field.sample(p).distance;
+        }) / queryCount;
+
+        FieldAccuracy accuracy = measureAccuracy(field, points);
+        std::printf("%8zu %10zu %12.1f %12.1f %12.5f %12.2f\n",
+            table.edges.size() + table.jaws.size(), field.memoryBytes() / 1024, exact, sampled,
+            accuracy.maxDistanceError, accuracy.normalError99);
+
+        if (accuracy.maxDistanceError > field.error()) {
+            std::printf("  field error above its bound of %.4f\n", field.error());
+            benchmarkFailed = true;
+        }
+        if (accuracy.normalError99 > maxNormalError99) {
+            std::printf("  contact normals off by more than %.1f degrees\n", maxNormalError99);
+            benchmarkFailed = true;
+        }
+    }
+
+    std::printf("\n%10s %10s %10s %8s %10s %10s\n", "contacts", "cushions", "field", "escapes", "skipped", "ns/step");
+
+    TableGeometry table = standardTableGeometry();
+    for (int continuous = 1; continuous >= 0; continuous--) {
+        ShotResult plain = fireBreaks(table, false, CUSHION_SEGMENTS, continuous != 0);
+        ShotResult skipping = fireBreaks(table, true, CUSHION_SEGMENTS, continuous != 0);
+        ShotResult field = fireBreaks(table, true, CUSHION_FIELD, continuous != 0);
+
+        const char* contacts = continuous ? "swept" : "discrete";
+        const ShotResult* results[] = { &plain, &skipping, &field };
+        const char* models[] = { "segments", "segments", "field" };
+        const char* fields[] = { "no", "skip", "yes" };
+        for (int k = 0; k < 3; k++) {
+            const ShotResult& result = *results[k];
+            std::printf("%10s %10s %10s %5d/%-3d %9.0f%% %10.1f\n", contacts, models[k], fields[k],
+                result.escapes, shotsPerRun, 100.0 * result.skipped / std::max<size_t>(result.awake, 1),
+                result.nanoseconds / result.steps);
+        }
+
+        if (skipping.history != plain.history) {
+            std::printf("  skipping segment tests changed the results\n");
+            benchmarkFailed = true;
+        }
+        if (continuous && field.escapes != 0) {
+            std::printf("  balls escaped through the field\n");
+            benchmarkFailed = true;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Benchmark.h"
+#include "../Physics/World.h"
+
+namespace {
+
+// Balls on a jittered lattice at constant density inside four cushions, so the table
+// grows with the ball count and the number of real contacts per ball stays the same.
+void makeScatteredWorld(World& world, size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> jitter(-0.2f * ballRadius, 0.2f * ballRadius);
+    std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+    size_t side = (size_t)std::ceil(std::sqrt((double)count));
+    float spacing = 2.5f * ballRadius;
+
+    world.balls.clear();
+    world.edges.clear();
+    world.pockets.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        PhysicsBall ball((i % side) * spacing + jitter(rng), (i / side) * spacing + jitter(rng), ballRadius, (int)i);
+        ball.velocity = glm::vec2(speed(rng), speed(rng));
+        world.balls.add(ball);
+    }
+
+    float lo = -spacing;
+    float hi = side * spacing;
+    const float wall = 0.125f;
+    world.edges.push_back(Edge(glm::vec2(lo, lo), glm::vec2(hi, lo), glm::vec2(0.0f, 1.0f), wall));
+    world.edges.push_back(Edge(glm::vec2(lo, hi), glm::vec2(hi, hi), glm::vec2(0.0f, -1.0f), wall));
+    world.edges.push_back(Edge(glm::vec2(lo, lo), glm::vec2(lo, hi), glm::vec2(1.0f, 0.0f), wall));
+    world.edges.push_back(Edge(glm::vec2(hi, lo), glm::vec2(hi, hi), glm::vec2(-1.0f, 0.0f), wall));
+}
+
+const int stepsPerRun = 120;
+
+}
+
+void runBroadPhaseBenchmark() {
+    const size_t counts[] = { 10, 100, 1000, 10000 };
+    const BroadPhaseType types[] = { BROAD_PHASE_BRUTE_FORCE, BROAD_PHASE_GRID, BROAD_PHASE_SWEEP_AND_PRUNE };
+    const char* names[] = { "brute force", "grid", "sweep and prune" };
+
+    std::printf("%8s %16s %14s %14s %10s\n", "balls", "broad phase", "ns/step", "pairs tested", "contacts");
+
+    for (size_t count : counts) {
+        for (int t = 0; t < 3; t++) {
+            World start;
+            makeScatteredWorld(start, count);
+            start.broadPhase.type = types[t];
+
+            // Every run replays the same second of motion from the starting layout,
+            // which keeps the balls moving for the whole measurement
+            World world;
+            size_t tested = 0, contacts = 0, steps = 0;
+            double ns = measureNanoseconds([&]() {
+                world = start;
+                for (int i = 0; i < stepsPerRun; i++) {
+                    world.step(frameTime);
+                    world.events.clear();
+                    tested += world.stats.pairsTested;
+                    contacts += world.stats.contacts;
+                    steps++;
+                }
+            }) / stepsPerRun;
+
+            std::printf("%8zu %16s %14.0f %14zu %10.2f\n", count, names[t], ns, tested / steps, (double)contacts / steps);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "../Physics/Table.h"
+#include "../Physics/World.h"
+
+namespace {
+
+struct TunnellingResult {
+    int shots = 0;
+    int missedContacts = 0;  // grazing shots that never registered a contact
+    int escapes = 0;         // shots where a ball ended up past a cushion
+    float maxOverlap = 0.0f; // deepest ball/ball overlap left after any step
+    size_t steps = 0;
+    double nanoseconds = 0.0;
+};
+
+// Ball centres can never get this close to the rails, since the cushions stop them
+// one ball radius and one cushion width short of it
+bool outsideTable(const World& world, size_t i) {
+    return std::abs(world.balls.x[i]) > tableHalfLength || std::abs(world.balls.z[i]) > tableHalfWidth;
+}
+
+void track(const World& world, TunnellingResult& result, bool& escaped) {
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        if (world.balls.pocketed(i)) continue;
+        if (outsideTable(world, i)) escaped = true;
+
+        for (size_t j = i + 1; j < world.balls.size(); j++) {
+            if (world.balls.pocketed(j)) continue;
+            float overlap = 2.0f * ballRadius - glm::length(world.balls.position(j) - world.balls.position(i));
+            result.maxOverlap = std::max(result.maxOverlap, overlap);
+        }
+    }
+}
+
+double timeStep(World& world, float deltaTime) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    world.step(deltaTime);
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+const int shotsPerRun = 200;
+
+// Two shot families per run: a cue ball aimed to pass an object ball with 1 to 1.9
+// radii of overlap, which must always register a contact, and breaks fired in every
+// direction, which must never leave a ball outside the cushions.
+TunnellingResult fireShots(bool continuous, float power, int stepMultiple) {
+    TunnellingResult result;
+    float deltaTime = frameTime * stepMultiple;
+    int maxSteps = 120 * 30 / stepMultiple;
+
+    for (int shot = 0; shot < shotsPerRun; shot++) {
+        World graze;
+        setupStandardTable(graze);
+        graze.continuousCollision = continuous;
+        float offset = (shot % 2 ? 1.0f : -1.0f) * (1.0f + 0.09f * (shot % 10)) * ballRadius;
+        graze.balls.add(PhysicsBall(-1.5f, 0.0f, ballRadius, cueBallNumber));
+        graze.balls.add(PhysicsBall(0.3f + 0.0075f * shot, offset, ballRadius, 1));
+        graze.balls.setVelocity(0, glm::vec2(power, 0.0f));
+
+        bool contact = false, escaped = false;
+        for (int s = 0; s < maxSteps; s++) {
+            result.nanoseconds += timeStep(graze, deltaTime);
+            result.steps++;
+            for (const WorldEvent& event : graze.events) {
+                if (event.type == BALL_CONTACT) contact = true;
+            }
+            graze.events.clear();
+            track(graze, result, escaped);
+            if (graze.isAtRest()) break;
+        }
+
+        World rack;
+        setupStandardTable(rack);
+        rackNineBall(rack);
+        rack.continuousCollision = continuous;
+        float angle = shot * 0.0534f;
+        rack.balls.setVelocity(0, glm::vec2(std::cos(angle), std::sin(angle)) * power);
+
+        for (int s = 0; s < maxSteps; s++) {
+            result.nanoseconds += timeStep(rack, deltaTime);
+            result.steps++;
+            rack.events.clear();
+            track(rack, result, escaped);
+            if (rack.isAtRest()) break;
+        }
+
+        result.shots++;
+        result.missedContacts += !contact;
+        result.escapes += escaped;
+    }
+
+    return result;
+}
+
+}
+
+// Fires high-power shots with discrete and swept contact tests at growing step sizes.
+// Swept steps must show no missed contacts and no escapes at any step size.
+void runCcdBenchmark() {
+    const int stepMultiples[] = { 1, 2, 4, 8 };
+    const float powers[] = { 10.0f, 20.0f, 40.0f };
+
+    std::printf("%10s %8s %6s %8s %8s %12s %10s\n",
+        "contacts", "dt", "power", "missed", "escapes", "max overlap", "ns/step");
+
+    for (int continuous = 0; continuous < 2; continuous++) {
+        for (int multiple : stepMultiples) {
+            for (float power : powers) {
+                TunnellingResult result = fireShots(continuous != 0, power, multiple);
+                std::printf("%10s %5dx %9.0f %5d/%-3d %8d %12.4f %10.1f\n",
+                    continuous ? "swept" : "discrete", multiple, power,
+                    result.missedContacts, result.shots, result.escapes, result.maxOverlap,
+                    result.nanoseconds / result.steps);
+            }
+        }
+    }
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#include "Benchmark.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+const int maxSteps = 120 * 30;
+
+struct Solver {
+    const char* name;
+    ContactModel model;
+    bool continuous;
+};
+
+const Solver solvers[] = {
+    { "pairwise swept", CONTACTS_PAIRWISE, true },
+    { "pairwise", CONTACTS_PAIRWISE, false },
+    { "islands", CONTACTS_ISLANDS, false }
+};
+
+// The same balls added in the opposite order, so every index differs
+World reversedWorld(const World& world) {
+    World reversed = world;
+    std::vector<PhysicsBall> balls;
+    for (size_t i = 0; i < world.balls.size(); i++) balls.push_back(world.balls.get(i));
+    reversed.balls.clear();
+    for (size_t i = balls.size(); i-- > 0;) reversed.balls.add(balls[i]);
+    return reversed;
+}
+
+// Deepest overlap between two balls in play, by a sweep over x
+float maxOverlap(const World& world) {
+    const BallStore& balls = world.balls;
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < (uint32_t)balls.liveSize(); i++) {
+        if (!balls.pocketed(i)) order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&balls](uint32_t l, uint32_t r) { return balls.x[l] < balls.x[r]; });
+
+    float deepest = 0.0f;
+    for (size_t k = 0; k < order.size(); k++) {
+        uint32_t a = order[k];
+        for (size_t m = k + 1; m < order.size(); m++) {
+            uint32_t b = order[m];
+            float reach = balls.radius[a] + balls.radius[b];
+            if (balls.x[b] - balls.x[a] >= reach) break;
+            float distance = glm::length(balls.position(b) - balls.position(a));
+            deepest = std::max(deepest, reach - distance);
+        }
+    }
+    return deepest;
+}
+
+struct RunResult {
+    int steps = 0;
+    double nanoseconds = 0.0;
+    float overlap = 0.0f;
+    size_t islands = 0;
+    size_t largestIsland = 0;
+    // Final position of each ball by number, NaN once pocketed
+    std::vector<glm::vec2> positions;
+};
+
+RunResult playOut(World world, float stepTime, int overlapEvery) {
+    typedef std::chrono::steady_clock Clock;
+    RunResult result;
+    int limit = (int)(maxSteps * frameTime / stepTime);
+    while (result.steps < limit) {
+        Clock::time_point start = Clock::now();
+        world.step(stepTime);
+        result.nanoseconds += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        result.steps++;
+        result.islands = std::max(result.islands, world.stats.islands);
+        result.largestIsland = std::max(result.largestIsland, world.stats.largestIsland);
+        if (result.steps % overlapEvery == 0) result.overlap = std::max(result.overlap, maxOverlap(world));
+        world.events.clear();
+        if (world.isAtRest()) break;
+    }
+
+    int numbers = 0;
+    for (size_t i = 0; i < world.balls.size(); i++) numbers = std::max(numbers, world.balls.number[i] + 1);
+    result.positions.assign(numbers, glm::vec2(NAN));
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        if (!world.balls.pocketed(i)) result.positions[world.balls.number[i]] = world.balls.position(i);
+    }
+    return result;
+}
+
+// Largest distance between where a ball ends up in two runs; infinite if a ball was
+// pocketed in one and not the other
+float spread(const RunResult& a, const RunResult& b) {
+    float largest = 0.0f;
+    for (size_t n = 0; n < a.positions.size() && n < b.positions.size(); n++) {
+        bool inA = !std::isnan(a.positions[n].x), inB = !std::isnan(b.positions[n].x);
+        if (inA != inB) return INFINITY;
+        if (inA) largest = std::max(largest, glm::length(a.positions[n] - b.positions[n]));
+    }
+    return largest;
+}
+
+void prepare(World& world, const Solver& solver) {
+    world.contactModel = solver.model;
+    world.continuousCollision = solver.continuous;
+    world.deterministic = false;
+}
+
+void record(const char* name, const RunResult& result, float reordered) {
+    BenchmarkRecord record;
+    record.suite = "contacts";
+    record.name = name;
+    record.numbers = {
+        { "steps", (double)result.steps },
+        { "ns_per_step", result.nanoseconds / result.steps },
+        { "islands", (double)result.islands },
+        { "largest_island", (double)result.largestIsland },
+        { "max_overlap", result.overlap },
+        { "reordered_spread", std::isinf(reordered) ? -1.0 : reordered }
+    };
+    recordBenchmark(record);
+}
+
+// The game's break from initializeBalls at longer and longer steps. "reordered" is
+// how far any ball ends up from the same break with the balls stored in reverse;
+// "vs 1/8 step" how far from the same solver at an eighth of the step.
+void rackBreaks() {
+    std::printf("%16s %6s %7s %10s %12s %12s %12s\n", "solver", "step", "steps", "ns/step", "max overlap", "reordered", "vs 1/8 step");
+
+    for (const Solver& solver : solvers) {
+        for (int multiple = 1; multiple <= 4; multiple *= 2) {
+            World world;
+            setupStandardTable(world);
+            rackNineBall(world);
+            prepare(world, solver);
+            strikeCueBall(world, { 1.5708f, 10.0f });
+
+            float stepTime = frameTime * multiple;
+            RunResult result = playOut(world, stepTime, 1);
+            RunResult reordered = playOut(reversedWorld(world), stepTime, 1);
+            RunResult fine = playOut(world, stepTime / 8.0f, 1);
+
+            float reorderedSpread = spread(result, reordered);
+            std::printf("%16s %5dx %7d %10.0f %12.5f %12.5f %12.4f\n", solver.name, multiple, result.steps,
+                result.nanoseconds / result.steps, result.overlap, reorderedSpread, spread(result, fine));
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "break %s %dx", solver.name, multiple);
+            record(name, result, reorderedSpread);
+
+            if (solver.model == CONTACTS_ISLANDS && reorderedSpread != 0.0f) {
+                std::printf("  the island solver depends on ball order\n");
+                benchmarkFailed = true;
+            }
+        }
+    }
+}
+
+// Packed clusters in a pocketless box, broken by the cue ball. The island solver on one
+// thread and on every hardware thread must agree exactly.
+void clusters() {
+    const int sizes[] = { 61, 400, 2000 };
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("\n%7s %16s %8s %7s %10s %8s %9s %12s %10s\n", "balls", "solver", "threads", "steps", "ns/step",
+        "islands", "largest", "max overlap", "reordered");
+
+    for (int size : sizes) {
+        float length = 1.0f + std::sqrt((float)size) * ballRadius * 5.0f;
+        World world;
+        setupBox(world, length, length);
+        world.broadPhase.type = BROAD_PHASE_GRID;
+        world.balls.add(PhysicsBall(-length * 0.5f + 0.3f, 0.0f, ballRadius, cueBallNumber));
+        addCluster(world, size, glm::vec2(0.0f));
+
+        // Settle the cluster into sleep before the shot
+        world.step(frameTime);
+        world.events.clear();
+        strikeCueBall(world, { 1.5708f, 10.0f });
+
+        // The overlap sweep would dominate the largest runs
+        int overlapEvery = size > 500 ? 10 : 1;
+        for (const Solver& solver : solvers) {
+            std::vector<unsigned> threadCounts = { 1 };
+            if (solver.model == CONTACTS_ISLANDS && hardware > 1) threadCounts.push_back(hardware);
+
+            RunResult single;
+            for (unsigned threads : threadCounts) {
+                World start = world;
+                prepare(start, solver);
+                start.solver.threadCount = threads;
+                RunResult result = playOut(start, frameTime, overlapEvery);
+                float reordered = spread(result, playOut(reversedWorld(start), frameTime, overlapEvery));
+
+                std::printf("%7d %16s %8u %7d %10.0f %8zu %9zu %12.5f %10.4f\n", size, solver.name, threads, result.steps,
+                    result.nanoseconds / result.steps, result.islands, result.largestIsland, result.overlap, reordered);
+
+                char name[64];
+                std::snprintf(name, sizeof(name), "cluster %d %s %u", size, solver.name, threads);
+                record(name, result, reordered);
+
+                if (solver.model == CONTACTS_ISLANDS && reordered != 0.0f) {
+                    std::printf("  the island solver depends on ball order\n");
+                    benchmarkFailed = true;
+                }
+                if (threads == 1) {
+                    single = result;
+                }
+                else if (spread(result, single) != 0.0f) {
+                    std::printf("  the island solver depends on the thread count\n");
+                    benchmarkFailed = true;
+                }
+            }
+        }
+    }
+}
+
+}
+
+void runContactBenchmark() {
+    rackBreaks();
+    clusters();
+}
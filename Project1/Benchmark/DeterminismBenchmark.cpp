@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "Benchmark.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+const ShotCandidate breakShot = { 1.5708f, 10.0f };
+
+// History hashes of the break in each mode, from a build without multiply-add
+// contraction. Every build must reproduce them: a compiler that fuses multiplies and
+// adds, or any other change to the arithmetic, shows up here. A change to the physics
+// that moves balls differently has to update them.
+struct ExpectedBreak {
+    bool continuous;
+    bool fixedPoint;
+    uint64_t history;
+};
+const ExpectedBreak expectedBreaks[] = {
+    { true, false, 0xf6d81545c3ce1fbcull },
+    { true, true, 0x0c382a4482d1ec23ull },
+    { false, false, 0x4e1bb610f76321a7ull },
+    { false, true, 0xd7d4f9fc17074306ull },
+};
+
+// The break stepped directly, keeping every per-step hash
+std::vector<uint64_t> stepHashes(bool fixedPoint, bool continuous, uint64_t& history) {
+    World world;
+    setupStandardTable(world);
+    rackNineBall(world);
+    world.deterministic = true;
+    world.fixedPoint = fixedPoint;
+    world.continuousCollision = continuous;
+
+    std::vector<uint64_t> hashes;
+    strikeCueBall(world, breakShot);
+    do {
+        world.step(frameTime);
+        world.events.clear();
+        hashes.push_back(world.stateHash);
+    } while (!world.isAtRest());
+
+    history = world.historyHash;
+    return hashes;
+}
+
+}
+
+void runDeterminismBenchmark() {
+    unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+
+    std::printf("%10s %8s %8s %18s %10s %10s %10s %8s\n", "contacts", "fixed", "steps", "history hash", "expected",
+        "repeat", "threads", "result");
+
+    for (const ExpectedBreak& expected : expectedBreaks) {
+        bool continuous = expected.continuous;
+        bool fixedPoint = expected.fixedPoint;
+
+        uint64_t history = 0, repeatHistory = 0;
+        std::vector<uint64_t> hashes = stepHashes(fixedPoint, continuous, history);
+        bool repeat = stepHashes(fixedPoint, continuous, repeatHistory) == hashes && repeatHistory == history;
+
+        // The same break many times over, on one thread and on several
+        World world;
+        setupStandardTable(world);
+        rackNineBall(world);
+        world.deterministic = true;
+        world.fixedPoint = fixedPoint;
+        world.continuousCollision = continuous;
+        NineBallRules rules;
+        std::vector<ShotCandidate> shots(64, breakShot);
+
+        ShotEvaluator evaluator;
+        std::vector<ShotOutcome> serial, parallel;
+        evaluator.threadCount = 1;
+        evaluator.evaluate(world, rules, shots, serial);
+        evaluator.threadCount = threads;
+        evaluator.evaluate(world, rules, shots, parallel);
+
+        bool sameThreads = true;
+        for (size_t i = 0; i < shots.size(); i++) {
+            sameThreads = sameThreads && serial[i].historyHash == history && parallel[i].historyHash == history &&
+                serial[i].steps == (int)hashes.size() && parallel[i].steps == (int)hashes.size();
+        }
+
+        bool sameBuild = history == expected.history;
+        bool pass = repeat && sameThreads && sameBuild;
+        if (!pass) benchmarkFailed = true;
+
+        const char* contacts = continuous ? "swept" : "discrete";
+        std::printf("%10s %8s %8zu %18llx %10s %10s %10s %8s\n", contacts, fixedPoint ? "yes" : "no",
+            hashes.size(), (unsigned long long)history, sameBuild ? "same" : "DIFFERS", repeat ? "same" : "DIFFERS",
+            sameThreads ? "same" : "DIFFER", pass ? "PASS" : "FAIL");
+        if (!sameBuild) {
+            std::printf("  expected %llx; check that the build does not contract into FMA (-ffp-contract=off)\n",
+                (unsigned long long)expected.history);
+        }
+
+        char hash[17], expectedHash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)history);
+        std::snprintf(expectedHash, sizeof(expectedHash), "%016llx", (unsigned long long)expected.history);
+        BenchmarkRecord record;
+        record.suite = "determinism";
+        record.name = std::string(contacts) + (fixedPoint ? " fixed" : "");
+        record.numbers = { { "steps", (double)hashes.size() } };
+        record.text = { { "history", hash }, { "expected", expectedHash } };
+        recordBenchmark(record);
+    }
+
+    // What hashing every step costs
+    World start;
+    setupStandardTable(start);
+    rackNineBall(start);
+    strikeCueBall(start, breakShot);
+    for (int hashing = 0; hashing < 2; hashing++) {
+        World world;
+        double ns = measureNanoseconds([&]() {
+            world = start;
+            world.deterministic = hashing != 0;
+            for (int i = 0; i < 240; i++) {
+                world.step(frameTime);
+                world.events.clear();
+            }
+        }) / 240;
+        std::printf("%s: %.0f ns/step\n", hashing ? "deterministic" : "default", ns);
+    }
+}
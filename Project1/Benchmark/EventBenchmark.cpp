@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "../Physics/EventSimulator.h"
+#include "../Physics/Table.h"
+#include "../Physics/World.h"
+
+namespace {
+
+struct Scenario {
+    const char* name;
+    void (*setup)(World& world, int shot);
+};
+
+// Cue ball alone, banked off one or two cushions
+void setupCushionShot(World& world, int shot) {
+    setupStandardTable(world);
+    world.balls.add(PhysicsBall(-1.0f, -0.4f + 0.02f * shot, ballRadius, cueBallNumber));
+    world.balls.setVelocity(0, glm::vec2(1.5f + 0.05f * shot, 0.3f));
+}
+
+// Cue ball driven into a single object ball
+void setupCutShot(World& world, int shot) {
+    setupStandardTable(world);
+    world.balls.add(PhysicsBall(-1.0f, 0.0f, ballRadius, cueBallNumber));
+    world.balls.add(PhysicsBall(0.5f, -0.1f + 0.005f * shot, ballRadius, 1));
+    world.balls.setVelocity(0, glm::vec2(2.0f + 0.05f * shot, 0.0f));
+}
+
+// Full nine-ball break over a fan of angles and powers
+void setupBreakShot(World& world, int shot) {
+    setupStandardTable(world);
+    rackNineBall(world);
+    float angle = -0.3f + 0.6f * shot / 39.0f;
+    float power = 2.0f + (shot % 5);
+    world.balls.setVelocity(0, glm::vec2(std::cos(angle), std::sin(angle)) * power);
+}
+
+const int shotsPerScenario = 40;
+const int maxSteps = 120 * 120;
+
+void runFixedStep(World& world, size_t& steps, int substeps = 1) {
+    for (int s = 0; s < maxSteps * substeps; s++) {
+        world.step(frameTime / substeps);
+        world.events.clear();
+        steps++;
+        if (world.isAtRest()) break;
+    }
+}
+
+}
+
+// Times the event-driven simulator against the fixed-step World and cross-checks
+// final states, both at frameTime and with 16 substeps as a converged reference.
+// Single-contact shots should agree to within World's stop threshold; breaks are
+// chaotic, and small differences grow into different outcomes for a few shots.
+void runEventBenchmark() {
+    const Scenario scenarios[] = {
+        {"cushion", setupCushionShot},
+        {"cut", setupCutShot},
+        {"break", setupBreakShot}
+    };
+
+    std::printf("%8s %10s %10s %8s %8s %12s %12s %12s\n",
+        "scenario", "fixed us", "event us", "steps", "events", "pots/fixed", "pots/fine", "fine drift");
+
+    for (const Scenario& scenario : scenarios) {
+        double fixedNs = 0.0, eventNs = 0.0, maxDrift = 0.0;
+        size_t steps = 0, events = 0;
+        int samePockets = 0, sameFinePockets = 0;
+
+        for (int shot = 0; shot < shotsPerScenario; shot++) {
+            World start;
+            scenario.setup(start, shot);
+
+            World fixed;
+            size_t shotSteps = 0;
+            fixedNs += measureNanoseconds([&]() {
+                fixed = start;
+                shotSteps = 0;
+                runFixedStep(fixed, shotSteps);
+            }, 0.01);
+            steps += shotSteps;
+
+            size_t shotEvents = 0;
+            double restTime = 0.0;
+            eventNs += measureNanoseconds([&]() {
+                EventSimulator simulator(start);
+                restTime = simulator.simulateToRest();
+                shotEvents = simulator.getEvents().size();
+            }, 0.01);
+            events += shotEvents;
+
+            EventSimulator simulator(start);
+            World analytic = start;
+            simulator.stateAt(simulator.simulateToRest(), analytic);
+
+            World fine = start;
+            size_t fineSteps = 0;
+            runFixedStep(fine, fineSteps, 16);
+
+            bool same = true, sameFine = true;
+            // Stepped worlds compact pocketed balls to the end, so match balls by number
+            for (size_t i = 0; i < analytic.balls.size(); i++) {
+                int number = analytic.balls.number[i];
+                int f = fixed.findBall(number);
+                int g = fine.findBall(number);
+                if (fixed.balls.pocketed(f) != analytic.balls.pocketed(i)) same = false;
+                if (fine.balls.pocketed(g) != analytic.balls.pocketed(i)) sameFine = false;
+                else if (!fine.balls.pocketed(g)) {
+                    maxDrift = std::max(maxDrift, (double)glm::length(fine.balls.position(g) - analytic.balls.position(i)));
+                }
+            }
+            samePockets += same;
+            sameFinePockets += sameFine;
+        }
+
+        std::printf("%8s %10.1f %10.1f %8zu %8zu %9d/%-2d %9d/%-2d %12.4f\n", scenario.name,
+            fixedNs / shotsPerScenario * 1e-3, eventNs / shotsPerScenario * 1e-3,
+            steps / shotsPerScenario, events / shotsPerScenario,
+            samePockets, shotsPerScenario, sameFinePockets, shotsPerScenario, maxDrift);
+    }
+}
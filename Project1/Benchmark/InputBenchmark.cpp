@@ -0,0 +1,150 @@
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "Benchmark.h"
+#include "../Physics/InputEvents.h"
+
+namespace {
+
+const int batchSize = 64;
+const int streamLength = 1000000;
+
+InputEvent makeEvent(int sequence) {
+    InputEvent event;
+    event.time = sequence * 0.001;
+    event.type = INPUT_CURSOR;
+    event.code = (int16_t)sequence;
+    event.x = (float)sequence;
+    return event;
+}
+
+// The same hand-off through a locked deque, for comparison
+class LockedQueue {
+public:
+    void push(const InputEvent& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.push_back(event);
+    }
+
+    bool pop(InputEvent& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.empty()) return false;
+        event = events.front();
+        events.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<InputEvent> events;
+};
+
+struct StreamResult {
+    double nanoseconds = 0.0;
+    int outOfOrder = 0;
+    size_t refused = 0;
+};
+
+// A producer thread pushes events as fast as it can while this thread pops them and
+// checks they come out in order. A full ring makes the producer retry; either side
+// yields while it cannot go on, so the two share a single core fairly.
+template <typename Queue>
+StreamResult streamThrough(Queue& queue) {
+    StreamResult result;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+
+    size_t refused = 0;
+    std::thread producer([&queue, &refused]() {
+        for (int i = 0; i < streamLength; i++) {
+            InputEvent event = makeEvent(i);
+            while (!queue.push(event)) {
+                refused++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    InputEvent event;
+    int expected = 0;
+    while (expected < streamLength) {
+        if (!queue.pop(event)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (event.x != (float)expected || event.code != (int16_t)expected) result.outOfOrder++;
+        expected++;
+    }
+    producer.join();
+
+    result.nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / streamLength;
+    result.refused = refused;
+    return result;
+}
+
+// LockedQueue::push() cannot fail
+struct LockedStream {
+    LockedQueue queue;
+    bool push(const InputEvent& event) { queue.push(event); return true; }
+    bool pop(InputEvent& event) { return queue.pop(event); }
+};
+
+}
+
+// Cost of handing input events from the window callbacks to the game loop: a push and
+// a pop on one thread, as the game does them (the callbacks run inside the event
+// poll), then a stream across two threads, against a locked deque.
+void runInputBenchmark() {
+    static InputQueue queue;
+    LockedQueue locked;
+    volatile float sink = 0.0f;
+
+    double ring = measureNanoseconds([&]() {
+        for (int i = 0; i < batchSize; i++) queue.push(makeEvent(i));
+        InputEvent event;
+        while (queue.pop(event)) sink = sink + event.x;
+    }) / batchSize;
+    double mutexed = measureNanoseconds([&]() {
+        for (int i = 0; i < batchSize; i++) locked.push(makeEvent(i));
+        InputEvent event;
+        while (locked.pop(event)) sink = sink + event.x;
+    }) / batchSize;
+
+    std::printf("%12s %16s %16s %10s %10s\n", "queue", "same thread ns", "two threads ns", "refused", "order");
+
+    static InputQueue streamed;
+    StreamResult ringStream = streamThrough(streamed);
+    LockedStream lockedStream;
+    StreamResult mutexStream = streamThrough(lockedStream);
+
+    std::printf("%12s %16.1f %16.1f %10zu %10s\n", "spsc ring", ring, ringStream.nanoseconds,
+        ringStream.refused, ringStream.outOfOrder ? "FAIL" : "ok");
+    std::printf("%12s %16.1f %16.1f %10s %10s\n", "mutex deque", mutexed, mutexStream.nanoseconds,
+        "-", mutexStream.outOfOrder ? "FAIL" : "ok");
+
+    if (ringStream.outOfOrder > 0) {
+        std::printf("  %d events came out of the ring out of order\n", ringStream.outOfOrder);
+        benchmarkFailed = true;
+    }
+
+    // The log must give back exactly what was consumed
+    std::vector<InputEvent> events, loaded;
+    for (int i = 0; i < 1000; i++) events.push_back(makeEvent(i * 7 - 300));
+    std::string error;
+    if (!saveInputLog("input-benchmark.bin", events, error) || !loadInputLog("input-benchmark.bin", loaded, error)) {
+        std::printf("  %s\n", error.c_str());
+        benchmarkFailed = true;
+        return;
+    }
+    std::remove("input-benchmark.bin");
+
+    bool same = loaded.size() == events.size();
+    for (size_t i = 0; same && i < events.size(); i++) {
+        same = loaded[i].time == events[i].time && loaded[i].type == events[i].type && loaded[i].mods == events[i].mods &&
+            loaded[i].code == events[i].code && loaded[i].x == events[i].x && loaded[i].y == events[i].y;
+    }
+    std::printf("\ninput log: %zu events, %s\n", loaded.size(), same ? "round trip ok" : "round trip FAILED");
+    if (!same) benchmarkFailed = true;
+}
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "../Physics/BallKernels.h"
+#include "../Physics/EventSimulator.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+struct IntegratorCase {
+    const char* name;
+    Integrator integrator;
+};
+
+const IntegratorCase integrators[] = {
+    { "euler", INTEGRATOR_EULER },
+    { "semi-implicit", INTEGRATOR_SEMI_IMPLICIT },
+    { "exact", INTEGRATOR_EXACT },
+    { "rk4", INTEGRATOR_RK4 }
+};
+
+const int stepRates[] = { 240, 120, 60, 30 };
+// Up to a hard break; faster balls roll far enough that float rounding of the position
+// outweighs the integrators' own error
+const float speeds[] = { 0.5f, 1.0f, 2.0f, 4.0f };
+
+struct RollError {
+    // Largest distance from the closed-form path at any step, and where the ball
+    // stopped, in millimetres
+    double path = 0.0;
+    double rest = 0.0;
+    // Stop time minus the true one, in milliseconds; a stepped ball stops at the end
+    // of a step
+    double stopTime = 0.0;
+};
+
+// One ball rolling from the origin on an open plane, checked after every step against
+// p(t) = v t - f t^2 v / (2 |v|) up to its stop
+RollError rollError(Integrator integrator, float stepTime) {
+    RollError error;
+    glm::dvec2 direction = glm::normalize(glm::dvec2(0.8, 0.6));
+
+    for (float speed : speeds) {
+        BallStore balls;
+        PhysicsBall ball(0.0f, 0.0f, ballRadius, cueBallNumber);
+        ball.velocity = glm::vec2(direction * (double)speed);
+        balls.add(ball);
+
+        double friction = balls.friction[0];
+        double stop = speed / friction;
+        auto truePosition = [&](double t) {
+            t = std::min(t, stop);
+            return direction * (speed * t - 0.5 * friction * t * t);
+        };
+
+        int step = 0;
+        bool moving = true;
+        while (moving && step < (int)((stop + 1.0) / stepTime)) {
+            moving = integrateBalls(balls, stepTime, integrator);
+            step++;
+            double t = step * (double)stepTime;
+            double off = glm::length(glm::dvec2(balls.position(0)) - truePosition(t)) * 1e3;
+            error.path = std::max(error.path, off);
+        }
+        error.rest = std::max(error.rest, glm::length(glm::dvec2(balls.position(0)) - truePosition(stop)) * 1e3);
+        error.stopTime = std::max(error.stopTime, std::abs(step * (double)stepTime - stop) * 1e3);
+    }
+    return error;
+}
+
+// Cost of one integration of a block of rolling balls
+double integrateNanoseconds(Integrator integrator, float stepTime) {
+    const int count = 4096;
+    BallStore balls;
+    for (int i = 0; i < count; i++) {
+        PhysicsBall ball((float)(i % 64), (float)(i / 64), ballRadius, i);
+        balls.add(ball);
+    }
+    return measureNanoseconds([&]() {
+        // Restart the block before friction stops it
+        if (balls.vx[0] < 0.5f) {
+            for (int i = 0; i < count; i++) balls.setVelocity(i, glm::vec2(5.0f, 2.0f + (i % 7) * 0.1f));
+        }
+        integrateBalls(balls, stepTime, integrator);
+    }, 0.05) / count;
+}
+
+struct TableShot {
+    const char* name;
+    void (*setup)(World& world);
+};
+
+// A ball running round the cushions, and a cue ball driving an object ball along the
+// table; both avoid the pockets
+void cushionRun(World& world) {
+    PhysicsBall ball(-0.6f, 0.1f, ballRadius, cueBallNumber);
+    ball.velocity = glm::vec2(2.2658f, 1.0565f);
+    world.balls.add(ball);
+}
+
+void objectBall(World& world) {
+    PhysicsBall cue(-0.9f, 0.0f, ballRadius, cueBallNumber);
+    cue.velocity = glm::vec2(4.0f, 0.15f);
+    world.balls.add(cue);
+    world.balls.add(PhysicsBall(0.2f, 0.03f, ballRadius, 1));
+}
+
+const TableShot tableShots[] = {
+    { "cushion run", cushionRun },
+    { "object ball", objectBall }
+};
+
+struct ShotError {
+    // Largest distance from the event simulator over every ball and step, and at
+    // rest, in millimetres; -1 if the two disagree on which balls dropped
+    double path = 0.0;
+    double rest = 0.0;
+    int steps = 0;
+};
+
+// The stepped world against the event simulator's exact paths, after every step
+ShotError shotError(const TableShot& shot, Integrator integrator, float stepTime) {
+    World start;
+    setupStandardTable(start);
+    start.deterministic = false;
+    start.continuousCollision = true;
+    start.integrator = integrator;
+    shot.setup(start);
+
+    EventSimulator simulator(start);
+    double restTime = simulator.simulateToRest();
+
+    World world = start;
+    World reference = start;
+    ShotError error;
+    auto compare = [&](double t) {
+        simulator.stateAt(t, reference);
+        double largest = 0.0;
+        for (size_t i = 0; i < reference.balls.size(); i++) {
+            int b = world.findBall(reference.balls.number[i]);
+            if (world.balls.pocketed(b) != reference.balls.pocketed(i)) return -1.0;
+            if (world.balls.pocketed(b)) continue;
+            largest = std::max(largest, (double)glm::length(world.balls.position(b) - reference.balls.position(i)) * 1e3);
+        }
+        return largest;
+    };
+
+    int limit = (int)((restTime + 2.0) / stepTime);
+    while (error.steps < limit) {
+        world.step(stepTime);
+        world.events.clear();
+        error.steps++;
+        double off = compare(error.steps * (double)stepTime);
+        if (off < 0.0 || error.path < 0.0) error.path = -1.0;
+        else error.path = std::max(error.path, off);
+        if (world.isAtRest()) break;
+    }
+    error.rest = compare(std::max(restTime, error.steps * (double)stepTime));
+    return error;
+}
+
+}
+
+// Each integrator at 240, 120, 60 and 30 steps per second. A single ball on an open plane
+// is checked against the closed-form path; then whole shots on the standard table
+// against the event simulator, which solves every path and contact exactly. The exact
+// integrator at 30 steps per second must stay on the path at least as well as Euler
+// does at the game's 120.
+void runIntegratorBenchmark() {
+    std::printf("%14s %5s %12s %12s %12s %10s\n", "integrator", "rate", "path mm", "rest mm", "stop ms", "ns/ball");
+
+    double eulerGame = 0.0, exactCoarse = 0.0;
+    for (const IntegratorCase& entry : integrators) {
+        for (int rate : stepRates) {
+            float stepTime = 1.0f / rate;
+            RollError error = rollError(entry.integrator, stepTime);
+            double nanoseconds = integrateNanoseconds(entry.integrator, stepTime);
+            std::printf("%14s %5d %12.4f %12.4f %12.2f %10.2f\n", entry.name, rate, error.path, error.rest,
+                error.stopTime, nanoseconds);
+
+            if (entry.integrator == INTEGRATOR_EULER && rate == 120) eulerGame = error.path;
+            if (entry.integrator == INTEGRATOR_EXACT && rate == 30) exactCoarse = error.path;
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "roll %s %d", entry.name, rate);
+            BenchmarkRecord record;
+            record.suite = "integrators";
+            record.name = name;
+            record.numbers = {
+                { "path_error_mm", error.path },
+                { "rest_error_mm", error.rest },
+                { "stop_time_error_ms", error.stopTime },
+                { "ns_per_ball", nanoseconds }
+            };
+            recordBenchmark(record);
+        }
+    }
+    if (exactCoarse > eulerGame) {
+        std::printf("  exact at 1/30 s is further off the path than Euler at 1/120 s\n");
+        benchmarkFailed = true;
+    }
+
+    std::printf("\n%12s %14s %5s %7s %12s %12s\n", "shot", "integrator", "rate", "steps", "path mm", "rest mm");
+    for (const TableShot& shot : tableShots) {
+        for (const IntegratorCase& entry : integrators) {
+            for (int rate : stepRates) {
+                ShotError error = shotError(shot, entry.integrator, 1.0f / rate);
+                if (error.path < 0.0) {
+                    std::printf("%12s %14s %5d %7d %12s %12s\n", shot.name, entry.name, rate, error.steps, "pockets", "differ");
+                }
+                else {
+                    std::printf("%12s %14s %5d %7d %12.3f %12.3f\n", shot.name, entry.name, rate, error.steps,
+                        error.path, error.rest);
+                }
+
+                char name[64];
+                std::snprintf(name, sizeof(name), "%s %s %d", shot.name, entry.name, rate);
+                BenchmarkRecord record;
+                record.suite = "integrators";
+                record.name = name;
+                record.numbers = {
+                    { "steps", (double)error.steps },
+                    { "path_error_mm", error.path },
+                    { "rest_error_mm", error.rest }
+                };
+                recordBenchmark(record);
+            }
+        }
+    }
+}
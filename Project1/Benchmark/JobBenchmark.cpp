@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "Benchmark.h"
+#include "../Physics/JobSystem.h"
+
+namespace {
+
+// Workers of the stress test's own system, more than one even on one core so that
+// stealing and sleeping get exercised
+const unsigned stressWorkers = 4;
+const int stressRounds = 20;
+
+void report(const char* name, double nanoseconds, const char* unit) {
+    std::printf("%34s %12.0f ns/%s\n", name, nanoseconds, unit);
+
+    BenchmarkRecord record;
+    record.suite = "jobs";
+    record.name = name;
+    record.numbers = { { "ns", nanoseconds } };
+    record.text = { { "per", unit } };
+    recordBenchmark(record);
+}
+
+// Costs of the shared system against a thread per task
+void overheads() {
+    JobSystem& jobs = JobSystem::shared();
+    std::printf("%u workers\n", jobs.workerCount());
+
+    const int batch = 1000;
+    std::vector<JobHandle> handles(batch);
+    double submitted = measureNanoseconds([&]() {
+        for (JobHandle& handle : handles) handle = jobs.submit([]() {});
+        for (JobHandle& handle : handles) jobs.wait(handle);
+    });
+    report("submit and wait, main thread", submitted / batch, "job");
+
+    // A job spawning onto its own deque, with idle workers stealing from it
+    uint64_t stolenBefore = jobs.jobsStolen();
+    double spawned = measureNanoseconds([&]() {
+        jobs.wait(jobs.submit([&jobs]() {
+            std::vector<JobHandle> children(batch);
+            for (JobHandle& child : children) child = jobs.submit([]() {});
+            for (JobHandle& child : children) jobs.wait(child);
+        }));
+    });
+    report("spawn and wait, inside a job", spawned / batch, "job");
+    std::printf("%34s %12llu\n", "stolen so far", (unsigned long long)(jobs.jobsStolen() - stolenBefore));
+
+    double chained = measureNanoseconds([&]() {
+        JobHandle last;
+        for (int i = 0; i < batch; i++) last = jobs.submit([]() {}, { last });
+        jobs.wait(last);
+    });
+    report("dependency chain", chained / batch, "job");
+
+    const size_t count = 1 << 20;
+    std::vector<float> values(count, 1.0f);
+    for (size_t grain : { (size_t)1024, (size_t)16384 }) {
+        double looped = measureNanoseconds([&]() {
+            jobs.parallelFor(count, grain, [&values](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) values[i] = values[i] * 0.5f + 0.5f;
+            });
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "parallelFor, grain %zu", grain);
+        report(name, looped / (count / grain), "chunk");
+    }
+    double serial = measureNanoseconds([&]() {
+        for (size_t i = 0; i < count; i++) values[i] = values[i] * 0.5f + 0.5f;
+    });
+    report("the same loop on one thread", serial / (count / 1024), "1024");
+
+    const int threadTasks = 100;
+    double threads = measureNanoseconds([&]() {
+        for (int i = 0; i < threadTasks; i++) std::thread([]() {}).join();
+    });
+    report("a thread started and joined", threads / threadTasks, "task");
+}
+
+struct StressFailures {
+    int order = 0;
+    int runs = 0;
+    int sums = 0;
+    int affinity = 0;
+};
+
+// Jobs with random dependencies on earlier ones; each must run once, after all of its
+// dependencies
+void randomGraph(JobSystem& jobs, std::mt19937& random, StressFailures& failures) {
+    const int count = 5000;
+    std::vector<JobHandle> handles(count);
+    std::vector<std::vector<int>> dependsOn(count);
+    std::vector<std::atomic<int>> runs(count);
+    std::vector<int> stamps(count, 0);
+    std::atomic<int> clock(0);
+
+    for (int j = 0; j < count; j++) {
+        std::vector<JobHandle> dependencies;
+        for (int d = std::uniform_int_distribution<int>(0, 3)(random); d > 0 && j > 0; d--) {
+            int on = std::uniform_int_distribution<int>(std::max(0, j - 64), j - 1)(random);
+            dependsOn[j].push_back(on);
+            dependencies.push_back(handles[on]);
+        }
+        handles[j] = jobs.submit([&, j]() {
+            runs[j]++;
+            stamps[j] = ++clock;
+            // Dependencies' writes must be visible here
+            for (int on : dependsOn[j]) {
+                if (stamps[on] == 0 || stamps[on] >= stamps[j]) failures.order++;
+            }
+        }, dependencies);
+    }
+    for (JobHandle& handle : handles) jobs.wait(handle);
+
+    for (int j = 0; j < count; j++) {
+        if (runs[j] != 1) failures.runs++;
+    }
+}
+
+// parallelFor inside parallelFor, from jobs and from the main thread
+void nestedLoops(JobSystem& jobs, StressFailures& failures) {
+    const size_t outer = 64, inner = 10000;
+    std::atomic<long long> total(0);
+    jobs.parallelFor(outer, 1, [&](size_t begin, size_t end) {
+        for (size_t o = begin; o < end; o++) {
+            std::atomic<long long> sum(0);
+            jobs.parallelFor(inner, 97, [&sum](size_t first, size_t last) {
+                long long part = 0;
+                for (size_t i = first; i < last; i++) part += (long long)i;
+                sum += part;
+            });
+            total += sum;
+        }
+    });
+    if (total != (long long)outer * (long long)(inner * (inner - 1) / 2)) failures.sums++;
+}
+
+// Threads outside the system submitting at once, while jobs hand work to the main thread
+void concurrentSubmitters(JobSystem& jobs, StressFailures& failures) {
+    const int submitters = 4, perSubmitter = 2000;
+    std::atomic<int> counted(0);
+    std::atomic<int> onMain(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < submitters; t++) {
+        threads.emplace_back([&]() {
+            std::vector<JobHandle> handles;
+            for (int i = 0; i < perSubmitter; i++) handles.push_back(jobs.submit([&counted]() { counted++; }));
+            for (JobHandle& handle : handles) jobs.wait(handle);
+        });
+    }
+
+    std::vector<JobHandle> backs;
+    for (int i = 0; i < 200; i++) {
+        JobHandle work = jobs.submit([]() {});
+        backs.push_back(jobs.submitMain([&]() {
+            if (!jobs.onMainThread()) failures.affinity++;
+            onMain++;
+        }, { work }));
+    }
+    while (onMain < (int)backs.size()) {
+        if (jobs.runMainThreadJobs() == 0) std::this_thread::yield();
+    }
+
+    for (std::thread& thread : threads) thread.join();
+    if (counted != submitters * perSubmitter) failures.runs++;
+}
+
+// Run under -fsanitize=thread as well: any data race in the system shows up here
+bool stress() {
+    StressFailures failures;
+    std::mt19937 random(7);
+    uint64_t stolen = 0, run = 0;
+    for (int round = 0; round < stressRounds; round++) {
+        JobSystem jobs(stressWorkers);
+        randomGraph(jobs, random, failures);
+        nestedLoops(jobs, failures);
+        concurrentSubmitters(jobs, failures);
+        stolen += jobs.jobsStolen();
+        run += jobs.jobsRun();
+    }
+
+    bool passed = failures.order == 0 && failures.runs == 0 && failures.sums == 0 && failures.affinity == 0;
+    std::printf("\nstress, %d rounds on %u workers: %llu jobs, %llu stolen; order %d, runs %d, sums %d, affinity %d: %s\n",
+        stressRounds, stressWorkers, (unsigned long long)run, (unsigned long long)stolen,
+        failures.order, failures.runs, failures.sums, failures.affinity, passed ? "PASS" : "FAIL");
+    return passed;
+}
+
+}
+
+// The job system's spawn, steal and loop costs next to a thread per task, then a stress
+// test of dependencies, nesting, concurrent submitters and main-thread jobs
+void runJobBenchmark() {
+    overheads();
+    if (!stress()) benchmarkFailed = true;
+}
@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Benchmark.h"
+#include "../Physics/BallKernels.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+// The per-object path the SoA kernels replaced: one 3D ball at a time, friction
+// through glm::normalize, and a fresh hole list on every pocket test.
+struct LegacyBall {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float friction;
+    bool pocketed;
+
+    void update(float deltaTime) {
+        position += velocity * deltaTime;
+
+        if (glm::length(velocity) > 0.0f) {
+            glm::vec3 frictionForce = -glm::normalize(velocity) * friction;
+            velocity += frictionForce * deltaTime;
+
+            if (glm::length(velocity) < 0.01f) {
+                velocity = glm::vec3(0.0f);
+            }
+        }
+    }
+
+    void checkHolePocketed() {
+        const std::vector<glm::vec2> holePositions = {
+            glm::vec2(-2.0f, 1.0f), glm::vec2(0.0f, 1.0f), glm::vec2(2.0f, 1.0f),
+            glm::vec2(-2.0f, -1.0f), glm::vec2(0.0f, -1.0f), glm::vec2(2.0f, -1.0f)
+        };
+
+        for (const auto& holePos : holePositions) {
+            float distance = glm::length(glm::vec2(position.x, position.z) - holePos);
+            if (distance < 0.15f) {
+                pocketed = true;
+                position.y = -1.0f;
+                velocity = glm::vec3(0.0f);
+                break;
+            }
+        }
+    }
+};
+
+void makeBalls(size_t count, std::vector<LegacyBall>& legacy, BallStore& store) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> px(-1.8f, 1.8f), pz(-0.8f, 0.8f), speed(-3.0f, 3.0f);
+
+    legacy.clear();
+    store.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        PhysicsBall ball(px(rng), pz(rng), ballRadius, (int)i);
+        ball.velocity = glm::vec2(speed(rng), speed(rng));
+        store.add(ball);
+
+        LegacyBall old = { glm::vec3(ball.position.x, 0.057f, ball.position.y),
+                           glm::vec3(ball.velocity.x, 0.0f, ball.velocity.y), ballFriction, false };
+        legacy.push_back(old);
+    }
+}
+
+// Bit-for-bit equal state of every ball, padding lanes aside
+bool sameBalls(const BallStore& a, const BallStore& b) {
+    if (a.size() != b.size()) return false;
+    size_t bytes = a.size() * sizeof(float);
+    const AlignedVector<float>* arrays[][2] = {
+        { &a.x, &b.x }, { &a.z, &b.z }, { &a.vx, &b.vx }, { &a.vz, &b.vz },
+        { &a.wx, &b.wx }, { &a.wy, &b.wy }, { &a.wz, &b.wz }
+    };
+    for (const auto& pair : arrays) {
+        if (std::memcmp(pair[0]->data(), pair[1]->data(), bytes) != 0) return false;
+    }
+    return std::memcmp(a.flags.data(), b.flags.data(), a.size() * sizeof(uint32_t)) == 0;
+}
+
+bool sameEvents(const std::vector<WorldEvent>& a, const std::vector<WorldEvent>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].type != b[i].type || a[i].ballA != b[i].ballA || a[i].ballB != b[i].ballB) return false;
+    }
+    return true;
+}
+
+const char* kernelNames[] = { "euler", "semi-implicit", "exact", "rk4", "spin" };
+
+// Runs kernel k (an integrator, then MOTION_SPIN) over a few lane blocks of a table
+// of balls, some asleep, next to the scalar code over the same blocks, and checks
+// that the two stay bit-identical and leave the balls outside the blocks alone
+bool kernelMatchesScalar(const World& table, int k) {
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> px(-tableHalfLength, tableHalfLength), pz(-tableHalfWidth, tableHalfWidth);
+    std::uniform_real_distribution<float> speed(-3.0f, 3.0f), spin(-60.0f, 60.0f);
+
+    BallStore start;
+    for (int i = 0; i < 203; i++) {
+        PhysicsBall ball(px(rng), pz(rng), ballRadius, i);
+        ball.velocity = glm::vec2(speed(rng), speed(rng));
+        start.add(ball);
+        start.setSpin(i, glm::vec3(spin(rng), spin(rng), spin(rng)));
+        if (i % 5 == 0) start.setFlags(i, BALL_FLAG_ASLEEP);
+    }
+    const std::vector<BallRange> ranges = { { 8, 16 }, { 32, 64 }, { 120, 128 }, { 200, start.livePaddedSize() } };
+
+    const Integrator integrators[] = { INTEGRATOR_EULER, INTEGRATOR_SEMI_IMPLICIT, INTEGRATOR_EXACT, INTEGRATOR_RK4 };
+
+    BallStore simd = start, scalar = start;
+    std::vector<WorldEvent> simdEvents, scalarEvents;
+    bool same = true;
+    for (int step = 0; step < 240 && same; step++) {
+        bool simdMoving, scalarMoving;
+        if (k == 4) {
+            simdMoving = integrateSpinningBalls(simd, ranges, frameTime);
+            scalarMoving = integrateSpinningBallsScalar(scalar, ranges, frameTime);
+        }
+        else {
+            simdMoving = integrateBalls(simd, ranges, frameTime, integrators[k]);
+            scalarMoving = integrateBallsScalar(scalar, ranges, frameTime, integrators[k]);
+        }
+        capturePocketedBalls(simd, ranges, table.pockets, table.pocketZone, simdEvents);
+        capturePocketedBallsScalar(scalar, ranges, table.pockets, table.pocketZone, scalarEvents);
+        same = simdMoving == scalarMoving && sameBalls(simd, scalar) && sameEvents(simdEvents, scalarEvents);
+    }
+
+    // Lanes outside the blocks are never touched
+    for (size_t i = 0; i < start.size() && same; i++) {
+        bool inRange = false;
+        for (const BallRange& range : ranges) inRange = inRange || (i >= range.begin && i < range.end);
+        if (!inRange) same = simd.x[i] == start.x[i] && simd.vx[i] == start.vx[i] && simd.flags[i] == start.flags[i];
+    }
+
+    return same;
+}
+
+}
+
+void runKernelBenchmark() {
+    const size_t counts[] = { 10, 100, 1000, 10000 };
+
+    World table;
+    setupStandardTable(table);
+    std::vector<WorldEvent> events;
+
+    std::printf("kernel ISA: %s\n", ballKernelIsa());
+    std::printf("%8s %18s %18s %10s\n", "balls", "per-object ns/ball", "SoA ns/ball", "speedup");
+
+    for (size_t count : counts) {
+        std::vector<LegacyBall> legacy;
+        BallStore store;
+        makeBalls(count, legacy, store);
+
+        // Balls never leave the table here; velocities are restored every pass so the
+        // kernels keep doing full work instead of integrating stopped balls.
+        std::vector<LegacyBall> legacyStart = legacy;
+        BallStore storeStart = store;
+
+        double legacyNs = measureNanoseconds([&]() {
+            legacy = legacyStart;
+            for (auto& ball : legacy) {
+                if (ball.pocketed) continue;
+                ball.update(frameTime);
+                ball.checkHolePocketed();
+            }
+        });
+
+        double soaNs = measureNanoseconds([&]() {
+            store = storeStart;
+            events.clear();
+            integrateBalls(store, frameTime);
+            capturePocketedBalls(store, table.pockets, table.pocketZone, events);
+        });
+
+        double copyNs = measureNanoseconds([&]() { legacy = legacyStart; });
+        double storeCopyNs = measureNanoseconds([&]() { store = storeStart; });
+
+        double legacyPerBall = (legacyNs - copyNs) / count;
+        double soaPerBall = (soaNs - storeCopyNs) / count;
+        std::printf("%8zu %18.2f %18.2f %9.1fx\n", count, legacyPerBall, soaPerBall, legacyPerBall / soaPerBall);
+    }
+
+    // The blocks of lanes World passes for its awake balls
+    std::printf("\n%14s %22s\n", "kernel", "partial ranges vs scalar");
+    for (int k = 0; k < 5; k++) {
+        bool same = kernelMatchesScalar(table, k);
+        if (!same) benchmarkFailed = true;
+        std::printf("%14s %22s\n", kernelNames[k], same ? "PASS" : "FAIL");
+    }
+}
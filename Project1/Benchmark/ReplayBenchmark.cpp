@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "Benchmark.h"
+#include "../Physics/NineBallAI.h"
+#include "../Physics/Replay.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+const char* replayPath = "replay_benchmark.bin";
+const int recordedShots = 24;
+const int seeks = 2000;
+
+// Ball state hashed in number order, which unlike World::computeStateHash does not
+// depend on whether pocketed balls have been compacted yet
+uint64_t ballHash(const World& world) {
+    uint64_t hash = 0;
+    for (int number = 0; number <= 9; number++) {
+        int i = world.findBall(number);
+        if (i < 0) continue;
+
+        const float values[] = { world.balls.x[i], world.balls.z[i], world.balls.vx[i], world.balls.vz[i] };
+        uint32_t words[4];
+        std::memcpy(words, values, sizeof(words));
+        hash = hashCombine(hash, world.balls.flags[i]);
+        for (uint32_t word : words) hash = hashCombine(hash, word);
+    }
+    return hash;
+}
+
+// AI-vs-AI shots played like the game, recorded as they go
+void record(ReplayRecorder& recorder) {
+    NineBallAI players[2] = { NineBallAI(AI_EASY, 1), NineBallAI(AI_EASY, 2) };
+
+    World world;
+    NineBallRules rules;
+    setupStandardTable(world);
+    rackNineBall(world);
+    world.deterministic = true;
+    world.fixedPoint = true;
+    recorder.begin(world);
+
+    for (int shot = 0; shot < recordedShots; shot++) {
+        AIDecision move = players[rules.currentPlayer - 1].chooseShot(world, rules);
+
+        rules.beginShot();
+        strikeCueBall(world, move.shot);
+        recorder.beginShot(world, move.shot);
+        do {
+            world.step(frameTime);
+            recorder.recordStep(world);
+            rules.processEvents(world, world.events);
+            world.events.clear();
+        } while (!world.isAtRest());
+        recorder.endShot(world);
+
+        TurnResult result = rules.evaluateTurn(world);
+        if (result.respotCueBall) {
+            int cueBall = world.findBall(cueBallNumber);
+            world.balls.setPosition(cueBall, rules.foulPosition);
+            world.balls.setVelocity(cueBall, glm::vec2(0.0f));
+            world.balls.setPocketed(cueBall, false);
+        }
+        if (result.gameOver) {
+            rules.reset();
+            rackNineBall(world);
+        }
+    }
+}
+
+}
+
+void runReplayBenchmark() {
+    typedef std::chrono::steady_clock Clock;
+
+    ReplayRecorder recorder;
+    record(recorder);
+    size_t bytes = recorder.finish().size();
+
+    ReplayPlayer player;
+    if (!recorder.save(replayPath) || !player.open(replayPath)) {
+        std::printf("could not write and reopen %s\n", replayPath);
+        benchmarkFailed = true;
+        return;
+    }
+
+    // Sequential playback, checking every shot against the hash recorded for it
+    std::vector<uint64_t> hashes(player.stepCount());
+    int shotMismatches = 0;
+    hashes[0] = ballHash(player.world);
+    for (size_t step = 1; step < player.stepCount(); step++) {
+        player.seekStep(step);
+        hashes[step] = ballHash(player.world);
+        if (step == player.currentShotEnd() && player.world.stateHash != player.currentShotHash()) shotMismatches++;
+    }
+
+    // Random seeks in both directions, each compared with sequential playback
+    std::mt19937 random(7);
+    std::uniform_int_distribution<size_t> pick(0, player.stepCount() - 1);
+    double totalSeconds = 0.0, maxSeconds = 0.0;
+    int seekMismatches = 0;
+    for (int seek = 0; seek < seeks; seek++) {
+        size_t target = pick(random);
+        Clock::time_point start = Clock::now();
+        player.seekStep(target);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        totalSeconds += seconds;
+        maxSeconds = std::max(maxSeconds, seconds);
+        seekMismatches += ballHash(player.world) != hashes[target];
+    }
+
+    std::remove(replayPath);
+
+    bool pass = shotMismatches == 0 && seekMismatches == 0;
+    if (!pass) benchmarkFailed = true;
+
+    std::printf("%8s %8s %10s %10s %12s %12s %10s %8s\n",
+        "shots", "steps", "bytes", "B/shot", "seek avg ms", "seek max ms", "mismatch", "result");
+    std::printf("%8zu %8zu %10zu %10.0f %12.3f %12.3f %10d %8s\n",
+        player.shotCount(), player.stepCount(), bytes, (double)bytes / player.shotCount(),
+        totalSeconds * 1e3 / seeks, maxSeconds * 1e3, shotMismatches + seekMismatches, pass ? "ok" : "FAIL");
+}
@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "Benchmark.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/Table.h"
+#include "../Physics/TableGeometry.h"
+
+std::string scenarioDirectory = "Benchmark/scenarios";
+
+namespace {
+
+int nextBallNumber(const World& world) {
+    int number = 0;
+    for (size_t i = 0; i < world.balls.size(); i++) number = std::max(number, world.balls.number[i] + 1);
+    return number;
+}
+
+}
+
+// A rectangle of four cushions around the origin, without pockets
+void setupBox(World& world, float length, float width) {
+    glm::vec2 lo(-length * 0.5f, -width * 0.5f);
+    glm::vec2 hi(length * 0.5f, width * 0.5f);
+    world.edges.clear();
+    world.pockets.clear();
+    world.pocketZone = PocketZone();
+    world.boundary.reset();
+    world.cushionModel = CUSHION_SEGMENTS;
+    world.edges.push_back(Edge(lo, glm::vec2(hi.x, lo.y), glm::vec2(0.0f, 1.0f), cushionWidth));
+    world.edges.push_back(Edge(glm::vec2(lo.x, hi.y), hi, glm::vec2(0.0f, -1.0f), cushionWidth));
+    world.edges.push_back(Edge(lo, glm::vec2(lo.x, hi.y), glm::vec2(1.0f, 0.0f), cushionWidth));
+    world.edges.push_back(Edge(glm::vec2(hi.x, lo.y), hi, glm::vec2(-1.0f, 0.0f), cushionWidth));
+}
+
+// Balls touching in a hexagonal patch around centre, nearest first
+void addCluster(World& world, int count, glm::vec2 centre) {
+    float spacing = 2.0f * ballRadius + 1e-4f;
+    int rings = (int)std::ceil(std::sqrt((double)count)) + 1;
+
+    std::vector<glm::vec2> points;
+    for (int row = -rings; row <= rings; row++) {
+        for (int column = -rings; column <= rings; column++) {
+            points.push_back(glm::vec2((column + 0.5f * (row & 1)) * spacing, row * spacing * 0.8660254f));
+        }
+    }
+    std::stable_sort(points.begin(), points.end(), [](glm::vec2 a, glm::vec2 b) {
+        return glm::dot(a, a) < glm::dot(b, b);
+    });
+
+    int number = nextBallNumber(world);
+    for (int i = 0; i < count && i < (int)points.size(); i++) {
+        glm::vec2 p = centre + points[i];
+        world.balls.add(PhysicsBall(p.x, p.y, ballRadius, number++));
+    }
+}
+
+namespace {
+
+// Whole runs are repeated until they add up to this long
+const double minRunSeconds = 0.5;
+
+struct Scenario {
+    std::string name;
+    World world;
+    // Steps per run, at most; a run also ends once every ball is at rest
+    int steps = 1200;
+};
+
+// Half the size of the playing area, for scatter
+struct ScenarioArea {
+    glm::vec2 half = glm::vec2(tableHalfLength, tableHalfWidth);
+};
+
+// count balls on a jittered lattice over the area, every count/moving-th one rolling
+// at speed in a random direction
+bool addScatter(World& world, const ScenarioArea& area, int count, int moving, float speed, unsigned seed) {
+    float spacing = 2.5f * ballRadius;
+    int columns = (int)((2.0f * area.half.x - 2.0f * ballRadius) / spacing);
+    int rows = (int)((2.0f * area.half.y - 2.0f * ballRadius) / spacing);
+    if (columns * rows < count) return false;
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> jitter(-0.2f * ballRadius, 0.2f * ballRadius);
+    std::uniform_real_distribution<float> direction(0.0f, 6.2831853f);
+
+    glm::vec2 origin = -area.half + glm::vec2(ballRadius + 0.5f * spacing);
+    int number = nextBallNumber(world);
+    for (int i = 0; i < count; i++) {
+        glm::vec2 p = origin + glm::vec2((i % columns) * spacing, (i / columns) * spacing);
+        PhysicsBall ball(p.x + jitter(random), p.y + jitter(random), ballRadius, number++);
+        if (moving > 0 && (long long)i * moving % count < moving) {
+            float angle = direction(random);
+            ball.velocity = glm::vec2(std::cos(angle), std::sin(angle)) * speed;
+        }
+        world.balls.add(ball);
+    }
+    return true;
+}
+
+// Scenario files hold one setting per line; '#' starts a comment. Table files are
+// relative to the scenario file.
+//
+//   table <file>                    a table file, e.g. ../../tables/standard.table
+//   box <length> <width>            four cushions without pockets instead
+//   rack                            the game's nine-ball rack, cue ball included
+//   ball <x> <z> [<vx> <vz>]        one ball, numbered after the others
+//   cluster <count> <x> <z>         balls touching in a hexagonal patch
+//   scatter <count> <moving> <speed> <seed>
+//                                   balls spread over the playing area
+//   strike <angle> <power> [<side> <height>]
+//                                   strikes the cue ball (number 0) as the game does,
+//                                   the tip off centre by side and height in radii
+//   motion rolling|spin             the ball motion model; spin before a strike that
+//                                   needs it
+//   broadphase sweep|grid|brute
+//   contacts swept|discrete|islands
+//   steps <count>                   steps per run, at most
+bool loadScenario(const std::filesystem::path& path, Scenario& scenario, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path.string();
+        return false;
+    }
+
+    scenario.name = path.stem().string();
+    World& world = scenario.world;
+    setupStandardTable(world);
+    world.deterministic = true;
+    ScenarioArea area;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string key;
+        if (!(words >> key)) continue;
+
+        bool ok = true;
+        if (key == "table") {
+            std::string file;
+            TableGeometry table;
+            ok = (bool)(words >> file);
+            if (ok && !loadTableGeometry((path.parent_path() / file).string(), table, error)) return false;
+            if (ok) {
+                applyTableGeometry(world, table);
+                area.half = glm::vec2(table.halfLength, table.halfWidth);
+            }
+        }
+        else if (key == "box") {
+            float length, width;
+            ok = (bool)(words >> length >> width);
+            if (ok) {
+                setupBox(world, length, width);
+                area.half = glm::vec2(length, width) * 0.5f;
+            }
+        }
+        else if (key == "rack") {
+            rackNineBall(world);
+        }
+        else if (key == "ball") {
+            float x, z, vx = 0.0f, vz = 0.0f;
+            ok = (bool)(words >> x >> z);
+            if (ok && (words >> vx)) ok = (bool)(words >> vz);
+            if (ok) {
+                PhysicsBall ball(x, z, ballRadius, nextBallNumber(world));
+                ball.velocity = glm::vec2(vx, vz);
+                world.balls.add(ball);
+            }
+        }
+        else if (key == "cluster") {
+            int count;
+            float x, z;
+            ok = (bool)(words >> count >> x >> z);
+            if (ok) addCluster(world, count, glm::vec2(x, z));
+        }
+        else if (key == "scatter") {
+            int count, moving;
+            float speed;
+            unsigned seed;
+            ok = (bool)(words >> count >> moving >> speed >> seed);
+            if (ok && !addScatter(world, area, count, moving, speed, seed)) {
+                error = path.string() + ":" + std::to_string(lineNumber) + ": " + std::to_string(count) + " balls do not fit";
+                return false;
+            }
+        }
+        else if (key == "strike") {
+            ShotCandidate shot;
+            ok = (bool)(words >> shot.angle >> shot.power);
+            if (ok && (words >> shot.tipOffset.x)) ok = (bool)(words >> shot.tipOffset.y);
+            if (ok) strikeCueBall(world, shot);
+        }
+        else if (key == "motion") {
+            std::string type;
+            ok = (bool)(words >> type) && (type == "rolling" || type == "spin");
+            if (ok) world.motionModel = type == "spin" ? MOTION_SPIN : MOTION_ROLLING;
+        }
+        else if (key == "broadphase") {
+            std::string type;
+            ok = (bool)(words >> type) && (type == "sweep" || type == "grid" || type == "brute");
+            if (ok) {
+                world.broadPhase.type = type == "grid" ? BROAD_PHASE_GRID :
+                    type == "brute" ? BROAD_PHASE_BRUTE_FORCE : BROAD_PHASE_SWEEP_AND_PRUNE;
+            }
+        }
+        else if (key == "contacts") {
+            std::string type;
+            ok = (bool)(words >> type) && (type == "swept" || type == "discrete" || type == "islands");
+            if (ok) {
+                world.continuousCollision = type == "swept";
+                world.contactModel = type == "islands" ? CONTACTS_ISLANDS : CONTACTS_PAIRWISE;
+            }
+        }
+        else if (key == "steps") {
+            ok = (bool)(words >> scenario.steps) && scenario.steps > 0;
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = path.string() + ":" + std::to_string(lineNumber) + ": bad line '" + line + "'";
+            return false;
+        }
+    }
+
+    if (world.balls.empty()) {
+        error = path.string() + ": a scenario needs balls";
+        return false;
+    }
+    return true;
+}
+
+struct ScenarioResult {
+    int runs = 0;
+    size_t steps = 0;
+    double nanoseconds = 0.0;
+    size_t pairsTested = 0;
+    size_t candidatePairs = 0;
+    size_t contacts = 0;
+    size_t memoryBytes = 0;
+    uint64_t history = 0;
+    int stepsPerRun = 0;
+};
+
+ScenarioResult runScenario(const Scenario& scenario) {
+    typedef std::chrono::steady_clock Clock;
+    ScenarioResult result;
+    World world;
+    do {
+        world = scenario.world;
+        world.historyHash = 0;
+
+        int steps = 0;
+        while (steps < scenario.steps) {
+            Clock::time_point start = Clock::now();
+            world.step(frameTime);
+            result.nanoseconds += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            steps++;
+
+            result.pairsTested += world.stats.pairsTested;
+            result.candidatePairs += world.stats.candidatePairs;
+            result.contacts += world.stats.contacts;
+            result.memoryBytes = std::max(result.memoryBytes, world.memoryBytes());
+            world.events.clear();
+            if (world.isAtRest()) break;
+        }
+
+        result.steps += steps;
+        result.stepsPerRun = steps;
+        result.history = world.historyHash;
+        result.runs++;
+    } while (result.nanoseconds < minRunSeconds * 1e9);
+    return result;
+}
+
+}
+
+// Every scenario file in the scenario directory, stepped from its start until at rest or
+// its step limit. Counts are per step; the history hash tells whether a build still
+// plays the scenario the same way.
+void runScenarioBenchmark() {
+    // Run from Project1 as on Linux, or from the Benchmark project directory as Visual
+    // Studio does
+    std::string directory = scenarioDirectory;
+    std::error_code code;
+    if (!std::filesystem::is_directory(directory, code) && std::filesystem::is_directory("scenarios", code)) {
+        directory = "scenarios";
+    }
+
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, code)) {
+        if (entry.path().extension() == ".scenario") paths.push_back(entry.path());
+    }
+    if (code || paths.empty()) {
+        std::printf("  no scenarios in %s\n", directory.c_str());
+        benchmarkFailed = true;
+        return;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::printf("%14s %7s %6s %10s %10s %10s %10s %9s %9s %17s\n", "scenario", "balls", "steps",
+        "ns/step", "steps/s", "tested", "candidates", "contacts", "KiB", "history");
+
+    for (const std::filesystem::path& path : paths) {
+        Scenario scenario;
+        std::string error;
+        if (!loadScenario(path, scenario, error)) {
+            std::printf("  %s\n", error.c_str());
+            benchmarkFailed = true;
+            continue;
+        }
+
+        ScenarioResult result = runScenario(scenario);
+        double steps = (double)result.steps;
+        double nsPerStep = result.nanoseconds / steps;
+        char history[17];
+        std::snprintf(history, sizeof(history), "%016llx", (unsigned long long)result.history);
+
+        std::printf("%14s %7zu %6d %10.0f %10.0f %10.1f %10.1f %9.2f %9.1f %17s\n", scenario.name.c_str(),
+            scenario.world.balls.size(), result.stepsPerRun, nsPerStep, 1e9 / nsPerStep,
+            result.pairsTested / steps, result.candidatePairs / steps, result.contacts / steps,
+            result.memoryBytes / 1024.0, history);
+
+        BenchmarkRecord record;
+        record.suite = "scenarios";
+        record.name = scenario.name;
+        record.numbers = {
+            { "balls", (double)scenario.world.balls.size() },
+            { "steps", (double)result.stepsPerRun },
+            { "runs", (double)result.runs },
+            { "ns_per_step", nsPerStep },
+            { "steps_per_second", 1e9 / nsPerStep },
+            { "pairs_tested_per_step", result.pairsTested / steps },
+            { "candidate_pairs_per_step", result.candidatePairs / steps },
+            { "contacts_per_step", result.contacts / steps },
+            { "memory_bytes", (double)result.memoryBytes }
+        };
+        record.text = { { "history", history } };
+        recordBenchmark(record);
+    }
+}
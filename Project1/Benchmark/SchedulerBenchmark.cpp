@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/StepScheduler.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+const int framesPerRun = 1200;
+
+// A machine modelled by what a frame costs: rendering plus a fixed cost per physics
+// step, and an occasional hitch. Each frame's elapsed time is the cost of the last one.
+struct Machine {
+    const char* name;
+    double renderTime;
+    double stepCost;
+    int hitchEvery;     // frames, 0 for never
+    double hitchTime;
+};
+
+struct RunResult {
+    int mostSteps = 0;
+    double lastFrameTime = 0.0;
+    SchedulerMetrics total;
+};
+
+// Breaks shot after shot, stepping as the scheduler says. maxSteps 0 stands for the
+// old open-ended catch-up loop.
+RunResult runFrames(const Machine& machine, int maxSteps) {
+    World world;
+    setupStandardTable(world);
+    rackNineBall(world);
+    world.deterministic = true;
+
+    StepScheduler scheduler;
+    scheduler.maxStepsPerFrame = maxSteps > 0 ? maxSteps : 1 << 30;
+    scheduler.maxFrameTime = maxSteps > 0 ? scheduler.maxFrameTime : 1e30;
+
+    RunResult result;
+    double elapsed = machine.renderTime;
+    int shot = 0;
+    for (int f = 0; f < framesPerRun; f++) {
+        if (world.isAtRest()) {
+            rackNineBall(world);
+            strikeCueBall(world, { 1.5708f + 0.1f * (shot++ % 7), 10.0f });
+        }
+
+        scheduler.advance(world, elapsed, [&world](float deltaTime) {
+            world.step(deltaTime);
+            world.events.clear();
+        });
+
+        elapsed = machine.renderTime + scheduler.frame.worldSteps * machine.stepCost;
+        if (machine.hitchEvery > 0 && f % machine.hitchEvery == machine.hitchEvery - 1) {
+            elapsed += machine.hitchTime;
+        }
+        result.lastFrameTime = elapsed;
+
+        // A minute-long frame has spiralled; the rest of the run would only take longer
+        if (elapsed > 60.0) break;
+    }
+
+    result.mostSteps = scheduler.mostStepsPerFrame;
+    result.total = scheduler.total;
+    return result;
+}
+
+}
+
+// Frame loops on modelled machines, with the old unbounded catch-up and with the
+// scheduler's cap. On a machine whose steps cost more than they simulate, the old loop
+// runs ever more steps per frame; the capped one stays bounded and drops time instead.
+void runSchedulerBenchmark() {
+    const Machine machines[] = {
+        { "steady", 0.004, 0.00005, 0, 0.0 },
+        { "hitches", 0.004, 0.00005, 240, 1.0 },
+        { "slow steps", 0.004, 0.012, 0, 0.0 }
+    };
+
+    std::printf("%12s %10s %10s %10s %10s %12s %14s\n",
+        "machine", "cap", "steps", "resting", "max/frame", "dropped s", "last frame ms");
+
+    for (const Machine& machine : machines) {
+        for (int cap = 0; cap < 2; cap++) {
+            RunResult result = runFrames(machine, cap ? StepScheduler().maxStepsPerFrame : 0);
+            std::printf("%12s %10s %10d %10d %10d %12.2f %14.1f\n",
+                machine.name, cap ? "capped" : "none", result.total.steps, result.total.restingSteps,
+                result.mostSteps, result.total.droppedTime, result.lastFrameTime * 1000.0);
+
+            if (cap && result.mostSteps > StepScheduler().maxStepsPerFrame) {
+                std::printf("  the cap was exceeded\n");
+                benchmarkFailed = true;
+            }
+        }
+    }
+}
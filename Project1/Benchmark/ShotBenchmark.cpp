@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "Benchmark.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+bool sameOutcome(const ShotOutcome& l, const ShotOutcome& r) {
+    return l.firstBallHit == r.firstBallHit && l.ballsPocketed == r.ballsPocketed &&
+        l.foul == r.foul && l.keepsTurn == r.keepsTurn && l.gameOver == r.gameOver &&
+        l.cueBallPosition == r.cueBallPosition && l.steps == r.steps;
+}
+
+}
+
+void runShotBenchmark() {
+    World world;
+    setupStandardTable(world);
+    rackNineBall(world);
+    NineBallRules rules;
+
+    // A fan of break shots around the rack at every cue power the game offers
+    std::vector<ShotCandidate> shots;
+    for (int a = 0; a < 200; a++) {
+        for (int p = 1; p <= 5; p++) {
+            shots.push_back({ 1.5708f + (a - 100) * 0.004f, 2.0f * p });
+        }
+    }
+
+    unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts = { 1 };
+    for (unsigned t = 2; t < hardware; t *= 2) threadCounts.push_back(t);
+    if (hardware > 1) threadCounts.push_back(hardware);
+
+    std::vector<ShotOutcome> reference;
+    ShotEvaluator serial;
+    serial.threadCount = 1;
+    serial.evaluate(world, rules, shots, reference);
+
+    size_t fouls = 0, pots = 0, steps = 0;
+    for (const ShotOutcome& outcome : reference) {
+        fouls += outcome.foul;
+        pots += outcome.ballsPocketed.size();
+        steps += outcome.steps;
+    }
+    std::printf("%zu shots, %.1f steps/shot, %zu fouls, %zu balls pocketed\n",
+        shots.size(), (double)steps / shots.size(), fouls, pots);
+
+    std::printf("%8s %14s %10s %10s\n", "threads", "shots/s", "speedup", "identical");
+
+    double serialNs = 0.0;
+    for (unsigned threads : threadCounts) {
+        ShotEvaluator evaluator;
+        evaluator.threadCount = threads;
+
+        std::vector<ShotOutcome> outcomes;
+        double ns = measureNanoseconds([&]() {
+            evaluator.evaluate(world, rules, shots, outcomes);
+        }, 1.0);
+        if (threads == 1) serialNs = ns;
+
+        bool identical = outcomes.size() == reference.size();
+        for (size_t i = 0; identical && i < outcomes.size(); i++) {
+            identical = sameOutcome(outcomes[i], reference[i]);
+        }
+
+        if (!identical) benchmarkFailed = true;
+        std::printf("%8u %14.0f %10.2f %10s\n", threads, shots.size() * 1e9 / ns, serialNs / ns, identical ? "yes" : "NO");
+    }
+}
@@ -0,0 +1,156 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/Table.h"
+#include "../Physics/World.h"
+
+namespace {
+
+// A lattice of resting balls inside four cushions with a few balls rolling through
+// it. One step is taken up front so the resting balls are already asleep.
+void makeRestingWorld(World& world, size_t count, size_t moving) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    size_t side = (size_t)std::ceil(std::sqrt((double)count));
+    float spacing = 3.0f * ballRadius;
+
+    world.balls.clear();
+    world.edges.clear();
+    world.pockets.clear();
+
+    for (size_t i = 0; i < count; i++) {
+        PhysicsBall ball((i % side) * spacing, (i / side) * spacing, ballRadius, (int)i);
+        if (i < moving) {
+            float a = angle(rng);
+            ball.velocity = glm::vec2(std::cos(a), std::sin(a)) * 3.0f;
+        }
+        world.balls.add(ball);
+    }
+
+    float lo = -spacing;
+    float hi = side * spacing;
+    const float wall = 0.125f;
+    world.edges.push_back(Edge(glm::vec2(lo, lo), glm::vec2(hi, lo), glm::vec2(0.0f, 1.0f), wall));
+    world.edges.push_back(Edge(glm::vec2(lo, hi), glm::vec2(hi, hi), glm::vec2(0.0f, -1.0f), wall));
+    world.edges.push_back(Edge(glm::vec2(lo, lo), glm::vec2(lo, hi), glm::vec2(1.0f, 0.0f), wall));
+    world.edges.push_back(Edge(glm::vec2(hi, lo), glm::vec2(hi, hi), glm::vec2(-1.0f, 0.0f), wall));
+
+    world.step(frameTime);
+    world.events.clear();
+}
+
+const int stepsPerRun = 120;
+
+// Between shots, with every ball asleep: one is nudged by hand and another struck, so
+// both come back through BallStore's change log rather than a scan
+void nextShot(World& world, int shot) {
+    size_t last = world.balls.liveSize();
+    if (last < 2) return;
+    world.balls.setPosition(last - 2, world.balls.position(last - 2) + glm::vec2(0.01f, 0.0f));
+    float angle = 1.0f + shot;
+    world.balls.setVelocity(last - 1, glm::vec2(std::cos(angle), std::sin(angle)) * 4.0f);
+}
+
+// Plays world out in deterministic mode over three shots and returns its history
+// hash. With rescan, the balls get a new layout before every step, so the awake list,
+// the kernels' lane blocks and the broad phase are all rebuilt from a scan instead
+// of carried over.
+uint64_t playOut(World world, bool rescan, size_t& steps) {
+    world.deterministic = true;
+    steps = 0;
+    for (int shot = 0; shot < 3; shot++) {
+        if (shot > 0) nextShot(world, shot);
+        size_t shotSteps = 0;
+        do {
+            if (rescan) world.balls.newLayout();
+            world.step(frameTime);
+            world.events.clear();
+            shotSteps++;
+        } while (!world.isAtRest() && shotSteps < 1200);
+        steps += shotSteps;
+    }
+    return world.historyHash;
+}
+
+struct CrossCheck {
+    const char* name;
+    World world;
+};
+
+// Sleeping balls carried from step to step must give exactly what scanning for them
+// every step gives
+void checkAgainstRescan() {
+    std::vector<CrossCheck> cases;
+    const BroadPhaseType types[] = { BROAD_PHASE_BRUTE_FORCE, BROAD_PHASE_GRID, BROAD_PHASE_SWEEP_AND_PRUNE };
+    const char* lattices[] = { "lattice, brute force", "lattice, grid", "lattice, sweep" };
+    for (int t = 0; t < 3; t++) {
+        CrossCheck lattice = { lattices[t], World() };
+        makeRestingWorld(lattice.world, 1000, 8);
+        lattice.world.broadPhase.type = types[t];
+        cases.push_back(lattice);
+    }
+
+    const char* breaks[] = { "break, swept", "break, discrete", "break, islands", "break, spin" };
+    for (int b = 0; b < 4; b++) {
+        CrossCheck shot = { breaks[b], World() };
+        setupStandardTable(shot.world);
+        rackNineBall(shot.world);
+        shot.world.continuousCollision = b != 1;
+        if (b == 2) shot.world.contactModel = CONTACTS_ISLANDS;
+        if (b == 3) shot.world.motionModel = MOTION_SPIN;
+        strikeCueBall(shot.world, { 1.5708f, 10.0f });
+        cases.push_back(shot);
+    }
+
+    std::printf("\n%22s %8s %18s %18s %8s\n", "against rescan", "steps", "kept", "rescanned", "result");
+    for (const CrossCheck& check : cases) {
+        size_t steps = 0, rescanSteps = 0;
+        uint64_t kept = playOut(check.world, false, steps);
+        uint64_t rescanned = playOut(check.world, true, rescanSteps);
+        bool pass = kept == rescanned && steps == rescanSteps;
+        if (!pass) benchmarkFailed = true;
+        std::printf("%22s %8zu %18llx %18llx %8s\n", check.name, steps, (unsigned long long)kept,
+            (unsigned long long)rescanned, pass ? "PASS" : "FAIL");
+    }
+}
+
+}
+
+void runSleepBenchmark() {
+    const size_t counts[] = { 100, 1000, 10000 };
+    const size_t movingCounts[] = { 1, 8, 64 };
+
+    std::printf("%8s %8s %14s %10s %10s %10s\n", "balls", "moving", "ns/step", "awake", "asleep", "contacts");
+
+    for (size_t count : counts) {
+        for (size_t moving : movingCounts) {
+            World start;
+            makeRestingWorld(start, count, moving);
+            start.broadPhase.type = BROAD_PHASE_GRID;
+
+            World world;
+            size_t awake = 0, asleep = 0, contacts = 0, steps = 0;
+            double ns = measureNanoseconds([&]() {
+                world = start;
+                for (int i = 0; i < stepsPerRun; i++) {
+                    world.step(frameTime);
+                    world.events.clear();
+                    awake += world.stats.awakeBalls;
+                    asleep += world.stats.asleepBalls;
+                    contacts += world.stats.contacts;
+                    steps++;
+                }
+            }) / stepsPerRun;
+
+            std::printf("%8zu %8zu %14.0f %10.1f %10.1f %10.2f\n", count, moving, ns,
+                (double)awake / steps, (double)asleep / steps, (double)contacts / steps);
+        }
+    }
+
+    checkAgainstRescan();
+}
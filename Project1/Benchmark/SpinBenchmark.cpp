@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "../Physics/BallKernels.h"
+#include "../Physics/ShotEvaluator.h"
+
+namespace {
+
+const int stepRates[] = { 240, 120, 60, 30 };
+
+// Straight-in shots on an open plane: the cue ball along +x into an object ball
+const float shotSpeed = 3.0f;
+const float shotDistance = 0.6f;
+const float halfPi = 1.5707963f;
+
+bool checked(bool passed, bool& all) {
+    all = all && passed;
+    return passed;
+}
+
+void record(const char* name, std::vector<std::pair<std::string, double>> numbers) {
+    BenchmarkRecord entry;
+    entry.suite = "spin";
+    entry.name = name;
+    entry.numbers = numbers;
+    recordBenchmark(entry);
+}
+
+// A ball without spin slides until its slip is gone, 2/7 of the way to a stop, then
+// rolls at 5/7 of its speed
+double slideTime(double speed) {
+    return 2.0 * speed / (7.0 * ballSlidingFriction * (double)gravity);
+}
+
+double restDistance(double speed) {
+    double slide = ballSlidingFriction * (double)gravity;
+    double rollStart = slideTime(speed);
+    double rollSpeed = speed - slide * rollStart;
+    return speed * rollStart - 0.5 * slide * rollStart * rollStart + rollSpeed * rollSpeed / (2.0 * ballFriction);
+}
+
+// A centre-ball hit, on its own. The steps solve both phase changes in closed form, so
+// where it stops should not depend on the step length.
+bool phaseChanges() {
+    const float speed = 4.0f;
+    double rollStart = slideTime(speed);
+    double rollSpeed = speed - ballSlidingFriction * (double)gravity * rollStart;
+    double rolling = ballFriction;
+    double stopTime = rollStart + rollSpeed / rolling;
+    double distance = restDistance(speed);
+
+    std::printf("%5s %14s %14s %14s\n", "rate", "roll speed", "rest mm", "stop ms");
+    bool passed = true;
+    for (int rate : stepRates) {
+        float stepTime = 1.0f / rate;
+        World world;
+        world.motionModel = MOTION_SPIN;
+        world.balls.add(PhysicsBall(0.0f, 0.0f, ballRadius, cueBallNumber));
+        strikeCueBall(world, { halfPi, speed });
+
+        // Speed on the first step that starts rolling
+        double speedRolling = 0.0;
+        int steps = 0;
+        do {
+            world.step(stepTime);
+            steps++;
+            glm::vec3 spin = world.balls.spin(0);
+            if (speedRolling == 0.0 && std::abs(world.balls.vx[0] + ballRadius * spin.z) < 1e-3f) {
+                double t = steps * (double)stepTime;
+                speedRolling = world.balls.vx[0] + rolling * (t - rollStart);
+            }
+        } while (!world.isAtRest() && steps < 100000);
+
+        double rest = std::abs(world.balls.x[0] - distance) * 1e3;
+        double late = (steps * (double)stepTime - stopTime) * 1e3;
+        bool ok = checked(std::abs(speedRolling - rollSpeed) < 1e-3 && rest < 1.0 && late >= 0.0 && late <= stepTime * 1e3 + 1e-3, passed);
+        std::printf("%5d %14.4f %14.4f %14.2f%s\n", rate, speedRolling, rest, late, ok ? "" : "  FAIL");
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "phases %d", rate);
+        record(name, { { "roll_speed", speedRolling }, { "rest_error_mm", rest }, { "stop_late_ms", late } });
+    }
+    std::printf("  expected roll speed %.4f m/s at %.1f ms, rest %.4f m\n", rollSpeed, rollStart * 1e3, distance);
+    return passed;
+}
+
+struct ShotResult {
+    // Cue ball travel past the point where it met the object ball (back is negative),
+    // and the object ball's travel, in metres
+    float cueAfter;
+    float objectAfter;
+    int steps;
+};
+
+ShotResult straightShot(float tipHeight, float stepTime) {
+    World world;
+    world.motionModel = MOTION_SPIN;
+    world.balls.add(PhysicsBall(-shotDistance, 0.0f, ballRadius, cueBallNumber));
+    world.balls.add(PhysicsBall(0.0f, 0.0f, ballRadius, 1));
+    ShotCandidate shot = { halfPi, shotSpeed };
+    shot.tipOffset = glm::vec2(0.0f, tipHeight);
+    strikeCueBall(world, shot);
+
+    ShotResult result = {};
+    do {
+        world.step(stepTime);
+        world.events.clear();
+        result.steps++;
+    } while (!world.isAtRest() && result.steps < 100000);
+
+    result.cueAfter = world.balls.x[world.findBall(cueBallNumber)] + 2.0f * ballRadius;
+    result.objectAfter = world.balls.x[world.findBall(1)];
+    return result;
+}
+
+// Stun leaves the cue ball close to where it hit, follow sends it on after the object
+// ball and draw brings it back. Stun is the tip below centre whose backspin has just
+// worn off when the balls meet: the slide takes the spin from 5/2 h v0 / r to zero in
+// -h v0 / (f g), over the gap to the object ball. With no spin left, the cue ball keeps
+// only the (1 - e) / 2 of its speed the collision leaves it and slides on from there.
+bool stunFollowDraw() {
+    double slide = ballSlidingFriction * (double)gravity;
+    double gap = shotDistance - 2.0 * ballRadius;
+    double contactTime = (shotSpeed - std::sqrt(shotSpeed * shotSpeed - 2.0 * slide * gap)) / slide;
+    float stun = (float)(-slide * contactTime / shotSpeed);
+    double stunAfter = restDistance((shotSpeed - slide * contactTime) * (1.0 - ballRestitution) * 0.5);
+
+    struct Case {
+        const char* name;
+        float tip;
+    };
+    const Case cases[] = { { "stun", stun }, { "centre", 0.0f }, { "follow", 0.4f }, { "draw", -0.4f } };
+
+    std::printf("\n%8s %7s %5s %14s %14s %7s\n", "shot", "tip", "rate", "cue after m", "object m", "steps");
+    bool passed = true;
+    for (const Case& entry : cases) {
+        for (int rate : { 120, 30 }) {
+            ShotResult result = straightShot(entry.tip, 1.0f / rate);
+            // Contacts are found at the end of a step, so the coarse steps meet a little late
+            bool ok = true;
+            if (entry.tip == stun) ok = std::abs(result.cueAfter - stunAfter) < 0.02;
+            else if (entry.tip > 0.0f) ok = result.cueAfter > 0.2f;
+            else if (entry.tip < 0.0f) ok = result.cueAfter < -0.2f;
+            checked(ok, passed);
+            std::printf("%8s %7.3f %5d %14.4f %14.4f %7d%s\n", entry.name, entry.tip, rate, result.cueAfter,
+                result.objectAfter, result.steps, ok ? "" : "  FAIL");
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "%s %d", entry.name, rate);
+            record(name, { { "tip", entry.tip }, { "cue_after_m", result.cueAfter },
+                { "object_after_m", result.objectAfter }, { "steps", (double)result.steps } });
+        }
+    }
+    std::printf("  stun tip %.3f leaves the cue ball %.4f m on\n", stun, stunAfter);
+    return passed;
+}
+
+// A ball sent straight into a cushion comes off to the side of its english: right
+// english (seen from behind) to the right
+bool englishOffCushion() {
+    std::printf("\n%8s %16s\n", "english", "sideways m/s");
+    bool passed = true;
+    for (float side : { -0.4f, 0.0f, 0.4f }) {
+        World world;
+        world.motionModel = MOTION_SPIN;
+        setupBox(world, 2.0f, 2.0f);
+        world.balls.add(PhysicsBall(0.0f, 0.0f, ballRadius, cueBallNumber));
+        ShotCandidate shot = { halfPi, shotSpeed };
+        shot.tipOffset = glm::vec2(side, 0.0f);
+        strikeCueBall(world, shot);
+
+        // Heading +x, the shooter's right is +z
+        float sideways = 0.0f;
+        for (int step = 0; step < 1000; step++) {
+            world.step(frameTime);
+            if (world.balls.vx[0] < 0.0f) {
+                sideways = world.balls.vz[0];
+                break;
+            }
+        }
+
+        bool ok = side > 0.0f ? sideways > 0.05f : side < 0.0f ? sideways < -0.05f : std::abs(sideways) < 1e-4f;
+        checked(ok, passed);
+        std::printf("%8.1f %16.4f%s\n", side, sideways, ok ? "" : "  FAIL");
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "english %.1f", side);
+        record(name, { { "sideways_mps", sideways } });
+    }
+    return passed;
+}
+
+// Cost of a step of sliding and rolling balls, next to the rolling-only exact step
+void cost() {
+    const int count = 4096;
+    BallStore balls;
+    for (int i = 0; i < count; i++) balls.add(PhysicsBall((float)(i % 64), (float)(i / 64), ballRadius, i));
+    auto restart = [&]() {
+        for (int i = 0; i < count; i++) {
+            balls.setVelocity(i, glm::vec2(3.0f, 1.0f + (i % 7) * 0.1f));
+            balls.setSpin(i, glm::vec3(0.0f, (i % 3) * 10.0f, (i % 5) * -10.0f));
+        }
+    };
+
+    restart();
+    double spinning = measureNanoseconds([&]() {
+        if (balls.vx[0] < 0.5f) restart();
+        integrateSpinningBalls(balls, frameTime);
+    }, 0.05) / count;
+    restart();
+    double rolling = measureNanoseconds([&]() {
+        if (balls.vx[0] < 0.5f) restart();
+        integrateBalls(balls, frameTime, INTEGRATOR_EXACT);
+    }, 0.05) / count;
+
+    std::printf("\n%s kernels: spin %.2f ns/ball, rolling only (exact) %.2f ns/ball\n", ballKernelIsa(), spinning, rolling);
+    record("cost", { { "spin_ns_per_ball", spinning }, { "exact_ns_per_ball", rolling } });
+}
+
+}
+
+// Checks the MOTION_SPIN model: sliding-to-rolling and stop times against the closed
+// form at each step length, stun, follow and draw, and english off a cushion; then
+// the kernel's cost
+void runSpinBenchmark() {
+    bool passed = phaseChanges();
+    passed = stunFollowDraw() && passed;
+    passed = englishOffCushion() && passed;
+    cost();
+
+    std::printf("%s\n", passed ? "PASS" : "FAIL");
+    if (!passed) benchmarkFailed = true;
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+#include "Benchmark.h"
+#include "../Physics/PhysicsThread.h"
+#include "../Physics/ShotEvaluator.h"
+#include "../Physics/Table.h"
+
+namespace {
+
+const double runSeconds = 2.0;
+// A render loop that redraws about this often
+const double frameSeconds = 1.0 / 240.0;
+// Strikes again after this many snapshots, at rest or not
+const int snapshotsPerShot = 30;
+
+struct ReaderResult {
+    int frames = 0;
+    int snapshots = 0;
+    int strikes = 0;
+    int outOfOrder = 0;
+    int broken = 0;
+    double age = 0.0;
+    double worstAge = 0.0;
+    double worstWait = 0.0;
+};
+
+// A snapshot is whole if every ball on the table is somewhere on the table
+bool wholeSnapshot(const SimulationSnapshot& snapshot) {
+    if (snapshot.positions.size() != snapshot.present.size() || snapshot.previous.size() != snapshot.positions.size()) {
+        return false;
+    }
+    for (size_t number = 0; number < snapshot.positions.size(); number++) {
+        if (!snapshot.present[number] || snapshot.pocketed[number]) continue;
+        glm::vec2 p = snapshot.positions[number];
+        if (!std::isfinite(p.x) || !std::isfinite(p.y)) return false;
+        if (std::abs(p.x) > tableHalfLength || std::abs(p.y) > tableHalfWidth) return false;
+    }
+    return true;
+}
+
+}
+
+// The physics thread stepping breaks shot after shot while this thread reads snapshots
+// as a renderer would and strikes through withState(), often mid-shot. Every snapshot read must be whole and newer than the last one. Built with
+// -fsanitize=thread, this is also the data race check for the handoff.
+void runThreadBenchmark() {
+    World world;
+    setupStandardTable(world);
+    rackNineBall(world);
+    world.deterministic = true;
+
+    int steps = 0;
+    PhysicsThread physics(world,
+        [&world, &steps](float deltaTime) {
+            world.step(deltaTime);
+            world.events.clear();
+            steps++;
+        },
+        [&steps](SimulationSnapshot& snapshot) {
+            // Stands in for the game's own state, kept under the same lock
+            snapshot.turns = (uint32_t)steps;
+        });
+    physics.start();
+
+    typedef std::chrono::steady_clock Clock;
+    ReaderResult result;
+    uint64_t lastSequence = 0;
+    Clock::time_point start = Clock::now();
+    while (std::chrono::duration<double>(Clock::now() - start).count() < runSeconds) {
+        result.frames++;
+        physics.acquire();
+        if (physics.snapshot().sequence != lastSequence) {
+            const SimulationSnapshot& snapshot = physics.snapshot();
+            if (snapshot.sequence < lastSequence) result.outOfOrder++;
+            if (!wholeSnapshot(snapshot)) result.broken++;
+            lastSequence = snapshot.sequence;
+            result.snapshots++;
+
+            double age = PhysicsThread::now() - snapshot.publishTime;
+            result.age += age;
+            result.worstAge = std::max(result.worstAge, age);
+
+            if (snapshot.atRest || result.snapshots % snapshotsPerShot == 0) {
+                Clock::time_point asked = Clock::now();
+                int shot = result.strikes++;
+                physics.withState([&world, shot]() {
+                    rackNineBall(world);
+                    strikeCueBall(world, { 1.5708f + 0.1f * (shot % 7), 10.0f });
+                });
+                result.worstWait = std::max(result.worstWait, std::chrono::duration<double>(Clock::now() - asked).count());
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(frameSeconds));
+    }
+    physics.stop();
+
+    std::printf("%10s %10s %10s %10s %10s %12s %12s %12s\n",
+        "steps", "published", "frames", "read", "strikes", "mean age ms", "worst age ms", "worst wait ms");
+    std::printf("%10d %10llu %10d %10d %10d %12.2f %12.2f %12.2f\n",
+        steps, (unsigned long long)lastSequence, result.frames, result.snapshots, result.strikes,
+        result.age * 1000.0 / std::max(result.snapshots, 1), result.worstAge * 1000.0, result.worstWait * 1000.0);
+
+    if (result.outOfOrder > 0 || result.broken > 0) {
+        std::printf("  %d snapshots out of order, %d not whole\n", result.outOfOrder, result.broken);
+        benchmarkFailed = true;
+    }
+    if (result.strikes < 2 || physics.snapshot().turns == 0) {
+        std::printf("  the physics thread did not keep playing\n");
+        benchmarkFailed = true;
+    }
+}
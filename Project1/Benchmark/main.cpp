@@ -0,0 +1,136 @@
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.h"
+#include "../Physics/BallKernels.h"
+
+bool benchmarkFailed = false;
+
+namespace {
+
+std::vector<BenchmarkRecord> records;
+
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            out += escaped;
+        }
+        else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string jsonNumber(double value) {
+    if (!std::isfinite(value)) return "null";
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.10g", value);
+    return text;
+}
+
+std::string compilerName() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+// The recorded cases, with what they were built with, e.g. for a regression tracker
+// to compare two builds
+bool writeJson(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    std::fprintf(file, "{\n  \"compiler\": %s,\n  \"kernels\": %s,\n  \"failed\": %s,\n  \"results\": [",
+        jsonString(compilerName()).c_str(), jsonString(ballKernelIsa()).c_str(), benchmarkFailed ? "true" : "false");
+    for (size_t i = 0; i < records.size(); i++) {
+        const BenchmarkRecord& record = records[i];
+        std::fprintf(file, "%s\n    {\"suite\": %s, \"name\": %s", i ? "," : "",
+            jsonString(record.suite).c_str(), jsonString(record.name).c_str());
+        for (const auto& number : record.numbers) {
+            std::fprintf(file, ", %s: %s", jsonString(number.first).c_str(), jsonNumber(number.second).c_str());
+        }
+        for (const auto& text : record.text) {
+            std::fprintf(file, ", %s: %s", jsonString(text.first).c_str(), jsonString(text.second).c_str());
+        }
+        std::fprintf(file, "}");
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+}
+
+void recordBenchmark(const BenchmarkRecord& record) {
+    records.push_back(record);
+}
+
+struct Suite {
+    const char* name;
+    void (*run)();
+};
+
+int main(int argc, char** argv) {
+    const Suite suites[] = {
+        {"kernels", runKernelBenchmark},
+        {"broadphase", runBroadPhaseBenchmark},
+        {"events", runEventBenchmark},
+        {"ccd", runCcdBenchmark},
+        {"sleep", runSleepBenchmark},
+        {"shots", runShotBenchmark},
+        {"ai", runAIBenchmark},
+        {"determinism", runDeterminismBenchmark},
+        {"replay", runReplayBenchmark},
+        {"boundary", runBoundaryBenchmark},
+        {"scheduler", runSchedulerBenchmark},
+        {"threads", runThreadBenchmark},
+        {"input", runInputBenchmark},
+        {"scenarios", runScenarioBenchmark},
+        {"contacts", runContactBenchmark},
+        {"jobs", runJobBenchmark},
+        {"integrators", runIntegratorBenchmark},
+        {"spin", runSpinBenchmark}
+    };
+
+    // --json <file> writes the recorded cases, --scenarios <dir> reads scenario files
+    // from elsewhere; any other argument names a suite to run
+    std::string jsonPath;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (arg == "--scenarios" && i + 1 < argc) scenarioDirectory = argv[++i];
+        else names.push_back(arg);
+    }
+
+    // No suite names runs every suite; otherwise only the named ones
+    for (const Suite& suite : suites) {
+        bool selected = names.empty();
+        for (const std::string& name : names) {
+            if (suite.name == name) selected = true;
+        }
+
+        if (selected) {
+            std::cout << "== " << suite.name << std::endl;
+            suite.run();
+        }
+    }
+
+    if (!jsonPath.empty() && !writeJson(jsonPath)) {
+        std::cerr << "cannot write " << jsonPath << std::endl;
+        return 1;
+    }
+    return benchmarkFailed ? 1 : 0;
+}
@@ -8,7 +8,7 @@ struct Button {
     float x, y;
     float width, height;
 
-    bool isHovered(float mouseX, float mouseY) {
+    bool isHovered(float mouseX, float mouseY) const {
         return mouseX >= x && mouseX <= x + width &&
             mouseY >= y && mouseY <= y + height;
     }
@@ -1,6 +1,8 @@
 #ifndef CONSTANTS_H
 #define CONSTANTS_H
 
+#include "Physics/PhysicsConstants.h"
+
 #define M_PI 3.14159265358979323846
 
 enum GameStatus {
@@ -10,8 +12,6 @@ enum GameStatus {
     FINISHED = 3
 };
 
-const float ballRadius = 0.08f;
 const float tableHeight = 0.057f;
 const float startCueAngle = 1.5708f;
-const float frameTime = 1.0f / 120.0f;
 #endif
\ No newline at end of file
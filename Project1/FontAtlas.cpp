@@ -0,0 +1,328 @@
+#include "FontAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace {
+
+const char atlasMagic[4] = { 'S', 'D', 'F', '1' };
+const size_t headerSize = 4 + 8 + 5 * 4;
+const size_t glyphRecordSize = 1 + 4 * 2 + 5 * 4;
+
+// Glyphs are rasterized this many times finer than the atlas, then averaged down
+const int upscale = 4;
+const int atlasWidth = 512;
+const int padding = 1;
+
+void putBits(uint8_t* p, uint64_t bits, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(bits >> (8 * i));
+}
+
+uint64_t getBits(const uint8_t* p, int bytes) {
+    uint64_t bits = 0;
+    for (int i = 0; i < bytes; i++) bits |= (uint64_t)p[i] << (8 * i);
+    return bits;
+}
+
+void putFloat(uint8_t* p, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, 4);
+    putBits(p, bits, 4);
+}
+
+float getFloat(const uint8_t* p) {
+    uint32_t bits = (uint32_t)getBits(p, 4);
+    float value;
+    std::memcpy(&value, &bits, 4);
+    return value;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// FNV-1a
+uint64_t hashBytes(const std::vector<uint8_t>& bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Squared distance from each of n samples to the nearest zero of f, with f holding 0
+// at the points and a large value elsewhere (Felzenszwalb and Huttenlocher). v and z
+// are scratch of n and n + 1.
+void distanceTransform(const float* f, float* d, int n, int* v, float* z) {
+    const float far = 1e20f;
+    int k = 0;
+    v[0] = 0;
+    z[0] = -far;
+    z[1] = far;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = far;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) k++;
+        float offset = (float)(q - v[k]);
+        d[q] = offset * offset + f[v[k]];
+    }
+}
+
+// Squared distance from every texel of a width x height grid to the nearest texel
+// whose mask matches target, by columns and then by rows
+std::vector<float> distanceTo(const std::vector<uint8_t>& mask, uint8_t target, int width, int height) {
+    const float far = 1e20f;
+    int longest = std::max(width, height);
+    std::vector<float> grid(mask.size());
+    std::vector<float> f(longest), d(longest), z(longest + 1);
+    std::vector<int> v(longest);
+
+    for (size_t i = 0; i < mask.size(); i++) grid[i] = mask[i] == target ? 0.0f : far;
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) f[y] = grid[(size_t)y * width + x];
+        distanceTransform(f.data(), d.data(), height, v.data(), z.data());
+        for (int y = 0; y < height; y++) grid[(size_t)y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; y++) {
+        float* row = grid.data() + (size_t)y * width;
+        std::copy(row, row + width, f.begin());
+        distanceTransform(f.data(), d.data(), width, v.data(), z.data());
+        std::copy(d.begin(), d.begin() + width, row);
+    }
+    return grid;
+}
+
+// The glyph's field at atlas resolution, cols x rows texels: each the average signed
+// distance of its upscale x upscale fine texels, outside positive
+std::vector<uint8_t> glyphField(const FT_Bitmap& bitmap, int margin, int cols, int rows) {
+    int width = cols * upscale;
+    int height = rows * upscale;
+    std::vector<uint8_t> inside((size_t)width * height, 0);
+    for (int y = 0; y < (int)bitmap.rows; y++) {
+        const unsigned char* source = bitmap.buffer + y * bitmap.pitch;
+        for (int x = 0; x < (int)bitmap.width; x++) {
+            inside[(size_t)(y + margin) * width + x + margin] = source[x] >= 128 ? 1 : 0;
+        }
+    }
+
+    std::vector<float> toInside = distanceTo(inside, 1, width, height);
+    std::vector<float> toOutside = distanceTo(inside, 0, width, height);
+
+    // The outline runs between texel centres, half a texel from each side
+    std::vector<uint8_t> field((size_t)cols * rows);
+    float spread = (float)(atlasSpread * upscale);
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            float sum = 0.0f;
+            for (int y = row * upscale; y < (row + 1) * upscale; y++) {
+                for (int x = col * upscale; x < (col + 1) * upscale; x++) {
+                    size_t i = (size_t)y * width + x;
+                    sum += inside[i] ? 0.5f - std::sqrt(toOutside[i]) : std::sqrt(toInside[i]) - 0.5f;
+                }
+            }
+            float distance = sum / (upscale * upscale);
+            float value = std::clamp(0.5f - distance / (2.0f * spread), 0.0f, 1.0f);
+            field[(size_t)row * cols + col] = (uint8_t)std::lround(value * 255.0f);
+        }
+    }
+    return field;
+}
+
+}
+
+bool bakeFontAtlas(const std::string& fontPath, int fontSize, FontAtlas& atlas, std::string& error) {
+    FT_Library ft;
+    if (FT_Init_FreeType(&ft)) {
+        error = "could not initialize FreeType";
+        return false;
+    }
+
+    FT_Face face;
+    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+        error = "cannot load font " + fontPath;
+        FT_Done_FreeType(ft);
+        return false;
+    }
+
+    int bakeSize = atlasGlyphSize * upscale;
+    FT_Set_Pixel_Sizes(face, 0, bakeSize);
+
+    // Fine pixels to pixels at the size asked for
+    float toFont = (float)fontSize / bakeSize;
+    int margin = atlasSpread * upscale;
+
+    // Glyphs go left to right along shelves as tall as the tallest glyph on them
+    atlas = FontAtlas();
+    std::vector<std::vector<uint8_t>> fields(FontAtlas::glyphCount);
+    int shelfX = padding, shelfY = padding, shelfHeight = 0;
+    // Control characters are never drawn, and would only fill the atlas with boxes
+    for (int c = ' '; c < FontAtlas::glyphCount; c++) {
+        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) continue;
+
+        const FT_GlyphSlot glyph = face->glyph;
+        AtlasGlyph& entry = atlas.glyphs[c];
+        entry.advance = glyph->advance.x / 64.0f * toFont;
+        entry.loaded = true;
+
+        // Blank glyphs such as the space only advance
+        if (glyph->bitmap.width == 0 || glyph->bitmap.rows == 0) continue;
+
+        int cols = ((int)glyph->bitmap.width + 2 * margin + upscale - 1) / upscale;
+        int rows = ((int)glyph->bitmap.rows + 2 * margin + upscale - 1) / upscale;
+        fields[c] = glyphField(glyph->bitmap, margin, cols, rows);
+
+        if (shelfX + cols + padding > atlasWidth) {
+            shelfX = padding;
+            shelfY += shelfHeight + padding;
+            shelfHeight = 0;
+        }
+        entry.atlasOrigin = glm::ivec2(shelfX, shelfY);
+        entry.atlasSize = glm::ivec2(cols, rows);
+        entry.size = glm::vec2(cols, rows) * (float)upscale * toFont;
+        entry.bearing = glm::vec2(glyph->bitmap_left - margin, glyph->bitmap_top + margin) * toFont;
+        shelfX += cols + padding;
+        shelfHeight = std::max(shelfHeight, rows);
+        atlas.height = std::max(atlas.height, shelfY + rows + padding);
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    atlas.width = atlasWidth;
+    atlas.pixels.assign((size_t)atlas.width * atlas.height, 0);
+    for (int c = 0; c < FontAtlas::glyphCount; c++) {
+        const AtlasGlyph& entry = atlas.glyphs[c];
+        for (int row = 0; row < entry.atlasSize.y; row++) {
+            const uint8_t* source = fields[c].data() + (size_t)row * entry.atlasSize.x;
+            std::copy(source, source + entry.atlasSize.x,
+                atlas.pixels.begin() + (size_t)(entry.atlasOrigin.y + row) * atlas.width + entry.atlasOrigin.x);
+        }
+    }
+    return true;
+}
+
+std::string fontAtlasCachePath(const std::string& fontPath, int fontSize) {
+    return fontPath + "." + std::to_string(fontSize) + ".sdf";
+}
+
+// Layout (little-endian): "SDF1", u64 font hash, u32 font size, glyph size, spread,
+// width and height; then per glyph u8 loaded, u16 atlas x, y, width and height,
+// f32 size x, y, bearing x, y and advance; then the texels
+bool saveFontAtlas(const std::string& path, uint64_t fontHash, int fontSize, const FontAtlas& atlas, std::string& error) {
+    std::vector<uint8_t> bytes(headerSize + FontAtlas::glyphCount * glyphRecordSize + atlas.pixels.size());
+    uint8_t* p = bytes.data();
+    std::memcpy(p, atlasMagic, 4);
+    putBits(p + 4, fontHash, 8);
+    putBits(p + 12, (uint32_t)fontSize, 4);
+    putBits(p + 16, (uint32_t)atlasGlyphSize, 4);
+    putBits(p + 20, (uint32_t)atlasSpread, 4);
+    putBits(p + 24, (uint32_t)atlas.width, 4);
+    putBits(p + 28, (uint32_t)atlas.height, 4);
+
+    p += headerSize;
+    for (const AtlasGlyph& glyph : atlas.glyphs) {
+        p[0] = glyph.loaded ? 1 : 0;
+        putBits(p + 1, (uint16_t)glyph.atlasOrigin.x, 2);
+        putBits(p + 3, (uint16_t)glyph.atlasOrigin.y, 2);
+        putBits(p + 5, (uint16_t)glyph.atlasSize.x, 2);
+        putBits(p + 7, (uint16_t)glyph.atlasSize.y, 2);
+        putFloat(p + 9, glyph.size.x);
+        putFloat(p + 13, glyph.size.y);
+        putFloat(p + 17, glyph.bearing.x);
+        putFloat(p + 21, glyph.bearing.y);
+        putFloat(p + 25, glyph.advance);
+        p += glyphRecordSize;
+    }
+    std::copy(atlas.pixels.begin(), atlas.pixels.end(), p);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool loadCachedFontAtlas(const std::string& path, uint64_t fontHash, int fontSize, FontAtlas& atlas, std::string& error) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(path, bytes)) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (bytes.size() < headerSize || std::memcmp(bytes.data(), atlasMagic, 4) != 0) {
+        error = path + ": not a font atlas";
+        return false;
+    }
+
+    const uint8_t* p = bytes.data();
+    if (getBits(p + 4, 8) != fontHash || getBits(p + 12, 4) != (uint32_t)fontSize ||
+        getBits(p + 16, 4) != (uint32_t)atlasGlyphSize || getBits(p + 20, 4) != (uint32_t)atlasSpread) {
+        error = path + ": made from another font, size or spread";
+        return false;
+    }
+
+    atlas = FontAtlas();
+    atlas.width = (int)getBits(p + 24, 4);
+    atlas.height = (int)getBits(p + 28, 4);
+    size_t texels = (size_t)atlas.width * atlas.height;
+    if (bytes.size() != headerSize + FontAtlas::glyphCount * glyphRecordSize + texels) {
+        error = path + ": truncated";
+        return false;
+    }
+
+    p += headerSize;
+    for (AtlasGlyph& glyph : atlas.glyphs) {
+        glyph.loaded = p[0] != 0;
+        glyph.atlasOrigin = glm::ivec2((int)getBits(p + 1, 2), (int)getBits(p + 3, 2));
+        glyph.atlasSize = glm::ivec2((int)getBits(p + 5, 2), (int)getBits(p + 7, 2));
+        glyph.size = glm::vec2(getFloat(p + 9), getFloat(p + 13));
+        glyph.bearing = glm::vec2(getFloat(p + 17), getFloat(p + 21));
+        glyph.advance = getFloat(p + 25);
+        if (glyph.atlasOrigin.x + glyph.atlasSize.x > atlas.width || glyph.atlasOrigin.y + glyph.atlasSize.y > atlas.height) {
+            error = path + ": glyph outside the atlas";
+            return false;
+        }
+        p += glyphRecordSize;
+    }
+    atlas.pixels.assign(p, p + texels);
+    return true;
+}
+
+bool loadFontAtlas(const std::string& fontPath, int fontSize, FontAtlas& atlas, bool& fromCache, std::string& error) {
+    std::vector<uint8_t> font;
+    if (!readFile(fontPath, font)) {
+        error = "cannot open " + fontPath;
+        return false;
+    }
+    uint64_t fontHash = hashBytes(font);
+    std::string cachePath = fontAtlasCachePath(fontPath, fontSize);
+
+    std::string cacheError;
+    fromCache = loadCachedFontAtlas(cachePath, fontHash, fontSize, atlas, cacheError);
+    if (fromCache) return true;
+
+    if (!bakeFontAtlas(fontPath, fontSize, atlas, error)) return false;
+    saveFontAtlas(cachePath, fontHash, fontSize, atlas, cacheError);
+    return true;
+}
@@ -0,0 +1,53 @@
+#ifndef FONT_ATLAS_H
+#define FONT_ATLAS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// A glyph's rectangle in the atlas, in texels, and its metrics in pixels at the font
+// size the atlas was made for. Size and bearing take in the distance field's margin.
+struct AtlasGlyph {
+    glm::ivec2 atlasOrigin = glm::ivec2(0);
+    glm::ivec2 atlasSize = glm::ivec2(0);
+    glm::vec2 size = glm::vec2(0.0f);
+    glm::vec2 bearing = glm::vec2(0.0f);
+    float advance = 0.0f;
+    bool loaded = false;
+};
+
+// Signed distance field of the printable ASCII glyphs. Each texel holds the distance to the
+// nearest outline: 128 on it, more inside, reaching 0 and 255 atlasSpread texels
+// out. Thresholded at the outline it stays sharp at any scale.
+struct FontAtlas {
+    static const int glyphCount = 128;
+
+    int width = 0;
+    int height = 0;
+    // One byte per texel, rows top first
+    std::vector<uint8_t> pixels;
+    AtlasGlyph glyphs[glyphCount];
+};
+
+// Glyphs are baked at this many pixels to the em, whatever size is asked for, with the
+// field running atlasSpread texels either side of the outline
+const int atlasGlyphSize = 48;
+const int atlasSpread = 6;
+
+// Rasterizes each glyph with FreeType at four times atlasGlyphSize and takes the exact
+// Euclidean distance transform of it
+bool bakeFontAtlas(const std::string& fontPath, int fontSize, FontAtlas& atlas, std::string& error);
+
+// The cache file sits next to the font, named for the size, e.g.
+// Roboto-Regular.ttf.20.sdf; it records a hash of the font file so an edited font
+// is baked again
+std::string fontAtlasCachePath(const std::string& fontPath, int fontSize);
+bool saveFontAtlas(const std::string& path, uint64_t fontHash, int fontSize, const FontAtlas& atlas, std::string& error);
+bool loadCachedFontAtlas(const std::string& path, uint64_t fontHash, int fontSize, FontAtlas& atlas, std::string& error);
+
+// Reads the atlas from its cache file, or bakes it and writes the file when the file
+// is missing or stale; fromCache tells which. Failing to write the cache is not an error.
+bool loadFontAtlas(const std::string& fontPath, int fontSize, FontAtlas& atlas, bool& fromCache, std::string& error);
+
+#endif
@@ -0,0 +1,1173 @@
+#include "BallKernels.h"
+
+#include <cmath>
+
+// Kernel selection is compile-time; define PHYSICS_FORCE_SCALAR to validate the SIMD
+// paths against the plain loops. All paths use the same operation order, so the
+// results are identical.
+#if !defined(PHYSICS_FORCE_SCALAR) && defined(__AVX2__)
+#define PHYSICS_SIMD_AVX2
+#include <immintrin.h>
+#elif !defined(PHYSICS_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PHYSICS_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+const char* ballKernelIsa() {
+#if defined(PHYSICS_SIMD_AVX2)
+    return "AVX2";
+#elif defined(PHYSICS_SIMD_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+namespace {
+
+void emitPocketed(BallStore& balls, size_t base, int mask, std::vector<WorldEvent>& events) {
+    for (int lane = 0; mask != 0; lane++, mask >>= 1) {
+        if ((mask & 1) == 0) continue;
+
+        size_t i = base + lane;
+        balls.setPocketed(i, true);
+        balls.vx[i] = 0.0f;
+        balls.vz[i] = 0.0f;
+        balls.wx[i] = 0.0f;
+        balls.wy[i] = 0.0f;
+        balls.wz[i] = 0.0f;
+        events.push_back({ BALL_POCKETED, balls.number[i], -1 });
+    }
+}
+
+// MOTION_SPIN: a contact point slipping slower than this counts as rolling, so that
+// rounding of the spin cannot start a new slide
+const float rollingSlip = 1e-4f;
+
+// Deceleration of a sliding ball, and of the slip of its contact point, which friction
+// also takes out of the spin: 5/2 as much again for a solid sphere
+const float slidingDeceleration = ballSlidingFriction * gravity;
+const float slipDeceleration = 3.5f * slidingDeceleration;
+
+}
+
+namespace {
+
+// The scalar kernels, built on every instruction set: they run when there is no SIMD,
+// and they are the reference the SIMD kernels must match bit for bit
+
+bool scalarEuler(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    bool anyMoving = false;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            if (balls.flags[i] != 0) continue;
+
+            float velX = balls.vx[i];
+            float velZ = balls.vz[i];
+
+            balls.x[i] += velX * deltaTime;
+            balls.z[i] += velZ * deltaTime;
+
+            float speed2 = velX * velX + velZ * velZ;
+            if (speed2 > 0.0f) {
+                // Constant-magnitude rolling friction against the direction of travel
+                float k = balls.friction[i] * deltaTime / std::sqrt(speed2);
+                float newX = velX - velX * k;
+                float newZ = velZ - velZ * k;
+
+                float newSpeed2 = newX * newX + newZ * newZ;
+                if (newSpeed2 < stopSpeed * stopSpeed) {
+                    newX = 0.0f;
+                    newZ = 0.0f;
+                }
+                else if (newSpeed2 > stopSpeed * stopSpeed) {
+                    anyMoving = true;
+                }
+
+                balls.vx[i] = newX;
+                balls.vz[i] = newZ;
+            }
+        }
+    }
+
+    return anyMoving;
+}
+
+// Rolling friction's deceleration at velocity v, zero where v is
+inline void frictionAcceleration(float velX, float velZ, float mu, float& accX, float& accZ) {
+    accX = 0.0f;
+    accZ = 0.0f;
+    float speed2 = velX * velX + velZ * velZ;
+    if (speed2 > 0.0f) {
+        float k = mu / std::sqrt(speed2);
+        accX = 0.0f - velX * k;
+        accZ = 0.0f - velZ * k;
+    }
+}
+
+bool scalarSemiImplicit(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    bool anyMoving = false;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            if (balls.flags[i] != 0) continue;
+
+            float velX = balls.vx[i];
+            float velZ = balls.vz[i];
+            float newX = 0.0f, newZ = 0.0f;
+
+            float speed2 = velX * velX + velZ * velZ;
+            if (speed2 > 0.0f) {
+                // Slow down first, never past a stop, then move at the new speed
+                float speed = std::sqrt(speed2);
+                float slowed = speed - balls.friction[i] * deltaTime;
+                float newSpeed = slowed > 0.0f ? slowed : 0.0f;
+                float scale = newSpeed / speed;
+                newX = velX * scale;
+                newZ = velZ * scale;
+                balls.vx[i] = newX;
+                balls.vz[i] = newZ;
+                if (newSpeed > 0.0f) anyMoving = true;
+            }
+
+            balls.x[i] += newX * deltaTime;
+            balls.z[i] += newZ * deltaTime;
+        }
+    }
+
+    return anyMoving;
+}
+
+bool scalarExact(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    bool anyMoving = false;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            if (balls.flags[i] != 0) continue;
+
+            float velX = balls.vx[i];
+            float velZ = balls.vz[i];
+            float moveX = 0.0f, moveZ = 0.0f;
+
+            float speed2 = velX * velX + velZ * velZ;
+            if (speed2 > 0.0f) {
+                // Constant deceleration along a straight line, for the part of the step
+                // before the ball stops
+                float mu = balls.friction[i];
+                float speed = std::sqrt(speed2);
+                float stopTime = speed / mu;
+                float tau = stopTime < deltaTime ? stopTime : deltaTime;
+                float travel = tau * (speed - 0.5f * mu * tau);
+                bool moves = stopTime > deltaTime;
+                float newSpeed = moves ? speed - mu * deltaTime : 0.0f;
+
+                float along = travel / speed;
+                float scale = newSpeed / speed;
+                moveX = velX * along;
+                moveZ = velZ * along;
+                balls.vx[i] = velX * scale;
+                balls.vz[i] = velZ * scale;
+                if (moves) anyMoving = true;
+            }
+
+            balls.x[i] += moveX;
+            balls.z[i] += moveZ;
+        }
+    }
+
+    return anyMoving;
+}
+
+bool scalarRk4(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    bool anyMoving = false;
+    float halfDt = deltaTime * 0.5f;
+    float sixthDt = deltaTime / 6.0f;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            if (balls.flags[i] != 0) continue;
+
+            float velX = balls.vx[i];
+            float velZ = balls.vz[i];
+            float mu = balls.friction[i];
+
+            float a1X, a1Z, a2X, a2Z, a3X, a3Z, a4X, a4Z;
+            frictionAcceleration(velX, velZ, mu, a1X, a1Z);
+            float v2X = velX + a1X * halfDt;
+            float v2Z = velZ + a1Z * halfDt;
+            frictionAcceleration(v2X, v2Z, mu, a2X, a2Z);
+            float v3X = velX + a2X * halfDt;
+            float v3Z = velZ + a2Z * halfDt;
+            frictionAcceleration(v3X, v3Z, mu, a3X, a3Z);
+            float v4X = velX + a3X * deltaTime;
+            float v4Z = velZ + a3Z * deltaTime;
+            frictionAcceleration(v4X, v4Z, mu, a4X, a4Z);
+
+            balls.x[i] += (velX + 2.0f * v2X + 2.0f * v3X + v4X) * sixthDt;
+            balls.z[i] += (velZ + 2.0f * v2Z + 2.0f * v3Z + v4Z) * sixthDt;
+
+            float speed2 = velX * velX + velZ * velZ;
+            if (speed2 > 0.0f) {
+                float newX = velX + (a1X + 2.0f * a2X + 2.0f * a3X + a4X) * sixthDt;
+                float newZ = velZ + (a1Z + 2.0f * a2Z + 2.0f * a3Z + a4Z) * sixthDt;
+
+                // A ball that friction stops within the step stops: friction has no direction
+                // at rest, and past it the stages would cancel and leave the ball creeping
+                float reach = mu * deltaTime;
+                bool forward = speed2 > reach * reach;
+                balls.vx[i] = forward ? newX : 0.0f;
+                balls.vz[i] = forward ? newZ : 0.0f;
+                if (forward) anyMoving = true;
+            }
+        }
+    }
+
+    return anyMoving;
+}
+
+
+bool scalarSpinning(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    bool anyMoving = false;
+    float spinLoss = ballSpinDeceleration * deltaTime;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            if (balls.flags[i] != 0) continue;
+
+            float velX = balls.vx[i];
+            float velZ = balls.vz[i];
+            float spinX = balls.wx[i];
+            float spinY = balls.wy[i];
+            float spinZ = balls.wz[i];
+            float r = balls.radius[i];
+            float mu = balls.friction[i];
+
+            // Sliding: friction against the slip of the contact point slows the ball and
+            // spins it toward rolling, until the slip stops or the step ends
+            float slipX = velX + r * spinZ;
+            float slipZ = velZ - r * spinX;
+            float slip2 = slipX * slipX + slipZ * slipZ;
+            bool slips = slip2 > rollingSlip * rollingSlip;
+            float slip = std::sqrt(slip2);
+            float slideTime = slip / slipDeceleration;
+            float tau = slips ? (slideTime < deltaTime ? slideTime : deltaTime) : 0.0f;
+            float dirX = slips ? slipX / slip : 0.0f;
+            float dirZ = slips ? slipZ / slip : 0.0f;
+            float brake = slidingDeceleration * tau;
+            float halfBrake = 0.5f * brake;
+            float moveX = (velX - halfBrake * dirX) * tau;
+            float moveZ = (velZ - halfBrake * dirZ) * tau;
+            velX = velX - brake * dirX;
+            velZ = velZ - brake * dirZ;
+            float turn = 2.5f * brake / r;
+            spinX = spinX + turn * dirZ;
+            spinZ = spinZ - turn * dirX;
+            bool sliding = slips && slideTime > deltaTime;
+
+            // Rolling for the rest of the step, as integrateExact; none is left while sliding
+            float rest = deltaTime - tau;
+            float speed2 = velX * velX + velZ * velZ;
+            bool hasSpeed = !sliding && speed2 > 0.0f;
+            bool moves = false;
+            float rollX = 0.0f, rollZ = 0.0f;
+            if (hasSpeed) {
+                float speed = std::sqrt(speed2);
+                float stopTime = speed / mu;
+                float rollTime = stopTime < rest ? stopTime : rest;
+                float travel = rollTime * (speed - 0.5f * mu * rollTime);
+                moves = stopTime > rest;
+                float newSpeed = moves ? speed - mu * rest : 0.0f;
+                float along = travel / speed;
+                float scale = newSpeed / speed;
+                rollX = velX * along;
+                rollZ = velZ * along;
+                velX = velX * scale;
+                velZ = velZ * scale;
+            }
+            moveX = moveX + rollX;
+            moveZ = moveZ + rollZ;
+            if (!sliding) {
+                spinX = velZ / r;
+                spinZ = 0.0f - velX / r;
+            }
+
+            // Spin about the vertical runs down on its own. Nothing can act on it once the
+            // ball is at rest, as ball contacts ignore spin, so it stops with the ball.
+            bool moving = sliding || (hasSpeed && moves);
+            float spinLeft = std::fabs(spinY) - spinLoss;
+            bool spinning = spinLeft > 0.0f && moving;
+            spinY = spinning ? std::copysign(spinLeft, spinY) : 0.0f;
+
+            balls.x[i] += moveX;
+            balls.z[i] += moveZ;
+            balls.vx[i] = velX;
+            balls.vz[i] = velZ;
+            balls.wx[i] = spinX;
+            balls.wy[i] = spinY;
+            balls.wz[i] = spinZ;
+            if (moving) anyMoving = true;
+        }
+    }
+
+    return anyMoving;
+}
+
+void scalarCapture(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events) {
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i++) {
+            if (balls.flags[i] != 0 || zone.contains(balls.x[i], balls.z[i])) continue;
+
+            for (const Pocket& pocket : pockets) {
+                float dx = balls.x[i] - pocket.position.x;
+                float dz = balls.z[i] - pocket.position.y;
+                if (dx * dx + dz * dz < pocket.radiusSquared) {
+                    emitPocketed(balls, i, 1, events);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+}
+
+#if defined(PHYSICS_SIMD_AVX2)
+
+namespace {
+
+inline __m256 loadActive(const uint32_t* flags, size_t i) {
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(flags + i)), _mm256_setzero_si256()));
+}
+
+// Rolling friction's deceleration at velocity v, zero where v is
+inline void frictionAcceleration(__m256 velX, __m256 velZ, __m256 mu, __m256& accX, __m256& accZ) {
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velZ, velZ));
+    __m256 hasSpeed = _mm256_cmp_ps(speed2, zero, _CMP_GT_OQ);
+    __m256 k = _mm256_div_ps(mu, _mm256_sqrt_ps(speed2));
+    accX = _mm256_and_ps(_mm256_sub_ps(zero, _mm256_mul_ps(velX, k)), hasSpeed);
+    accZ = _mm256_and_ps(_mm256_sub_ps(zero, _mm256_mul_ps(velZ, k)), hasSpeed);
+}
+
+bool integrateEuler(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 stop2 = _mm256_set1_ps(stopSpeed * stopSpeed);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 8) {
+            __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(flags + i)), _mm256_setzero_si256()));
+
+            __m256 oldX = _mm256_load_ps(vx + i);
+            __m256 oldZ = _mm256_load_ps(vz + i);
+            __m256 velX = _mm256_and_ps(oldX, active);
+            __m256 velZ = _mm256_and_ps(oldZ, active);
+
+            _mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(velX, dt)));
+            _mm256_store_ps(z + i, _mm256_add_ps(_mm256_load_ps(z + i), _mm256_mul_ps(velZ, dt)));
+
+            __m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velZ, velZ));
+            __m256 hasSpeed = _mm256_cmp_ps(speed2, zero, _CMP_GT_OQ);
+
+            // Lanes without speed divide by zero here; they are masked out below
+            __m256 k = _mm256_div_ps(_mm256_mul_ps(_mm256_load_ps(friction + i), dt), _mm256_sqrt_ps(speed2));
+            __m256 newX = _mm256_sub_ps(velX, _mm256_mul_ps(velX, k));
+            __m256 newZ = _mm256_sub_ps(velZ, _mm256_mul_ps(velZ, k));
+
+            __m256 newSpeed2 = _mm256_add_ps(_mm256_mul_ps(newX, newX), _mm256_mul_ps(newZ, newZ));
+            __m256 keep = _mm256_cmp_ps(newSpeed2, stop2, _CMP_GE_OQ);
+            newX = _mm256_and_ps(newX, keep);
+            newZ = _mm256_and_ps(newZ, keep);
+
+            _mm256_store_ps(vx + i, _mm256_blendv_ps(oldX, newX, hasSpeed));
+            _mm256_store_ps(vz + i, _mm256_blendv_ps(oldZ, newZ, hasSpeed));
+
+            anyMoving = _mm256_or_ps(anyMoving, _mm256_and_ps(hasSpeed, _mm256_cmp_ps(newSpeed2, stop2, _CMP_GT_OQ)));
+        }
+    }
+
+    return _mm256_movemask_ps(anyMoving) != 0;
+}
+
+bool integrateSemiImplicit(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 8) {
+            __m256 active = loadActive(flags, i);
+            __m256 oldX = _mm256_load_ps(vx + i);
+            __m256 oldZ = _mm256_load_ps(vz + i);
+            __m256 velX = _mm256_and_ps(oldX, active);
+            __m256 velZ = _mm256_and_ps(oldZ, active);
+
+            __m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velZ, velZ));
+            __m256 hasSpeed = _mm256_cmp_ps(speed2, zero, _CMP_GT_OQ);
+            __m256 speed = _mm256_sqrt_ps(speed2);
+
+            // Lanes without speed divide by zero here; they are masked out
+            __m256 newSpeed = _mm256_max_ps(_mm256_sub_ps(speed, _mm256_mul_ps(_mm256_load_ps(friction + i), dt)), zero);
+            __m256 scale = _mm256_div_ps(newSpeed, speed);
+            __m256 newX = _mm256_and_ps(_mm256_mul_ps(velX, scale), hasSpeed);
+            __m256 newZ = _mm256_and_ps(_mm256_mul_ps(velZ, scale), hasSpeed);
+
+            _mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(newX, dt)));
+            _mm256_store_ps(z + i, _mm256_add_ps(_mm256_load_ps(z + i), _mm256_mul_ps(newZ, dt)));
+            _mm256_store_ps(vx + i, _mm256_blendv_ps(oldX, newX, hasSpeed));
+            _mm256_store_ps(vz + i, _mm256_blendv_ps(oldZ, newZ, hasSpeed));
+
+            anyMoving = _mm256_or_ps(anyMoving, _mm256_and_ps(hasSpeed, _mm256_cmp_ps(newSpeed, zero, _CMP_GT_OQ)));
+        }
+    }
+
+    return _mm256_movemask_ps(anyMoving) != 0;
+}
+
+bool integrateExact(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 8) {
+            __m256 active = loadActive(flags, i);
+            __m256 oldX = _mm256_load_ps(vx + i);
+            __m256 oldZ = _mm256_load_ps(vz + i);
+            __m256 velX = _mm256_and_ps(oldX, active);
+            __m256 velZ = _mm256_and_ps(oldZ, active);
+            __m256 mu = _mm256_load_ps(friction + i);
+
+            __m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velZ, velZ));
+            __m256 hasSpeed = _mm256_cmp_ps(speed2, zero, _CMP_GT_OQ);
+            __m256 speed = _mm256_sqrt_ps(speed2);
+
+            // Lanes without speed divide by zero here; they are masked out
+            __m256 stopTime = _mm256_div_ps(speed, mu);
+            __m256 tau = _mm256_min_ps(stopTime, dt);
+            __m256 travel = _mm256_mul_ps(tau, _mm256_sub_ps(speed, _mm256_mul_ps(_mm256_mul_ps(half, mu), tau)));
+            __m256 moves = _mm256_cmp_ps(stopTime, dt, _CMP_GT_OQ);
+            __m256 newSpeed = _mm256_and_ps(_mm256_sub_ps(speed, _mm256_mul_ps(mu, dt)), moves);
+
+            __m256 along = _mm256_div_ps(travel, speed);
+            __m256 scale = _mm256_div_ps(newSpeed, speed);
+            __m256 newX = _mm256_and_ps(_mm256_mul_ps(velX, scale), hasSpeed);
+            __m256 newZ = _mm256_and_ps(_mm256_mul_ps(velZ, scale), hasSpeed);
+
+            _mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), _mm256_and_ps(_mm256_mul_ps(velX, along), hasSpeed)));
+            _mm256_store_ps(z + i, _mm256_add_ps(_mm256_load_ps(z + i), _mm256_and_ps(_mm256_mul_ps(velZ, along), hasSpeed)));
+            _mm256_store_ps(vx + i, _mm256_blendv_ps(oldX, newX, hasSpeed));
+            _mm256_store_ps(vz + i, _mm256_blendv_ps(oldZ, newZ, hasSpeed));
+
+            anyMoving = _mm256_or_ps(anyMoving, _mm256_and_ps(hasSpeed, moves));
+        }
+    }
+
+    return _mm256_movemask_ps(anyMoving) != 0;
+}
+
+bool integrateRk4(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 halfDt = _mm256_set1_ps(deltaTime * 0.5f);
+    const __m256 sixthDt = _mm256_set1_ps(deltaTime / 6.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 8) {
+            __m256 active = loadActive(flags, i);
+            __m256 oldX = _mm256_load_ps(vx + i);
+            __m256 oldZ = _mm256_load_ps(vz + i);
+            __m256 velX = _mm256_and_ps(oldX, active);
+            __m256 velZ = _mm256_and_ps(oldZ, active);
+            __m256 mu = _mm256_load_ps(friction + i);
+
+            __m256 a1X, a1Z, a2X, a2Z, a3X, a3Z, a4X, a4Z;
+            frictionAcceleration(velX, velZ, mu, a1X, a1Z);
+            __m256 v2X = _mm256_add_ps(velX, _mm256_mul_ps(a1X, halfDt));
+            __m256 v2Z = _mm256_add_ps(velZ, _mm256_mul_ps(a1Z, halfDt));
+            frictionAcceleration(v2X, v2Z, mu, a2X, a2Z);
+            __m256 v3X = _mm256_add_ps(velX, _mm256_mul_ps(a2X, halfDt));
+            __m256 v3Z = _mm256_add_ps(velZ, _mm256_mul_ps(a2Z, halfDt));
+            frictionAcceleration(v3X, v3Z, mu, a3X, a3Z);
+            __m256 v4X = _mm256_add_ps(velX, _mm256_mul_ps(a3X, dt));
+            __m256 v4Z = _mm256_add_ps(velZ, _mm256_mul_ps(a3Z, dt));
+            frictionAcceleration(v4X, v4Z, mu, a4X, a4Z);
+
+            __m256 sumX = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(velX, _mm256_mul_ps(two, v2X)), _mm256_mul_ps(two, v3X)), v4X);
+            __m256 sumZ = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(velZ, _mm256_mul_ps(two, v2Z)), _mm256_mul_ps(two, v3Z)), v4Z);
+            _mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), _mm256_mul_ps(sumX, sixthDt)));
+            _mm256_store_ps(z + i, _mm256_add_ps(_mm256_load_ps(z + i), _mm256_mul_ps(sumZ, sixthDt)));
+
+            __m256 accX = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a1X, _mm256_mul_ps(two, a2X)), _mm256_mul_ps(two, a3X)), a4X);
+            __m256 accZ = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a1Z, _mm256_mul_ps(two, a2Z)), _mm256_mul_ps(two, a3Z)), a4Z);
+            __m256 newX = _mm256_add_ps(velX, _mm256_mul_ps(accX, sixthDt));
+            __m256 newZ = _mm256_add_ps(velZ, _mm256_mul_ps(accZ, sixthDt));
+
+            // A ball that friction stops within the step stops: friction has no direction
+            // at rest, and past it the stages would cancel and leave the ball creeping
+            __m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velZ, velZ));
+            __m256 hasSpeed = _mm256_cmp_ps(speed2, zero, _CMP_GT_OQ);
+            __m256 reach = _mm256_mul_ps(mu, dt);
+            __m256 forward = _mm256_cmp_ps(speed2, _mm256_mul_ps(reach, reach), _CMP_GT_OQ);
+            newX = _mm256_and_ps(newX, forward);
+            newZ = _mm256_and_ps(newZ, forward);
+
+            _mm256_store_ps(vx + i, _mm256_blendv_ps(oldX, newX, hasSpeed));
+            _mm256_store_ps(vz + i, _mm256_blendv_ps(oldZ, newZ, hasSpeed));
+
+            anyMoving = _mm256_or_ps(anyMoving, _mm256_and_ps(hasSpeed, forward));
+        }
+    }
+
+    return _mm256_movemask_ps(anyMoving) != 0;
+}
+
+
+bool integrateSpinning(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    float* wx = balls.wx.data();
+    float* wy = balls.wy.data();
+    float* wz = balls.wz.data();
+    const float* radius = balls.radius.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 slide = _mm256_set1_ps(slidingDeceleration);
+    const __m256 slipSlowing = _mm256_set1_ps(slipDeceleration);
+    const __m256 spinUp = _mm256_set1_ps(2.5f);
+    const __m256 rolling2 = _mm256_set1_ps(rollingSlip * rollingSlip);
+    const __m256 spinLoss = _mm256_set1_ps(ballSpinDeceleration * deltaTime);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    __m256 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 8) {
+            __m256 active = loadActive(flags, i);
+            __m256 oldX = _mm256_load_ps(vx + i);
+            __m256 oldZ = _mm256_load_ps(vz + i);
+            __m256 oldSpinX = _mm256_load_ps(wx + i);
+            __m256 oldSpinY = _mm256_load_ps(wy + i);
+            __m256 oldSpinZ = _mm256_load_ps(wz + i);
+            __m256 velX = _mm256_and_ps(oldX, active);
+            __m256 velZ = _mm256_and_ps(oldZ, active);
+            __m256 spinX = _mm256_and_ps(oldSpinX, active);
+            __m256 spinY = _mm256_and_ps(oldSpinY, active);
+            __m256 spinZ = _mm256_and_ps(oldSpinZ, active);
+            __m256 r = _mm256_load_ps(radius + i);
+            __m256 mu = _mm256_load_ps(friction + i);
+
+            // Sliding, until the contact point stops slipping or the step ends. Lanes that
+            // do not slip divide by zero here; they are masked out.
+            __m256 slipX = _mm256_add_ps(velX, _mm256_mul_ps(r, spinZ));
+            __m256 slipZ = _mm256_sub_ps(velZ, _mm256_mul_ps(r, spinX));
+            __m256 slip2 = _mm256_add_ps(_mm256_mul_ps(slipX, slipX), _mm256_mul_ps(slipZ, slipZ));
+            __m256 slips = _mm256_cmp_ps(slip2, rolling2, _CMP_GT_OQ);
+            __m256 slip = _mm256_sqrt_ps(slip2);
+            __m256 slideTime = _mm256_div_ps(slip, slipSlowing);
+            __m256 tau = _mm256_and_ps(_mm256_min_ps(slideTime, dt), slips);
+            __m256 dirX = _mm256_and_ps(_mm256_div_ps(slipX, slip), slips);
+            __m256 dirZ = _mm256_and_ps(_mm256_div_ps(slipZ, slip), slips);
+            __m256 brake = _mm256_mul_ps(slide, tau);
+            __m256 halfBrake = _mm256_mul_ps(half, brake);
+            __m256 moveX = _mm256_mul_ps(_mm256_sub_ps(velX, _mm256_mul_ps(halfBrake, dirX)), tau);
+            __m256 moveZ = _mm256_mul_ps(_mm256_sub_ps(velZ, _mm256_mul_ps(halfBrake, dirZ)), tau);
+            velX = _mm256_sub_ps(velX, _mm256_mul_ps(brake, dirX));
+            velZ = _mm256_sub_ps(velZ, _mm256_mul_ps(brake, dirZ));
+            __m256 turn = _mm256_div_ps(_mm256_mul_ps(spinUp, brake), r);
+            spinX = _mm256_add_ps(spinX, _mm256_mul_ps(turn, dirZ));
+            spinZ = _mm256_sub_ps(spinZ, _mm256_mul_ps(turn, dirX));
+            __m256 sliding = _mm256_and_ps(slips, _mm256_cmp_ps(slideTime, dt, _CMP_GT_OQ));
+
+            // Rolling for the rest of the step, as integrateExact; none is left while sliding
+            __m256 rest = _mm256_sub_ps(dt, tau);
+            __m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velZ, velZ));
+            __m256 hasSpeed = _mm256_andnot_ps(sliding, _mm256_cmp_ps(speed2, zero, _CMP_GT_OQ));
+            __m256 speed = _mm256_sqrt_ps(speed2);
+            __m256 stopTime = _mm256_div_ps(speed, mu);
+            __m256 rollTime = _mm256_min_ps(stopTime, rest);
+            __m256 travel = _mm256_mul_ps(rollTime, _mm256_sub_ps(speed, _mm256_mul_ps(_mm256_mul_ps(half, mu), rollTime)));
+            __m256 moves = _mm256_cmp_ps(stopTime, rest, _CMP_GT_OQ);
+            __m256 newSpeed = _mm256_and_ps(_mm256_sub_ps(speed, _mm256_mul_ps(mu, rest)), moves);
+            __m256 along = _mm256_div_ps(travel, speed);
+            __m256 scale = _mm256_div_ps(newSpeed, speed);
+            moveX = _mm256_add_ps(moveX, _mm256_and_ps(_mm256_mul_ps(velX, along), hasSpeed));
+            moveZ = _mm256_add_ps(moveZ, _mm256_and_ps(_mm256_mul_ps(velZ, along), hasSpeed));
+            velX = _mm256_blendv_ps(velX, _mm256_mul_ps(velX, scale), hasSpeed);
+            velZ = _mm256_blendv_ps(velZ, _mm256_mul_ps(velZ, scale), hasSpeed);
+            spinX = _mm256_blendv_ps(_mm256_div_ps(velZ, r), spinX, sliding);
+            spinZ = _mm256_blendv_ps(_mm256_sub_ps(zero, _mm256_div_ps(velX, r)), spinZ, sliding);
+
+            // Spin about the vertical runs down on its own. Nothing can act on it once the
+            // ball is at rest, as ball contacts ignore spin, so it stops with the ball.
+            __m256 moving = _mm256_or_ps(sliding, _mm256_and_ps(hasSpeed, moves));
+            __m256 spinLeft = _mm256_max_ps(_mm256_sub_ps(_mm256_andnot_ps(signBit, spinY), spinLoss), zero);
+            __m256 spinning = _mm256_and_ps(_mm256_cmp_ps(spinLeft, zero, _CMP_GT_OQ), moving);
+            spinY = _mm256_and_ps(_mm256_or_ps(spinLeft, _mm256_and_ps(spinY, signBit)), spinning);
+
+            _mm256_store_ps(x + i, _mm256_add_ps(_mm256_load_ps(x + i), moveX));
+            _mm256_store_ps(z + i, _mm256_add_ps(_mm256_load_ps(z + i), moveZ));
+            _mm256_store_ps(vx + i, _mm256_blendv_ps(oldX, velX, active));
+            _mm256_store_ps(vz + i, _mm256_blendv_ps(oldZ, velZ, active));
+            _mm256_store_ps(wx + i, _mm256_blendv_ps(oldSpinX, spinX, active));
+            _mm256_store_ps(wy + i, _mm256_blendv_ps(oldSpinY, spinY, active));
+            _mm256_store_ps(wz + i, _mm256_blendv_ps(oldSpinZ, spinZ, active));
+
+            anyMoving = _mm256_or_ps(anyMoving, _mm256_and_ps(moving, active));
+        }
+    }
+
+    return _mm256_movemask_ps(anyMoving) != 0;
+}
+}
+
+void capturePocketedBalls(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events) {
+    const float* x = balls.x.data();
+    const float* z = balls.z.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m256 zoneMinX = _mm256_set1_ps(zone.min.x);
+    const __m256 zoneMaxX = _mm256_set1_ps(zone.max.x);
+    const __m256 zoneMinZ = _mm256_set1_ps(zone.min.y);
+    const __m256 zoneMaxZ = _mm256_set1_ps(zone.max.y);
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 8) {
+            __m256 px = _mm256_load_ps(x + i);
+            __m256 pz = _mm256_load_ps(z + i);
+
+            // Most of the time every ball is well away from the pockets
+            __m256 inside = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(px, zoneMinX, _CMP_GT_OQ), _mm256_cmp_ps(px, zoneMaxX, _CMP_LT_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(pz, zoneMinZ, _CMP_GT_OQ), _mm256_cmp_ps(pz, zoneMaxZ, _CMP_LT_OQ)));
+            if (_mm256_movemask_ps(inside) == 0xff) continue;
+
+            __m256 hit = _mm256_setzero_ps();
+
+            for (const Pocket& pocket : pockets) {
+                __m256 dx = _mm256_sub_ps(px, _mm256_set1_ps(pocket.position.x));
+                __m256 dz = _mm256_sub_ps(pz, _mm256_set1_ps(pocket.position.y));
+                __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz));
+                hit = _mm256_or_ps(hit, _mm256_cmp_ps(d2, _mm256_set1_ps(pocket.radiusSquared), _CMP_LT_OQ));
+            }
+
+            __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(flags + i)), _mm256_setzero_si256()));
+
+            int mask = _mm256_movemask_ps(_mm256_and_ps(hit, active));
+            if (mask != 0) {
+                emitPocketed(balls, i, mask, events);
+            }
+        }
+    }
+}
+
+#elif defined(PHYSICS_SIMD_SSE2)
+
+namespace {
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    // mask ? b : a
+    return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b));
+}
+
+inline __m128 loadActive(const uint32_t* flags, size_t i) {
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(flags + i)), _mm_setzero_si128()));
+}
+
+// Rolling friction's deceleration at velocity v, zero where v is
+inline void frictionAcceleration(__m128 velX, __m128 velZ, __m128 mu, __m128& accX, __m128& accZ) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 speed2 = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velZ, velZ));
+    __m128 hasSpeed = _mm_cmpgt_ps(speed2, zero);
+    __m128 k = _mm_div_ps(mu, _mm_sqrt_ps(speed2));
+    accX = _mm_and_ps(_mm_sub_ps(zero, _mm_mul_ps(velX, k)), hasSpeed);
+    accZ = _mm_and_ps(_mm_sub_ps(zero, _mm_mul_ps(velZ, k)), hasSpeed);
+}
+
+bool integrateEuler(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 stop2 = _mm_set1_ps(stopSpeed * stopSpeed);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 4) {
+            __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(flags + i)), _mm_setzero_si128()));
+
+            __m128 oldX = _mm_load_ps(vx + i);
+            __m128 oldZ = _mm_load_ps(vz + i);
+            __m128 velX = _mm_and_ps(oldX, active);
+            __m128 velZ = _mm_and_ps(oldZ, active);
+
+            _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(velX, dt)));
+            _mm_store_ps(z + i, _mm_add_ps(_mm_load_ps(z + i), _mm_mul_ps(velZ, dt)));
+
+            __m128 speed2 = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velZ, velZ));
+            __m128 hasSpeed = _mm_cmpgt_ps(speed2, zero);
+
+            // Lanes without speed divide by zero here; they are masked out below
+            __m128 k = _mm_div_ps(_mm_mul_ps(_mm_load_ps(friction + i), dt), _mm_sqrt_ps(speed2));
+            __m128 newX = _mm_sub_ps(velX, _mm_mul_ps(velX, k));
+            __m128 newZ = _mm_sub_ps(velZ, _mm_mul_ps(velZ, k));
+
+            __m128 newSpeed2 = _mm_add_ps(_mm_mul_ps(newX, newX), _mm_mul_ps(newZ, newZ));
+            __m128 keep = _mm_cmpge_ps(newSpeed2, stop2);
+            newX = _mm_and_ps(newX, keep);
+            newZ = _mm_and_ps(newZ, keep);
+
+            _mm_store_ps(vx + i, select(hasSpeed, oldX, newX));
+            _mm_store_ps(vz + i, select(hasSpeed, oldZ, newZ));
+
+            anyMoving = _mm_or_ps(anyMoving, _mm_and_ps(hasSpeed, _mm_cmpgt_ps(newSpeed2, stop2)));
+        }
+    }
+
+    return _mm_movemask_ps(anyMoving) != 0;
+}
+
+bool integrateSemiImplicit(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 4) {
+            __m128 active = loadActive(flags, i);
+            __m128 oldX = _mm_load_ps(vx + i);
+            __m128 oldZ = _mm_load_ps(vz + i);
+            __m128 velX = _mm_and_ps(oldX, active);
+            __m128 velZ = _mm_and_ps(oldZ, active);
+
+            __m128 speed2 = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velZ, velZ));
+            __m128 hasSpeed = _mm_cmpgt_ps(speed2, zero);
+            __m128 speed = _mm_sqrt_ps(speed2);
+
+            // Lanes without speed divide by zero here; they are masked out
+            __m128 newSpeed = _mm_max_ps(_mm_sub_ps(speed, _mm_mul_ps(_mm_load_ps(friction + i), dt)), zero);
+            __m128 scale = _mm_div_ps(newSpeed, speed);
+            __m128 newX = _mm_and_ps(_mm_mul_ps(velX, scale), hasSpeed);
+            __m128 newZ = _mm_and_ps(_mm_mul_ps(velZ, scale), hasSpeed);
+
+            _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(newX, dt)));
+            _mm_store_ps(z + i, _mm_add_ps(_mm_load_ps(z + i), _mm_mul_ps(newZ, dt)));
+            _mm_store_ps(vx + i, select(hasSpeed, oldX, newX));
+            _mm_store_ps(vz + i, select(hasSpeed, oldZ, newZ));
+
+            anyMoving = _mm_or_ps(anyMoving, _mm_and_ps(hasSpeed, _mm_cmpgt_ps(newSpeed, zero)));
+        }
+    }
+
+    return _mm_movemask_ps(anyMoving) != 0;
+}
+
+bool integrateExact(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 4) {
+            __m128 active = loadActive(flags, i);
+            __m128 oldX = _mm_load_ps(vx + i);
+            __m128 oldZ = _mm_load_ps(vz + i);
+            __m128 velX = _mm_and_ps(oldX, active);
+            __m128 velZ = _mm_and_ps(oldZ, active);
+            __m128 mu = _mm_load_ps(friction + i);
+
+            __m128 speed2 = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velZ, velZ));
+            __m128 hasSpeed = _mm_cmpgt_ps(speed2, zero);
+            __m128 speed = _mm_sqrt_ps(speed2);
+
+            // Lanes without speed divide by zero here; they are masked out
+            __m128 stopTime = _mm_div_ps(speed, mu);
+            __m128 tau = _mm_min_ps(stopTime, dt);
+            __m128 travel = _mm_mul_ps(tau, _mm_sub_ps(speed, _mm_mul_ps(_mm_mul_ps(half, mu), tau)));
+            __m128 moves = _mm_cmpgt_ps(stopTime, dt);
+            __m128 newSpeed = _mm_and_ps(_mm_sub_ps(speed, _mm_mul_ps(mu, dt)), moves);
+
+            __m128 along = _mm_div_ps(travel, speed);
+            __m128 scale = _mm_div_ps(newSpeed, speed);
+            __m128 newX = _mm_and_ps(_mm_mul_ps(velX, scale), hasSpeed);
+            __m128 newZ = _mm_and_ps(_mm_mul_ps(velZ, scale), hasSpeed);
+
+            _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_and_ps(_mm_mul_ps(velX, along), hasSpeed)));
+            _mm_store_ps(z + i, _mm_add_ps(_mm_load_ps(z + i), _mm_and_ps(_mm_mul_ps(velZ, along), hasSpeed)));
+            _mm_store_ps(vx + i, select(hasSpeed, oldX, newX));
+            _mm_store_ps(vz + i, select(hasSpeed, oldZ, newZ));
+
+            anyMoving = _mm_or_ps(anyMoving, _mm_and_ps(hasSpeed, moves));
+        }
+    }
+
+    return _mm_movemask_ps(anyMoving) != 0;
+}
+
+bool integrateRk4(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 halfDt = _mm_set1_ps(deltaTime * 0.5f);
+    const __m128 sixthDt = _mm_set1_ps(deltaTime / 6.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 4) {
+            __m128 active = loadActive(flags, i);
+            __m128 oldX = _mm_load_ps(vx + i);
+            __m128 oldZ = _mm_load_ps(vz + i);
+            __m128 velX = _mm_and_ps(oldX, active);
+            __m128 velZ = _mm_and_ps(oldZ, active);
+            __m128 mu = _mm_load_ps(friction + i);
+
+            __m128 a1X, a1Z, a2X, a2Z, a3X, a3Z, a4X, a4Z;
+            frictionAcceleration(velX, velZ, mu, a1X, a1Z);
+            __m128 v2X = _mm_add_ps(velX, _mm_mul_ps(a1X, halfDt));
+            __m128 v2Z = _mm_add_ps(velZ, _mm_mul_ps(a1Z, halfDt));
+            frictionAcceleration(v2X, v2Z, mu, a2X, a2Z);
+            __m128 v3X = _mm_add_ps(velX, _mm_mul_ps(a2X, halfDt));
+            __m128 v3Z = _mm_add_ps(velZ, _mm_mul_ps(a2Z, halfDt));
+            frictionAcceleration(v3X, v3Z, mu, a3X, a3Z);
+            __m128 v4X = _mm_add_ps(velX, _mm_mul_ps(a3X, dt));
+            __m128 v4Z = _mm_add_ps(velZ, _mm_mul_ps(a3Z, dt));
+            frictionAcceleration(v4X, v4Z, mu, a4X, a4Z);
+
+            __m128 sumX = _mm_add_ps(_mm_add_ps(_mm_add_ps(velX, _mm_mul_ps(two, v2X)), _mm_mul_ps(two, v3X)), v4X);
+            __m128 sumZ = _mm_add_ps(_mm_add_ps(_mm_add_ps(velZ, _mm_mul_ps(two, v2Z)), _mm_mul_ps(two, v3Z)), v4Z);
+            _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(sumX, sixthDt)));
+            _mm_store_ps(z + i, _mm_add_ps(_mm_load_ps(z + i), _mm_mul_ps(sumZ, sixthDt)));
+
+            __m128 accX = _mm_add_ps(_mm_add_ps(_mm_add_ps(a1X, _mm_mul_ps(two, a2X)), _mm_mul_ps(two, a3X)), a4X);
+            __m128 accZ = _mm_add_ps(_mm_add_ps(_mm_add_ps(a1Z, _mm_mul_ps(two, a2Z)), _mm_mul_ps(two, a3Z)), a4Z);
+            __m128 newX = _mm_add_ps(velX, _mm_mul_ps(accX, sixthDt));
+            __m128 newZ = _mm_add_ps(velZ, _mm_mul_ps(accZ, sixthDt));
+
+            // A ball that friction stops within the step stops: friction has no direction
+            // at rest, and past it the stages would cancel and leave the ball creeping
+            __m128 speed2 = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velZ, velZ));
+            __m128 hasSpeed = _mm_cmpgt_ps(speed2, zero);
+            __m128 reach = _mm_mul_ps(mu, dt);
+            __m128 forward = _mm_cmpgt_ps(speed2, _mm_mul_ps(reach, reach));
+            newX = _mm_and_ps(newX, forward);
+            newZ = _mm_and_ps(newZ, forward);
+
+            _mm_store_ps(vx + i, select(hasSpeed, oldX, newX));
+            _mm_store_ps(vz + i, select(hasSpeed, oldZ, newZ));
+
+            anyMoving = _mm_or_ps(anyMoving, _mm_and_ps(hasSpeed, forward));
+        }
+    }
+
+    return _mm_movemask_ps(anyMoving) != 0;
+}
+
+
+bool integrateSpinning(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    float* x = balls.x.data();
+    float* z = balls.z.data();
+    float* vx = balls.vx.data();
+    float* vz = balls.vz.data();
+    float* wx = balls.wx.data();
+    float* wy = balls.wy.data();
+    float* wz = balls.wz.data();
+    const float* radius = balls.radius.data();
+    const float* friction = balls.friction.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 slide = _mm_set1_ps(slidingDeceleration);
+    const __m128 slipSlowing = _mm_set1_ps(slipDeceleration);
+    const __m128 spinUp = _mm_set1_ps(2.5f);
+    const __m128 rolling2 = _mm_set1_ps(rollingSlip * rollingSlip);
+    const __m128 spinLoss = _mm_set1_ps(ballSpinDeceleration * deltaTime);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    __m128 anyMoving = zero;
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 4) {
+            __m128 active = loadActive(flags, i);
+            __m128 oldX = _mm_load_ps(vx + i);
+            __m128 oldZ = _mm_load_ps(vz + i);
+            __m128 oldSpinX = _mm_load_ps(wx + i);
+            __m128 oldSpinY = _mm_load_ps(wy + i);
+            __m128 oldSpinZ = _mm_load_ps(wz + i);
+            __m128 velX = _mm_and_ps(oldX, active);
+            __m128 velZ = _mm_and_ps(oldZ, active);
+            __m128 spinX = _mm_and_ps(oldSpinX, active);
+            __m128 spinY = _mm_and_ps(oldSpinY, active);
+            __m128 spinZ = _mm_and_ps(oldSpinZ, active);
+            __m128 r = _mm_load_ps(radius + i);
+            __m128 mu = _mm_load_ps(friction + i);
+
+            // Sliding, until the contact point stops slipping or the step ends. Lanes that
+            // do not slip divide by zero here; they are masked out.
+            __m128 slipX = _mm_add_ps(velX, _mm_mul_ps(r, spinZ));
+            __m128 slipZ = _mm_sub_ps(velZ, _mm_mul_ps(r, spinX));
+            __m128 slip2 = _mm_add_ps(_mm_mul_ps(slipX, slipX), _mm_mul_ps(slipZ, slipZ));
+            __m128 slips = _mm_cmpgt_ps(slip2, rolling2);
+            __m128 slip = _mm_sqrt_ps(slip2);
+            __m128 slideTime = _mm_div_ps(slip, slipSlowing);
+            __m128 tau = _mm_and_ps(_mm_min_ps(slideTime, dt), slips);
+            __m128 dirX = _mm_and_ps(_mm_div_ps(slipX, slip), slips);
+            __m128 dirZ = _mm_and_ps(_mm_div_ps(slipZ, slip), slips);
+            __m128 brake = _mm_mul_ps(slide, tau);
+            __m128 halfBrake = _mm_mul_ps(half, brake);
+            __m128 moveX = _mm_mul_ps(_mm_sub_ps(velX, _mm_mul_ps(halfBrake, dirX)), tau);
+            __m128 moveZ = _mm_mul_ps(_mm_sub_ps(velZ, _mm_mul_ps(halfBrake, dirZ)), tau);
+            velX = _mm_sub_ps(velX, _mm_mul_ps(brake, dirX));
+            velZ = _mm_sub_ps(velZ, _mm_mul_ps(brake, dirZ));
+            __m128 turn = _mm_div_ps(_mm_mul_ps(spinUp, brake), r);
+            spinX = _mm_add_ps(spinX, _mm_mul_ps(turn, dirZ));
+            spinZ = _mm_sub_ps(spinZ, _mm_mul_ps(turn, dirX));
+            __m128 sliding = _mm_and_ps(slips, _mm_cmpgt_ps(slideTime, dt));
+
+            // Rolling for the rest of the step, as integrateExact; none is left while sliding
+            __m128 rest = _mm_sub_ps(dt, tau);
+            __m128 speed2 = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velZ, velZ));
+            __m128 hasSpeed = _mm_andnot_ps(sliding, _mm_cmpgt_ps(speed2, zero));
+            __m128 speed = _mm_sqrt_ps(speed2);
+            __m128 stopTime = _mm_div_ps(speed, mu);
+            __m128 rollTime = _mm_min_ps(stopTime, rest);
+            __m128 travel = _mm_mul_ps(rollTime, _mm_sub_ps(speed, _mm_mul_ps(_mm_mul_ps(half, mu), rollTime)));
+            __m128 moves = _mm_cmpgt_ps(stopTime, rest);
+            __m128 newSpeed = _mm_and_ps(_mm_sub_ps(speed, _mm_mul_ps(mu, rest)), moves);
+            __m128 along = _mm_div_ps(travel, speed);
+            __m128 scale = _mm_div_ps(newSpeed, speed);
+            moveX = _mm_add_ps(moveX, _mm_and_ps(_mm_mul_ps(velX, along), hasSpeed));
+            moveZ = _mm_add_ps(moveZ, _mm_and_ps(_mm_mul_ps(velZ, along), hasSpeed));
+            velX = select(hasSpeed, velX, _mm_mul_ps(velX, scale));
+            velZ = select(hasSpeed, velZ, _mm_mul_ps(velZ, scale));
+            spinX = select(sliding, _mm_div_ps(velZ, r), spinX);
+            spinZ = select(sliding, _mm_sub_ps(zero, _mm_div_ps(velX, r)), spinZ);
+
+            // Spin about the vertical runs down on its own. Nothing can act on it once the
+            // ball is at rest, as ball contacts ignore spin, so it stops with the ball.
+            __m128 moving = _mm_or_ps(sliding, _mm_and_ps(hasSpeed, moves));
+            __m128 spinLeft = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(signBit, spinY), spinLoss), zero);
+            __m128 spinning = _mm_and_ps(_mm_cmpgt_ps(spinLeft, zero), moving);
+            spinY = _mm_and_ps(_mm_or_ps(spinLeft, _mm_and_ps(spinY, signBit)), spinning);
+
+            _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), moveX));
+            _mm_store_ps(z + i, _mm_add_ps(_mm_load_ps(z + i), moveZ));
+            _mm_store_ps(vx + i, select(active, oldX, velX));
+            _mm_store_ps(vz + i, select(active, oldZ, velZ));
+            _mm_store_ps(wx + i, select(active, oldSpinX, spinX));
+            _mm_store_ps(wy + i, select(active, oldSpinY, spinY));
+            _mm_store_ps(wz + i, select(active, oldSpinZ, spinZ));
+
+            anyMoving = _mm_or_ps(anyMoving, _mm_and_ps(moving, active));
+        }
+    }
+
+    return _mm_movemask_ps(anyMoving) != 0;
+}
+}
+
+void capturePocketedBalls(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events) {
+    const float* x = balls.x.data();
+    const float* z = balls.z.data();
+    const uint32_t* flags = balls.flags.data();
+
+    const __m128 zoneMinX = _mm_set1_ps(zone.min.x);
+    const __m128 zoneMaxX = _mm_set1_ps(zone.max.x);
+    const __m128 zoneMinZ = _mm_set1_ps(zone.min.y);
+    const __m128 zoneMaxZ = _mm_set1_ps(zone.max.y);
+
+    for (const BallRange& range : ranges) {
+        for (size_t i = range.begin; i < range.end; i += 4) {
+            __m128 px = _mm_load_ps(x + i);
+            __m128 pz = _mm_load_ps(z + i);
+
+            // Most of the time every ball is well away from the pockets
+            __m128 inside = _mm_and_ps(
+                _mm_and_ps(_mm_cmpgt_ps(px, zoneMinX), _mm_cmplt_ps(px, zoneMaxX)),
+                _mm_and_ps(_mm_cmpgt_ps(pz, zoneMinZ), _mm_cmplt_ps(pz, zoneMaxZ)));
+            if (_mm_movemask_ps(inside) == 0xf) continue;
+
+            __m128 hit = _mm_setzero_ps();
+
+            for (const Pocket& pocket : pockets) {
+                __m128 dx = _mm_sub_ps(px, _mm_set1_ps(pocket.position.x));
+                __m128 dz = _mm_sub_ps(pz, _mm_set1_ps(pocket.position.y));
+                __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+                hit = _mm_or_ps(hit, _mm_cmplt_ps(d2, _mm_set1_ps(pocket.radiusSquared)));
+            }
+
+            __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(flags + i)), _mm_setzero_si128()));
+
+            int mask = _mm_movemask_ps(_mm_and_ps(hit, active));
+            if (mask != 0) {
+                emitPocketed(balls, i, mask, events);
+            }
+        }
+    }
+}
+
+#else
+
+namespace {
+
+bool integrateEuler(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return scalarEuler(balls, ranges, deltaTime);
+}
+
+bool integrateSemiImplicit(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return scalarSemiImplicit(balls, ranges, deltaTime);
+}
+
+bool integrateExact(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return scalarExact(balls, ranges, deltaTime);
+}
+
+bool integrateRk4(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return scalarRk4(balls, ranges, deltaTime);
+}
+
+bool integrateSpinning(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return scalarSpinning(balls, ranges, deltaTime);
+}
+
+}
+
+void capturePocketedBalls(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events) {
+    scalarCapture(balls, ranges, pockets, zone, events);
+}
+
+#endif
+
+namespace {
+
+std::vector<BallRange> allBalls(const BallStore& balls) {
+    return { { 0, balls.livePaddedSize() } };
+}
+
+}
+
+bool integrateBalls(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime, Integrator integrator) {
+    switch (integrator) {
+    case INTEGRATOR_SEMI_IMPLICIT:
+        return integrateSemiImplicit(balls, ranges, deltaTime);
+    case INTEGRATOR_EXACT:
+        return integrateExact(balls, ranges, deltaTime);
+    case INTEGRATOR_RK4:
+        return integrateRk4(balls, ranges, deltaTime);
+    default:
+        return integrateEuler(balls, ranges, deltaTime);
+    }
+}
+
+bool integrateBalls(BallStore& balls, float deltaTime, Integrator integrator) {
+    return integrateBalls(balls, allBalls(balls), deltaTime, integrator);
+}
+
+bool integrateSpinningBalls(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return integrateSpinning(balls, ranges, deltaTime);
+}
+
+bool integrateSpinningBalls(BallStore& balls, float deltaTime) {
+    return integrateSpinning(balls, allBalls(balls), deltaTime);
+}
+
+void capturePocketedBalls(BallStore& balls, const std::vector<Pocket>& pockets, const PocketZone& zone, std::vector<WorldEvent>& events) {
+    capturePocketedBalls(balls, allBalls(balls), pockets, zone, events);
+}
+
+bool integrateBallsScalar(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime, Integrator integrator) {
+    switch (integrator) {
+    case INTEGRATOR_SEMI_IMPLICIT:
+        return scalarSemiImplicit(balls, ranges, deltaTime);
+    case INTEGRATOR_EXACT:
+        return scalarExact(balls, ranges, deltaTime);
+    case INTEGRATOR_RK4:
+        return scalarRk4(balls, ranges, deltaTime);
+    default:
+        return scalarEuler(balls, ranges, deltaTime);
+    }
+}
+
+bool integrateSpinningBallsScalar(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime) {
+    return scalarSpinning(balls, ranges, deltaTime);
+}
+
+void capturePocketedBallsScalar(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events) {
+    scalarCapture(balls, ranges, pockets, zone, events);
+}
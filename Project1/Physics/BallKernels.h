@@ -0,0 +1,42 @@
+#ifndef BALL_KERNELS_H
+#define BALL_KERNELS_H
+
+#include <vector>
+
+#include "BallStore.h"
+#include "World.h"
+
+// Active balls are those below liveSize() with no flag set (neither pocketed nor asleep).
+// Each kernel also comes in a form that looks only at the given ranges, in order, so
+// that World's work follows its awake balls rather than every ball on the table.
+
+// Advances every active ball by deltaTime under constant-magnitude friction with the
+// given integrator (see Integrator in World.h). Returns true if any ball is still moving.
+bool integrateBalls(BallStore& balls, float deltaTime, Integrator integrator = INTEGRATOR_EULER);
+bool integrateBalls(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime, Integrator integrator);
+
+// Advances every active ball by deltaTime under MOTION_SPIN: sliding while its contact
+// point slips, rolling once it stops slipping, and side spin running down, with each
+// change of phase at its exact time within the step. Returns true if any ball is
+// still moving.
+bool integrateSpinningBalls(BallStore& balls, float deltaTime);
+bool integrateSpinningBalls(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime);
+
+// Flags active balls whose centre lies inside a pocket, zeroes their velocity and
+// appends one BALL_POCKETED event per ball, in ball order. Balls inside zone are
+// known to be clear of every pocket and are not tested.
+void capturePocketedBalls(BallStore& balls, const std::vector<Pocket>& pockets, const PocketZone& zone, std::vector<WorldEvent>& events);
+void capturePocketedBalls(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events);
+
+// Instruction set the kernels were compiled for: "AVX2", "SSE2" or "scalar"
+const char* ballKernelIsa();
+
+// The scalar kernels whatever the instruction set, which the ones above must match bit
+// for bit; for checking them
+bool integrateBallsScalar(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime, Integrator integrator);
+bool integrateSpinningBallsScalar(BallStore& balls, const std::vector<BallRange>& ranges, float deltaTime);
+void capturePocketedBallsScalar(BallStore& balls, const std::vector<BallRange>& ranges, const std::vector<Pocket>& pockets,
+    const PocketZone& zone, std::vector<WorldEvent>& events);
+
+#endif
@@ -0,0 +1,214 @@
+#include "BallStore.h"
+#include "PhysicsConstants.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+namespace {
+
+// Shared by every store, so no two layouts anywhere get the same id
+std::atomic<uint64_t> nextLayoutId(1);
+
+template <typename Vector>
+void permute(Vector& values, const std::vector<uint32_t>& from) {
+    Vector source(values);
+    for (size_t i = 0; i < from.size(); i++) {
+        values[i] = source[from[i]];
+    }
+}
+
+}
+
+PhysicsBall::PhysicsBall(float x, float z, float r, int num)
+    : position(x, z),
+    velocity(0.0f, 0.0f),
+    spin(0.0f, 0.0f, 0.0f),
+    radius(r),
+    mass(ballMass),
+    restitution(ballRestitution),
+    friction(ballFriction),
+    number(num),
+    pocketed(false) {}
+
+void BallStore::clear() {
+    count = 0;
+    live = 0;
+    needsCompaction = false;
+    order.clear();
+    resize(0);
+    newLayout();
+}
+
+void BallStore::resize(size_t padded) {
+    x.resize(padded, 0.0f);
+    z.resize(padded, 0.0f);
+    vx.resize(padded, 0.0f);
+    vz.resize(padded, 0.0f);
+    // Padding lanes are flagged as pocketed so every kernel skips them
+    flags.resize(padded, BALL_FLAG_POCKETED);
+    wx.resize(padded, 0.0f);
+    wy.resize(padded, 0.0f);
+    wz.resize(padded, 0.0f);
+    radius.resize(padded, 0.0f);
+    mass.resize(padded, 1.0f);
+    restitution.resize(padded, 0.0f);
+    friction.resize(padded, 0.0f);
+    number.resize(padded, -1);
+}
+
+void BallStore::add(const PhysicsBall& ball) {
+    if (count == paddedSize()) {
+        resize(paddedSize() + ballLaneWidth);
+    }
+    order.push_back((uint32_t)count);
+    count++;
+    write(count - 1, ball);
+    newLayout();
+}
+
+PhysicsBall BallStore::get(size_t i) const {
+    PhysicsBall ball(x[i], z[i], radius[i], number[i]);
+    ball.velocity = velocity(i);
+    ball.spin = spin(i);
+    ball.mass = mass[i];
+    ball.restitution = restitution[i];
+    ball.friction = friction[i];
+    ball.pocketed = pocketed(i);
+    return ball;
+}
+
+void BallStore::set(size_t i, const PhysicsBall& ball) {
+    write(i, ball);
+    logChange(i);
+}
+
+void BallStore::write(size_t i, const PhysicsBall& ball) {
+    x[i] = ball.position.x;
+    z[i] = ball.position.y;
+    vx[i] = ball.velocity.x;
+    vz[i] = ball.velocity.y;
+    flags[i] = ball.pocketed ? BALL_FLAG_POCKETED : 0u;
+    wx[i] = ball.spin.x;
+    wy[i] = ball.spin.y;
+    wz[i] = ball.spin.z;
+    radius[i] = ball.radius;
+    mass[i] = ball.mass;
+    restitution[i] = ball.restitution;
+    friction[i] = ball.friction;
+    number[i] = ball.number;
+    updateSplit(i);
+}
+
+void BallStore::setVelocity(size_t i, glm::vec2 v) {
+    vx[i] = v.x;
+    vz[i] = v.y;
+    if ((v.x != 0.0f || v.y != 0.0f) && asleep(i)) {
+        flags[i] &= ~BALL_FLAG_ASLEEP;
+        logChange(i);
+    }
+}
+
+void BallStore::setSpin(size_t i, glm::vec3 w) {
+    wx[i] = w.x;
+    wy[i] = w.y;
+    wz[i] = w.z;
+    if ((w.x != 0.0f || w.y != 0.0f || w.z != 0.0f) && asleep(i)) {
+        flags[i] &= ~BALL_FLAG_ASLEEP;
+        logChange(i);
+    }
+}
+
+void BallStore::setPocketed(size_t i, bool value) {
+    if (value) flags[i] |= BALL_FLAG_POCKETED;
+    else flags[i] &= ~BALL_FLAG_POCKETED;
+    logChange(i);
+    updateSplit(i);
+}
+
+void BallStore::setFlags(size_t i, uint32_t value) {
+    flags[i] = value;
+    logChange(i);
+    updateSplit(i);
+}
+
+void BallStore::takeChanged(std::vector<uint32_t>& balls) {
+    balls.insert(balls.end(), changes.begin(), changes.end());
+    changes.clear();
+}
+
+void BallStore::newLayout() {
+    layoutId = nextLayoutId++;
+    changes.clear();
+}
+
+// A store nobody takes changes from (e.g. one driven by the kernels alone) would log
+// without end, so past one entry per ball the log gives way to a new layout, which
+// tells its reader to look at every ball
+void BallStore::logChange(size_t i) {
+    if (changes.size() >= count) {
+        newLayout();
+        return;
+    }
+    changes.push_back((uint32_t)i);
+}
+
+void BallStore::updateSplit(size_t i) {
+    if (pocketed(i)) {
+        // Still correct, since kernels skip pocketed balls, just no longer tight
+        if (i < live) needsCompaction = true;
+    }
+    else if (i >= live) {
+        // Pocketed balls between the old split and i stay inside it until compact(),
+        // which also puts i back in add order. Index order then depends only on which
+        // balls are pocketed, so a world restored from a replay keyframe matches.
+        if (i > live || order[i] + 1 != count) needsCompaction = true;
+        live = i + 1;
+        newLayout();
+    }
+}
+
+void BallStore::compact() {
+    if (!needsCompaction) return;
+    needsCompaction = false;
+
+    std::vector<uint32_t> from(count);
+    std::iota(from.begin(), from.end(), 0u);
+    std::sort(from.begin(), from.end(), [this](uint32_t a, uint32_t b) {
+        if (pocketed(a) != pocketed(b)) return !pocketed(a);
+        return order[a] < order[b];
+    });
+
+    permute(x, from);
+    permute(z, from);
+    permute(vx, from);
+    permute(vz, from);
+    permute(flags, from);
+    permute(wx, from);
+    permute(wy, from);
+    permute(wz, from);
+    permute(radius, from);
+    permute(mass, from);
+    permute(restitution, from);
+    permute(friction, from);
+    permute(number, from);
+    permute(order, from);
+    newLayout();
+
+    live = 0;
+    while (live < count && !pocketed(live)) live++;
+}
+
+size_t BallStore::memoryBytes() const {
+    return capacityBytes(x) + capacityBytes(z) + capacityBytes(vx) + capacityBytes(vz) + capacityBytes(flags) +
+        capacityBytes(wx) + capacityBytes(wy) + capacityBytes(wz) +
+        capacityBytes(radius) + capacityBytes(mass) + capacityBytes(restitution) + capacityBytes(friction) +
+        capacityBytes(number) + capacityBytes(order) + capacityBytes(changes);
+}
+
+int BallStore::indexOf(int ballNumber) const {
+    for (size_t i = 0; i < count; i++) {
+        if (number[i] == ballNumber) return (int)i;
+    }
+    return -1;
+}
@@ -0,0 +1,184 @@
+#ifndef BALL_STORE_H
+#define BALL_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Arrays are 32-byte aligned and padded to a multiple of ballLaneWidth so the
+// SIMD kernels can run whole vectors without a scalar tail.
+const size_t ballLaneWidth = 8;
+const size_t ballAlignment = 32;
+
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ballAlignment)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(ballAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Heap bytes reserved by a vector
+template <typename Vector>
+size_t capacityBytes(const Vector& v) {
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
+
+// Lanes [begin, end) of the ball arrays, both multiples of ballLaneWidth and at most
+// livePaddedSize(), e.g. the blocks of lanes holding some awake ball
+struct BallRange {
+    size_t begin;
+    size_t end;
+};
+
+// Kernels treat any set flag as "not moving"
+enum BallFlags : uint32_t {
+    BALL_FLAG_POCKETED = 1u << 0,
+    // At rest: skipped by integration and never paired with another sleeping ball.
+    // Cleared by any setVelocity() that starts the ball moving.
+    BALL_FLAG_ASLEEP = 1u << 1
+};
+
+// Plain-data description of one ball, used to add balls to and read them back from a BallStore.
+struct PhysicsBall {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    // Angular velocity about x, y (up) and z in rad/s; only MOTION_SPIN uses it
+    glm::vec3 spin;
+
+    float radius;
+    float mass;
+    float restitution;
+    float friction;
+
+    int number;
+    bool pocketed;
+
+    PhysicsBall(float x, float z, float r, int num);
+};
+
+// Structure-of-arrays ball state. Hot fields (x, z, vx, vz, flags) are read by
+// the per-step kernels; the rest is only touched on contacts.
+//
+// Balls still in play come first: every ball at or past liveSize() is pocketed, so
+// the kernels and the broad phase stop there. compact() restores that split after
+// balls are pocketed or brought back, which reorders indices; ball numbers stay valid.
+//
+// World keeps its awake balls in a list across steps rather than scanning for them.
+// So that it can, the store logs the balls that could have left that list's view:
+// those whose flags were cleared or set by hand, and those placed while flagged
+// (see changed()). Writing flags or a flagged ball's position straight into the
+// arrays bypasses the log.
+class BallStore {
+public:
+    AlignedVector<float> x;
+    AlignedVector<float> z;
+    AlignedVector<float> vx;
+    AlignedVector<float> vz;
+    AlignedVector<uint32_t> flags;
+    // Angular velocity, read by the kernels only under MOTION_SPIN
+    AlignedVector<float> wx;
+    AlignedVector<float> wy;
+    AlignedVector<float> wz;
+
+    AlignedVector<float> radius;
+    AlignedVector<float> mass;
+    AlignedVector<float> restitution;
+    AlignedVector<float> friction;
+    std::vector<int> number;
+
+    size_t size() const { return count; }
+    size_t paddedSize() const { return x.size(); }
+    bool empty() const { return count == 0; }
+
+    size_t liveSize() const { return live; }
+    size_t livePaddedSize() const { return (live + ballLaneWidth - 1) / ballLaneWidth * ballLaneWidth; }
+
+    // Moves pocketed balls behind the ones in play, keeping the order in which balls
+    // were added within both groups. Does nothing unless a ball was pocketed,
+    // brought back or added since the last call.
+    void compact();
+
+    void clear();
+    void add(const PhysicsBall& ball);
+
+    PhysicsBall get(size_t i) const;
+    void set(size_t i, const PhysicsBall& ball);
+
+    glm::vec2 position(size_t i) const { return glm::vec2(x[i], z[i]); }
+    glm::vec2 velocity(size_t i) const { return glm::vec2(vx[i], vz[i]); }
+    glm::vec3 spin(size_t i) const { return glm::vec3(wx[i], wy[i], wz[i]); }
+    bool pocketed(size_t i) const { return (flags[i] & BALL_FLAG_POCKETED) != 0; }
+    bool asleep(size_t i) const { return (flags[i] & BALL_FLAG_ASLEEP) != 0; }
+
+    void setPosition(size_t i, glm::vec2 p) {
+        x[i] = p.x;
+        z[i] = p.y;
+        if (flags[i] != 0) logChange(i);
+    }
+    void setVelocity(size_t i, glm::vec2 v);
+    // Wakes the ball like setVelocity() if w is not zero
+    void setSpin(size_t i, glm::vec3 w);
+    void setPocketed(size_t i, bool value);
+    void setFlags(size_t i, uint32_t value);
+
+    // Index of the ball with the given number, or -1
+    int indexOf(int ballNumber) const;
+
+    // Rank of ball i in add() order, which compact() preserves within each group
+    uint32_t addOrder(size_t i) const { return order[i]; }
+
+    // Changes whenever balls are added, cleared or reordered, or liveSize() changes,
+    // and is never the same for two different layouts; copies share it. Indices kept
+    // from another layout are void.
+    uint64_t layout() const { return layoutId; }
+    // Gives the balls a new layout() as if they had been reordered, so everything kept
+    // by index starts over from a scan; for checking the incremental paths against
+    void newLayout();
+
+    // Balls woken, flagged or placed while flagged since the last takeChanged(), in
+    // the order it happened, possibly more than once. Only meaningful while layout()
+    // stays the same.
+    const std::vector<uint32_t>& changed() const { return changes; }
+    // Appends changed() to balls and empties it
+    void takeChanged(std::vector<uint32_t>& balls);
+
+    // Heap bytes held by the arrays, capacity included
+    size_t memoryBytes() const;
+
+private:
+    size_t count = 0;
+    size_t live = 0;
+    bool needsCompaction = false;
+    uint64_t layoutId = 0;
+    std::vector<uint32_t> changes;
+
+    // Rank in add() order (a permutation of 0..count-1), which keeps compact() stable
+    std::vector<uint32_t> order;
+
+    void resize(size_t padded);
+    void write(size_t i, const PhysicsBall& ball);
+    void updateSplit(size_t i);
+    void logChange(size_t i);
+};
+
+#endif
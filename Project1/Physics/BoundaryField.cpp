@@ -0,0 +1,123 @@
+#include "BoundaryField.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Node shape of a field with no shapes
+const uint32_t noShape = 0xffffffffu;
+
+inline BoundarySample roundSample(glm::vec2 p, glm::vec2 closest, float radius, glm::vec2 fallback) {
+    glm::vec2 gap = p - closest;
+    float length = glm::length(gap);
+    return { length - radius, length > 0.0f ? gap / length : fallback };
+}
+
+inline BoundarySample edgeSample(const Edge& edge, glm::vec2 p) {
+    float t = glm::clamp(glm::dot(p - edge.start, edge.direction), 0.0f, edge.length);
+    return roundSample(p, edge.start + edge.direction * t, edge.cushionWidth, edge.normal);
+}
+
+inline BoundarySample jawSample(const CushionJaw& jaw, glm::vec2 p) {
+    return roundSample(p, jaw.centre, jaw.radius, glm::vec2(1.0f, 0.0f));
+}
+
+}
+
+void BoundaryField::build(const std::vector<Edge>& cushions, const std::vector<CushionJaw>& roundJaws, glm::vec2 min, glm::vec2 max) {
+    edges = cushions;
+    jaws = roundJaws;
+    areaMin = min;
+    areaMax = max;
+
+    origin = min;
+    cellsX = (int)std::ceil((max.x - min.x) / cellSize) + 1;
+    cellsZ = (int)std::ceil((max.y - min.y) / cellSize) + 1;
+    nodes.resize((size_t)cellsX * cellsZ);
+
+    for (int z = 0; z < cellsZ; z++) {
+        for (int x = 0; x < cellsX; x++) {
+            uint32_t shape;
+            BoundarySample s = nearest(origin + glm::vec2(x, z) * cellSize, shape);
+            nodes[(size_t)z * cellsX + x] = { s.distance, shape };
+        }
+    }
+}
+
+BoundarySample BoundaryField::shapeSample(uint32_t shape, glm::vec2 p) const {
+    if (shape < edges.size()) return edgeSample(edges[shape], p);
+    return jawSample(jaws[shape - edges.size()], p);
+}
+
+BoundarySample BoundaryField::nearest(glm::vec2 p, uint32_t& shape) const {
+    // Only the winner's normal is needed
+    float best = INFINITY;
+    shape = noShape;
+    for (uint32_t k = 0; k < (uint32_t)edges.size(); k++) {
+        float distance = edgeSample(edges[k], p).distance;
+        if (distance < best) {
+            best = distance;
+            shape = k;
+        }
+    }
+    for (uint32_t k = 0; k < (uint32_t)jaws.size(); k++) {
+        float distance = jawSample(jaws[k], p).distance;
+        if (distance < best) {
+            best = distance;
+            shape = (uint32_t)edges.size() + k;
+        }
+    }
+
+    if (shape == noShape) return { INFINITY, glm::vec2(0.0f) };
+    return shapeSample(shape, p);
+}
+
+BoundarySample BoundaryField::exact(glm::vec2 p) const {
+    uint32_t shape;
+    return nearest(p, shape);
+}
+
+void BoundaryField::locate(glm::vec2 p, int& cx, int& cz, float& fx, float& fz) const {
+    float gx = glm::clamp((p.x - origin.x) / cellSize, 0.0f, (float)(cellsX - 1));
+    float gz = glm::clamp((p.y - origin.y) / cellSize, 0.0f, (float)(cellsZ - 1));
+    cx = std::min((int)gx, cellsX - 2);
+    cz = std::min((int)gz, cellsZ - 2);
+    fx = gx - cx;
+    fz = gz - cz;
+}
+
+float BoundaryField::distance(glm::vec2 p) const {
+    int cx, cz;
+    float fx, fz;
+    locate(p, cx, cz, fx, fz);
+
+    const Node* row = &nodes[(size_t)cz * cellsX + cx];
+    float top = row[0].distance + (row[1].distance - row[0].distance) * fx;
+    float bottom = row[cellsX].distance + (row[cellsX + 1].distance - row[cellsX].distance) * fx;
+    return top + (bottom - top) * fz;
+}
+
+BoundarySample BoundaryField::sample(glm::vec2 p) const {
+    int cx, cz;
+    float fx, fz;
+    locate(p, cx, cz, fx, fz);
+
+    const Node* row = &nodes[(size_t)cz * cellsX + cx];
+    const Node* corners[4] = { row, row + 1, row + cellsX, row + cellsX + 1 };
+
+    // Ties go to the lower shape, as in exact()
+    BoundarySample best = { INFINITY, glm::vec2(0.0f) };
+    uint32_t bestShape = noShape;
+    for (int k = 0; k < 4; k++) {
+        uint32_t shape = corners[k]->shape;
+        if (shape == noShape || shape == bestShape) continue;
+
+        BoundarySample s = shapeSample(shape, p);
+        if (s.distance < best.distance || (s.distance == best.distance && shape < bestShape)) {
+            best = s;
+            bestShape = shape;
+        }
+    }
+    return best;
+}
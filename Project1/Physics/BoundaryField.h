@@ -0,0 +1,90 @@
+#ifndef BOUNDARY_FIELD_H
+#define BOUNDARY_FIELD_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "World.h"
+
+// A round obstacle on the table, e.g. a curved pocket jaw
+struct CushionJaw {
+    glm::vec2 centre;
+    float radius;
+};
+
+// Signed distance and outward normal at a point
+struct BoundarySample {
+    float distance;
+    glm::vec2 normal;
+};
+
+// Signed distance from the table boundary, sampled on a grid. Cushions count as
+// capsules of cushionWidth around their segment and jaws as discs; the distance is
+// positive in play and negative inside them, and the normal points back into play.
+// Each grid node also records which shape is nearest it, so sample() can measure to
+// the few shapes nearest the surrounding nodes instead of blending their values. A
+// lookup costs the same however many cushions and jaws the table has.
+class BoundaryField {
+public:
+    // Grid spacing; distance() stays within it of the exact distance
+    float cellSize = 0.02f;
+
+    // What the field was built from, kept so a replay can rebuild it
+    std::vector<Edge> edges;
+    std::vector<CushionJaw> jaws;
+    glm::vec2 areaMin = glm::vec2(0.0f);
+    glm::vec2 areaMax = glm::vec2(0.0f);
+
+    // Samples the boundary over the rectangle from min to max
+    void build(const std::vector<Edge>& cushions, const std::vector<CushionJaw>& roundJaws, glm::vec2 min, glm::vec2 max);
+
+    bool empty() const { return nodes.empty(); }
+
+    // Outside the grid, lookups go by the nearest grid cell
+    bool covers(glm::vec2 p) const {
+        glm::vec2 max = boundsMax();
+        return p.x >= origin.x && p.y >= origin.y && p.x <= max.x && p.y <= max.y;
+    }
+
+    // Bilinear interpolation of the node distances: cheap, for telling whether a ball
+    // is anywhere near the boundary
+    float distance(glm::vec2 p) const;
+    // Distance and normal to the nearest of the shapes nearest the cell's four nodes,
+    // for contacts. That is the exact answer unless some other shape is nearest
+    // somewhere inside the cell without being nearest any of its corners.
+    BoundarySample sample(glm::vec2 p) const;
+
+    // Exact signed distance and normal, without the grid
+    BoundarySample exact(glm::vec2 p) const;
+
+    // Bound on distance() - exact distance anywhere on the grid
+    float error() const { return cellSize; }
+
+    size_t memoryBytes() const { return nodes.size() * sizeof(Node); }
+
+    glm::vec2 boundsMin() const { return origin; }
+    glm::vec2 boundsMax() const { return origin + glm::vec2(cellsX - 1, cellsZ - 1) * cellSize; }
+
+private:
+    // shape indexes edges, then jaws from edges.size() on
+    struct Node {
+        float distance;
+        uint32_t shape;
+    };
+
+    glm::vec2 origin = glm::vec2(0.0f);
+    int cellsX = 0;
+    int cellsZ = 0;
+    std::vector<Node> nodes;
+
+    // Cell containing p (clamped to the grid) and the position inside it
+    void locate(glm::vec2 p, int& cx, int& cz, float& fx, float& fz) const;
+
+    uint32_t shapeCount() const { return (uint32_t)(edges.size() + jaws.size()); }
+    BoundarySample shapeSample(uint32_t shape, glm::vec2 p) const;
+    // Nearest shape to p, or 0xffffffff if there are none
+    BoundarySample nearest(glm::vec2 p, uint32_t& shape) const;
+};
+
+#endif
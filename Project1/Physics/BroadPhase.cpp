@@ -0,0 +1,319 @@
+#include "BroadPhase.h"
+
+#include <algorithm>
+#include <cmath>
+
+void BroadPhase::findPairs(const BallStore& balls, const std::vector<uint32_t>& awake, const std::vector<uint32_t>& moved,
+    std::vector<BallPair>& pairs, float extraMargin) {
+    pairs.clear();
+    pairsTested = 0;
+    queryMargin = margin + extraMargin;
+
+    bool rebuild = balls.layout() != builtLayout || type != builtType;
+    builtLayout = balls.layout();
+    builtType = type;
+
+    switch (type) {
+    case BROAD_PHASE_GRID:
+        grid(balls, awake, moved, pairs, rebuild);
+        break;
+    case BROAD_PHASE_SWEEP_AND_PRUNE:
+        sweepAndPrune(balls, awake, moved, pairs, rebuild);
+        break;
+    default:
+        bruteForce(balls, awake, pairs);
+        break;
+    }
+}
+
+size_t BroadPhase::memoryBytes() const {
+    return capacityBytes(ballCell) + capacityBytes(cellHead) + capacityBytes(cellNext) + capacityBytes(cellPrev) +
+        capacityBytes(sweepOrder) + capacityBytes(sweepRank) + capacityBytes(sweepMinX);
+}
+
+void BroadPhase::findSleepingNeighbours(const BallStore& balls, uint32_t i, std::vector<uint32_t>& neighbours) const {
+    neighbours.clear();
+
+    if (type == BROAD_PHASE_GRID && i < ballCell.size() && ballCell[i] >= 0) {
+        int cx = ballCell[i] % cellsX;
+        int cz = ballCell[i] / cellsX;
+        for (int nz = std::max(cz - 1, 0); nz <= std::min(cz + 1, cellsZ - 1); nz++) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, cellsX - 1); nx++) {
+                for (int j = cellHead[nz * cellsX + nx]; j >= 0; j = cellNext[j]) {
+                    if ((uint32_t)j != i && balls.asleep(j) && near(balls, i, j)) neighbours.push_back(j);
+                }
+            }
+        }
+    }
+    else if (type == BROAD_PHASE_SWEEP_AND_PRUNE && i < sweepMinX.size()) {
+        // Any ball reaching i starts at most one diameter plus the margin to its left
+        float from = sweepMinX[i] - 2.0f * sweepMaxRadius - queryMargin;
+        float to = balls.x[i] + balls.radius[i] + queryMargin;
+        auto first = std::lower_bound(sweepOrder.begin(), sweepOrder.end(), from,
+            [this](uint32_t ball, float key) { return sweepMinX[ball] < key; });
+        for (auto it = first; it != sweepOrder.end() && sweepMinX[*it] <= to; ++it) {
+            uint32_t j = *it;
+            if (j != i && !balls.pocketed(j) && balls.asleep(j) && near(balls, i, j)) neighbours.push_back(j);
+        }
+    }
+    else {
+        for (uint32_t j = 0; j < (uint32_t)balls.liveSize(); j++) {
+            if (j != i && !balls.pocketed(j) && balls.asleep(j) && near(balls, i, j)) neighbours.push_back(j);
+        }
+    }
+}
+
+bool BroadPhase::near(const BallStore& balls, uint32_t i, uint32_t j) const {
+    float dx = balls.x[j] - balls.x[i];
+    float dz = balls.z[j] - balls.z[i];
+    float reach = balls.radius[i] + balls.radius[j] + queryMargin;
+    return dx * dx + dz * dz < reach * reach;
+}
+
+void BroadPhase::bruteForce(const BallStore& balls, const std::vector<uint32_t>& awake, std::vector<BallPair>& pairs) {
+    uint32_t count = (uint32_t)balls.liveSize();
+
+    // Two awake balls pair from the lower index, so below i only sleeping balls count
+    for (uint32_t i : awake) {
+        if (balls.flags[i] != 0) continue;
+        for (uint32_t j = 0; j < i; j++) {
+            if (!balls.asleep(j) || balls.pocketed(j)) continue;
+
+            pairsTested++;
+            if (near(balls, i, j)) {
+                pairs.push_back(makePair(i, j));
+            }
+        }
+        for (uint32_t j = i + 1; j < count; j++) {
+            if (balls.pocketed(j)) continue;
+
+            pairsTested++;
+            if (near(balls, i, j)) {
+                pairs.push_back(makePair(i, j));
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end(), pairLess);
+}
+
+void BroadPhase::rebuildGrid(const BallStore& balls) {
+    size_t count = balls.liveSize();
+
+    gridMaxRadius = 0.0f;
+    float minX = 0.0f, maxX = 0.0f, minZ = 0.0f, maxZ = 0.0f;
+    bool any = false;
+    for (size_t i = 0; i < count; i++) {
+        gridMaxRadius = std::max(gridMaxRadius, balls.radius[i]);
+        if (balls.pocketed(i)) continue;
+        if (!any) {
+            minX = maxX = balls.x[i];
+            minZ = maxZ = balls.z[i];
+            any = true;
+            continue;
+        }
+        minX = std::min(minX, balls.x[i]);
+        maxX = std::max(maxX, balls.x[i]);
+        minZ = std::min(minZ, balls.z[i]);
+        maxZ = std::max(maxZ, balls.z[i]);
+    }
+
+    // Cells one contact distance wide, so contacts only ever span neighbouring cells.
+    // Sparse layouts get bigger cells to keep the cell array proportional to the ball count.
+    float size = 2.0f * gridMaxRadius + queryMargin;
+    float width = maxX - minX + size;
+    float depth = maxZ - minZ + size;
+    float maxCells = (float)std::max<size_t>(1024, 4 * count);
+    if ((width / size) * (depth / size) > maxCells) {
+        size = std::sqrt(width * depth / maxCells);
+    }
+
+    // Keep the previous layout while every ball still fits it
+    bool layoutChanged = size > cellSize || cellsX == 0 ||
+        minX < gridMinX || minZ < gridMinZ ||
+        maxX >= gridMinX + cellsX * cellSize || maxZ >= gridMinZ + cellsZ * cellSize;
+
+    if (layoutChanged) {
+        cellSize = size;
+        // Leave a cell of slack around the balls so small movements keep this layout
+        gridMinX = minX - cellSize;
+        gridMinZ = minZ - cellSize;
+        cellsX = (int)((maxX - gridMinX) / cellSize) + 2;
+        cellsZ = (int)((maxZ - gridMinZ) / cellSize) + 2;
+    }
+
+    cellHead.assign((size_t)cellsX * cellsZ, -1);
+    ballCell.assign(count, -1);
+    cellNext.resize(count);
+    cellPrev.resize(count);
+    // Every ball fits the layout, so none is refused
+    for (size_t i = count; i-- > 0;) {
+        placeInGrid(balls, (uint32_t)i);
+    }
+}
+
+// Moves ball i to the cell its position is in; false if it is outside the grid
+bool BroadPhase::placeInGrid(const BallStore& balls, uint32_t i) {
+    int cell = -1;
+    if (!balls.pocketed(i)) {
+        float fx = (balls.x[i] - gridMinX) / cellSize;
+        float fz = (balls.z[i] - gridMinZ) / cellSize;
+        if (!(fx >= 0.0f && fx < (float)cellsX && fz >= 0.0f && fz < (float)cellsZ)) return false;
+        cell = (int)fz * cellsX + (int)fx;
+    }
+    if (cell == ballCell[i]) return true;
+
+    if (ballCell[i] >= 0) {
+        if (cellPrev[i] >= 0) cellNext[cellPrev[i]] = cellNext[i];
+        else cellHead[ballCell[i]] = cellNext[i];
+        if (cellNext[i] >= 0) cellPrev[cellNext[i]] = cellPrev[i];
+    }
+    if (cell >= 0) {
+        cellPrev[i] = -1;
+        cellNext[i] = cellHead[cell];
+        if (cellHead[cell] >= 0) cellPrev[cellHead[cell]] = (int)i;
+        cellHead[cell] = (int)i;
+    }
+    ballCell[i] = cell;
+    return true;
+}
+
+void BroadPhase::grid(const BallStore& balls, const std::vector<uint32_t>& awake, const std::vector<uint32_t>& moved,
+    std::vector<BallPair>& pairs, bool rebuild) {
+    uint32_t count = (uint32_t)balls.liveSize();
+
+    // Only the balls that may have moved change cell; the grid starts over if one
+    // leaves it or the cells are now narrower than the contact distance
+    if (!rebuild) {
+        for (const std::vector<uint32_t>* list : { &moved, &awake }) {
+            for (uint32_t i : *list) {
+                if (i < count) gridMaxRadius = std::max(gridMaxRadius, balls.radius[i]);
+            }
+        }
+        rebuild = 2.0f * gridMaxRadius + queryMargin > cellSize;
+    }
+    for (const std::vector<uint32_t>* list : { &moved, &awake }) {
+        for (uint32_t i : *list) {
+            if (rebuild) break;
+            if (i < count && !placeInGrid(balls, i)) rebuild = true;
+        }
+    }
+    if (rebuild) rebuildGrid(balls);
+
+    // Only awake balls look around their cell, so the cost follows the moving balls.
+    // A sleeping neighbour is paired from the awake side only; two awake balls pair
+    // from the lower index.
+    for (uint32_t i : awake) {
+        int cell = ballCell[i];
+        if (cell < 0 || balls.flags[i] != 0) continue;
+
+        int cx = cell % cellsX;
+        int cz = cell / cellsX;
+
+        for (int nz = std::max(cz - 1, 0); nz <= std::min(cz + 1, cellsZ - 1); nz++) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, cellsX - 1); nx++) {
+                for (int neighbour = cellHead[nz * cellsX + nx]; neighbour >= 0; neighbour = cellNext[neighbour]) {
+                    uint32_t j = (uint32_t)neighbour;
+                    if (j == i || (j < i && !balls.asleep(j))) continue;
+
+                    pairsTested++;
+                    if (near(balls, i, j)) {
+                        pairs.push_back(makePair(i, j));
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end(), pairLess);
+}
+
+void BroadPhase::rebuildSweep(const BallStore& balls) {
+    uint32_t count = (uint32_t)balls.liveSize();
+
+    sweepOrder.resize(count);
+    sweepMinX.resize(count);
+    sweepMaxRadius = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        sweepOrder[i] = i;
+        sweepMinX[i] = balls.x[i] - balls.radius[i];
+        sweepMaxRadius = std::max(sweepMaxRadius, balls.radius[i]);
+    }
+    std::stable_sort(sweepOrder.begin(), sweepOrder.end(),
+        [this](uint32_t l, uint32_t r) { return sweepMinX[l] < sweepMinX[r]; });
+
+    sweepRank.resize(count);
+    for (uint32_t k = 0; k < count; k++) sweepRank[sweepOrder[k]] = k;
+}
+
+// Gives ball i its new key and moves it to its place in the order. Motion between
+// steps is small, so it rarely passes more than a few neighbours.
+void BroadPhase::placeInSweep(const BallStore& balls, uint32_t i) {
+    float key = balls.x[i] - balls.radius[i];
+    sweepMinX[i] = key;
+    sweepMaxRadius = std::max(sweepMaxRadius, balls.radius[i]);
+
+    size_t k = sweepRank[i];
+    while (k > 0 && sweepMinX[sweepOrder[k - 1]] > key) {
+        sweepOrder[k] = sweepOrder[k - 1];
+        sweepRank[sweepOrder[k]] = (uint32_t)k;
+        k--;
+    }
+    while (k + 1 < sweepOrder.size() && sweepMinX[sweepOrder[k + 1]] < key) {
+        sweepOrder[k] = sweepOrder[k + 1];
+        sweepRank[sweepOrder[k]] = (uint32_t)k;
+        k++;
+    }
+    sweepOrder[k] = i;
+    sweepRank[i] = (uint32_t)k;
+}
+
+void BroadPhase::sweepAndPrune(const BallStore& balls, const std::vector<uint32_t>& awake, const std::vector<uint32_t>& moved,
+    std::vector<BallPair>& pairs, bool rebuild) {
+    uint32_t count = (uint32_t)balls.liveSize();
+
+    if (rebuild) {
+        rebuildSweep(balls);
+    }
+    else {
+        for (const std::vector<uint32_t>* list : { &moved, &awake }) {
+            for (uint32_t i : *list) {
+                if (i < count) placeInSweep(balls, i);
+            }
+        }
+    }
+
+    // Only awake balls sweep: to the right for every ball, and back to the left for
+    // sleeping ones, which never sweep themselves
+    float reachBack = 2.0f * sweepMaxRadius + queryMargin;
+    for (uint32_t i : awake) {
+        if (balls.flags[i] != 0) continue;
+        size_t k = sweepRank[i];
+
+        float maxX = balls.x[i] + balls.radius[i] + queryMargin;
+        for (size_t m = k + 1; m < count; m++) {
+            uint32_t j = sweepOrder[m];
+            if (sweepMinX[j] > maxX) break;
+            if (balls.pocketed(j)) continue;
+
+            pairsTested++;
+            if (near(balls, i, j)) {
+                pairs.push_back(makePair(i, j));
+            }
+        }
+
+        float minX = sweepMinX[i] - reachBack;
+        for (size_t m = k; m > 0; m--) {
+            uint32_t j = sweepOrder[m - 1];
+            if (sweepMinX[j] < minX) break;
+            if (!balls.asleep(j) || balls.pocketed(j)) continue;
+
+            pairsTested++;
+            if (near(balls, i, j)) {
+                pairs.push_back(makePair(i, j));
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end(), pairLess);
+}
@@ -0,0 +1,108 @@
+#ifndef BROAD_PHASE_H
+#define BROAD_PHASE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "BallStore.h"
+#include "PhysicsConstants.h"
+
+enum BroadPhaseType {
+    BROAD_PHASE_BRUTE_FORCE = 0,     // every awake ball against every ball, kept for validation
+    BROAD_PHASE_GRID = 1,            // uniform grid with cells of one ball diameter
+    BROAD_PHASE_SWEEP_AND_PRUNE = 2  // persistent sort on x, updated by insertion sort
+};
+
+// Indices into a BallStore, a < b
+struct BallPair {
+    uint32_t a;
+    uint32_t b;
+};
+
+inline bool pairLess(const BallPair& l, const BallPair& r) {
+    return l.a != r.a ? l.a < r.a : l.b < r.b;
+}
+
+inline BallPair makePair(uint32_t i, uint32_t j) {
+    return i < j ? BallPair{ i, j } : BallPair{ j, i };
+}
+
+// Produces candidate ball pairs whose centres are closer than the sum of their radii
+// plus a margin. The margin covers balls nudged by positional correction while the
+// narrow phase works through the list. Output is sorted by (a, b) so every strategy
+// resolves contacts in the same order as the brute-force loop.
+//
+// Only balls below liveSize() are considered, and a pair needs at least one ball
+// awake: two sleeping balls cannot start touching. The grid and the sweep are kept
+// between calls and only the balls that moved are updated, so with most balls asleep
+// the cost follows the awake ones; they start over when BallStore::layout() or type
+// changes.
+//
+// A plain value type (no virtual dispatch) so a World, broad-phase state included,
+// can be copied.
+class BroadPhase {
+public:
+    BroadPhaseType type = BROAD_PHASE_SWEEP_AND_PRUNE;
+    float margin = 0.25f * ballRadius;
+
+    // Distance tests made by the last findPairs() call
+    size_t pairsTested = 0;
+
+    // awake lists every ball below liveSize() with no flag set, each once, in any
+    // order. moved lists the other balls placed, put to sleep or flagged since the
+    // last call, repeats allowed. extraMargin widens the search for one call, e.g. by
+    // how far balls can close in during a swept step.
+    void findPairs(const BallStore& balls, const std::vector<uint32_t>& awake, const std::vector<uint32_t>& moved,
+        std::vector<BallPair>& pairs, float extraMargin = 0.0f);
+
+    // Sleeping balls near ball i, for a ball woken after findPairs() skipped its pairs
+    // with other sleepers. Uses the structures and margin of that call.
+    void findSleepingNeighbours(const BallStore& balls, uint32_t i, std::vector<uint32_t>& neighbours) const;
+
+    // Heap bytes held by the grid and sweep structures, capacity included
+    size_t memoryBytes() const;
+
+private:
+    // margin plus the extraMargin of the current findPairs() call
+    float queryMargin = 0.0f;
+
+    // Layout and type the grid or sweep below was built for
+    uint64_t builtLayout = 0;
+    BroadPhaseType builtType = BROAD_PHASE_BRUTE_FORCE;
+
+    // Uniform grid. Each cell holds a doubly linked list of its balls, so a ball that
+    // changes cell moves in constant time; the whole grid is only rebuilt when a ball
+    // leaves it or the cells get too small for the contact distance.
+    float cellSize = 0.0f;
+    float gridMinX = 0.0f;
+    float gridMinZ = 0.0f;
+    int cellsX = 0;
+    int cellsZ = 0;
+    float gridMaxRadius = 0.0f;
+    // -1 for pocketed balls and empty lists
+    std::vector<int> ballCell;
+    std::vector<int> cellHead;
+    std::vector<int> cellNext;
+    std::vector<int> cellPrev;
+
+    // Sweep and prune: ball indices ordered by the left end of their x interval, and
+    // each ball's place in that order
+    std::vector<uint32_t> sweepOrder;
+    std::vector<uint32_t> sweepRank;
+    std::vector<float> sweepMinX;
+    float sweepMaxRadius = 0.0f;
+
+    void bruteForce(const BallStore& balls, const std::vector<uint32_t>& awake, std::vector<BallPair>& pairs);
+    void grid(const BallStore& balls, const std::vector<uint32_t>& awake, const std::vector<uint32_t>& moved,
+        std::vector<BallPair>& pairs, bool rebuild);
+    void sweepAndPrune(const BallStore& balls, const std::vector<uint32_t>& awake, const std::vector<uint32_t>& moved,
+        std::vector<BallPair>& pairs, bool rebuild);
+
+    void rebuildGrid(const BallStore& balls);
+    bool placeInGrid(const BallStore& balls, uint32_t i);
+    void rebuildSweep(const BallStore& balls);
+    void placeInSweep(const BallStore& balls, uint32_t i);
+    bool near(const BallStore& balls, uint32_t i, uint32_t j) const;
+};
+
+#endif
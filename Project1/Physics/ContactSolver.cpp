@@ -0,0 +1,183 @@
+#include "ContactSolver.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "JobSystem.h"
+
+namespace {
+
+uint64_t contactKey(int numberA, int numberB) {
+    return ((uint64_t)(uint32_t)numberA << 32) | (uint32_t)numberB;
+}
+
+}
+
+size_t ContactSolver::memoryBytes() const {
+    return capacityBytes(cache) + capacityBytes(parent) + capacityBytes(rootIsland) + capacityBytes(contactIsland) +
+        capacityBytes(islandStart) + capacityBytes(islandFill) + capacityBytes(islandContacts) + capacityBytes(sourceContact);
+}
+
+void ContactSolver::solve(BallStore& balls, std::vector<SolverContact>& contacts) {
+    islandStart.clear();
+    largest = 0;
+    if (contacts.empty()) {
+        cache.clear();
+        return;
+    }
+
+    prepare(balls, contacts);
+    std::sort(contacts.begin(), contacts.end(), [](const SolverContact& l, const SolverContact& r) {
+        return l.key < r.key;
+    });
+    buildIslands(balls.liveSize(), contacts);
+
+    size_t islands = islandCount();
+    JobSystem& jobs = JobSystem::shared();
+    unsigned threads = threadCount != 0 ? threadCount : jobs.workerCount() + 1;
+    if (contacts.size() < parallelContacts) threads = 1;
+    threads = (unsigned)std::min<size_t>(threads, islands);
+
+    // Each lane takes the next unclaimed island; islands share no balls
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t k = next++; k < islands; k = next++) {
+            solveIsland(balls, islandContacts.data() + islandStart[k], islandStart[k + 1] - islandStart[k]);
+        }
+    };
+
+    if (threads <= 1) {
+        work();
+    }
+    else {
+        jobs.parallelFor(threads, 1, [&](size_t, size_t) { work(); });
+    }
+
+    // Keep the impulses for the next step; islandContacts are in key order per island
+    cache.clear();
+    for (const SolverContact& contact : islandContacts) {
+        if (contact.impulse > 0.0f) cache.push_back({ contact.key, contact.impulse });
+    }
+    std::sort(cache.begin(), cache.end(), [](const CachedImpulse& l, const CachedImpulse& r) {
+        return l.key < r.key;
+    });
+
+    // Hand the solved contacts back, still in key order
+    for (size_t c = 0; c < islandContacts.size(); c++) {
+        contacts[sourceContact[c]] = islandContacts[c];
+    }
+}
+
+// Normals, masses and restitution targets from the balls before the solve, and the
+// warm-start impulse of each contact seen in the last step
+void ContactSolver::prepare(const BallStore& balls, std::vector<SolverContact>& contacts) const {
+    for (SolverContact& contact : contacts) {
+        if (balls.number[contact.a] > balls.number[contact.b]) std::swap(contact.a, contact.b);
+        uint32_t a = contact.a, b = contact.b;
+        contact.key = contactKey(balls.number[a], balls.number[b]);
+
+        glm::vec2 delta = balls.position(b) - balls.position(a);
+        float distance = glm::length(delta);
+        contact.normal = distance > 0.0f ? delta / distance : glm::vec2(1.0f, 0.0f);
+        contact.effectiveMass = 1.0f / (1.0f / balls.mass[a] + 1.0f / balls.mass[b]);
+
+        contact.approach = -glm::dot(balls.velocity(b) - balls.velocity(a), contact.normal);
+        float restitution = (balls.restitution[a] + balls.restitution[b]) * 0.5f;
+        contact.bias = contact.approach > restitutionThreshold ? restitution * contact.approach : 0.0f;
+
+        contact.impulse = 0.0f;
+        if (warmStart) {
+            auto cached = std::lower_bound(cache.begin(), cache.end(), contact.key, [](const CachedImpulse& entry, uint64_t key) {
+                return entry.key < key;
+            });
+            if (cached != cache.end() && cached->key == contact.key) contact.impulse = cached->impulse;
+        }
+    }
+}
+
+uint32_t ContactSolver::root(uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Islands are numbered by their first contact in key order, and a counting sort keeps
+// key order within each, so the grouping depends only on ball numbers
+void ContactSolver::buildIslands(size_t ballCount, const std::vector<SolverContact>& contacts) {
+    parent.resize(ballCount);
+    for (const SolverContact& contact : contacts) {
+        parent[contact.a] = contact.a;
+        parent[contact.b] = contact.b;
+    }
+    for (const SolverContact& contact : contacts) {
+        uint32_t a = root(contact.a), b = root(contact.b);
+        if (a != b) parent[std::max(a, b)] = std::min(a, b);
+    }
+
+    const uint32_t unseen = UINT32_MAX;
+    rootIsland.assign(ballCount, unseen);
+    contactIsland.resize(contacts.size());
+    uint32_t islands = 0;
+    for (size_t c = 0; c < contacts.size(); c++) {
+        uint32_t r = root(contacts[c].a);
+        if (rootIsland[r] == unseen) rootIsland[r] = islands++;
+        contactIsland[c] = rootIsland[r];
+    }
+
+    islandStart.assign(islands + 1, 0);
+    for (uint32_t k : contactIsland) islandStart[k + 1]++;
+    for (uint32_t k = 0; k < islands; k++) {
+        islandStart[k + 1] += islandStart[k];
+        largest = std::max<size_t>(largest, islandStart[k + 1] - islandStart[k]);
+    }
+
+    islandFill.assign(islandStart.begin(), islandStart.end() - 1);
+    islandContacts.resize(contacts.size());
+    sourceContact.resize(contacts.size());
+    for (size_t c = 0; c < contacts.size(); c++) {
+        uint32_t slot = islandFill[contactIsland[c]]++;
+        islandContacts[slot] = contacts[c];
+        sourceContact[slot] = (uint32_t)c;
+    }
+}
+
+void ContactSolver::solveIsland(BallStore& balls, SolverContact* contacts, size_t count) const {
+    auto applyImpulse = [&balls](const SolverContact& contact, float impulse) {
+        glm::vec2 push = contact.normal * impulse;
+        balls.setVelocity(contact.a, balls.velocity(contact.a) - push / balls.mass[contact.a]);
+        balls.setVelocity(contact.b, balls.velocity(contact.b) + push / balls.mass[contact.b]);
+    };
+
+    for (size_t c = 0; c < count; c++) {
+        if (contacts[c].impulse > 0.0f) applyImpulse(contacts[c], contacts[c].impulse);
+    }
+
+    for (int iteration = 0; iteration < velocityIterations; iteration++) {
+        for (size_t c = 0; c < count; c++) {
+            SolverContact& contact = contacts[c];
+            float separating = glm::dot(balls.velocity(contact.b) - balls.velocity(contact.a), contact.normal);
+            float accumulated = std::max(contact.impulse + contact.effectiveMass * (contact.bias - separating), 0.0f);
+            float change = accumulated - contact.impulse;
+            contact.impulse = accumulated;
+            if (change != 0.0f) applyImpulse(contact, change);
+        }
+    }
+
+    // Overlaps left after the step are pushed apart, half each way as the pairwise
+    // solver does, in the same order
+    for (int iteration = 0; iteration < positionIterations; iteration++) {
+        for (size_t c = 0; c < count; c++) {
+            const SolverContact& contact = contacts[c];
+            glm::vec2 delta = balls.position(contact.b) - balls.position(contact.a);
+            float distance = glm::length(delta);
+            float overlap = balls.radius[contact.a] + balls.radius[contact.b] - distance;
+            if (overlap <= 0.0f || distance <= 0.0f) continue;
+
+            glm::vec2 separation = delta / distance * overlap * 0.5f;
+            balls.setPosition(contact.a, balls.position(contact.a) - separation);
+            balls.setPosition(contact.b, balls.position(contact.b) + separation);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef CONTACT_SOLVER_H
+#define CONTACT_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "BallStore.h"
+
+// Two touching balls, by index. solve() fills in the rest.
+struct SolverContact {
+    uint32_t a;
+    uint32_t b;
+
+    // Ball numbers of a and b, lower first, as one sort key
+    uint64_t key;
+    glm::vec2 normal;
+    float effectiveMass;
+    // Separating speed the solve aims for: the restitution share of the approach
+    float bias;
+    // Accumulated normal impulse, never negative
+    float impulse;
+    // Closing speed before the solve; above zero the balls were approaching
+    float approach;
+};
+
+// Solves every ball contact of a step at once. Contacts are grouped into islands
+// (balls connected through touching contacts) and each island is solved with
+// sequential impulses: repeated passes that push each contact's accumulated impulse
+// towards the value that stops the balls closing in, clamped so contacts only push.
+// Each contact starts from its impulse in the previous step (warm starting), so a
+// resting cluster converges in a few passes. Overlaps are then projected apart.
+//
+// Contacts are visited in ball number order, so the result does not depend on the
+// order balls were added in or are stored in, and islands share no balls, so solving
+// them in parallel gives the same result as one at a time.
+class ContactSolver {
+public:
+    int velocityIterations = 16;
+    int positionIterations = 4;
+    bool warmStart = true;
+    // Approach speeds below this do not bounce, so resting contacts stay at rest
+    float restitutionThreshold = 0.02f;
+
+    // Islands are solved on this many lanes of the shared JobSystem once a step has at
+    // least parallelContacts contacts; 0 uses every worker and the calling thread
+    unsigned threadCount = 1;
+    size_t parallelContacts = 256;
+
+    // Sorts contacts into solve order, solves them, changes the balls' velocities and
+    // positions and keeps the impulses for the next step
+    void solve(BallStore& balls, std::vector<SolverContact>& contacts);
+
+    // Islands and contacts in the largest one, from the last solve()
+    size_t islandCount() const { return islandStart.empty() ? 0 : islandStart.size() - 1; }
+    size_t largestIsland() const { return largest; }
+
+    void clearWarmStart() { cache.clear(); }
+
+    size_t memoryBytes() const;
+
+private:
+    struct CachedImpulse {
+        uint64_t key;
+        float impulse;
+    };
+
+    // Impulses of the last solve by key, sorted
+    std::vector<CachedImpulse> cache;
+
+    // Union-find over ball indices, then contacts grouped by island:
+    // islandContacts[islandStart[k]..islandStart[k + 1]) are island k's, in key order,
+    // and sourceContact gives each one's index in the caller's contacts
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> rootIsland;
+    std::vector<uint32_t> contactIsland;
+    std::vector<uint32_t> islandStart;
+    std::vector<uint32_t> islandFill;
+    std::vector<SolverContact> islandContacts;
+    std::vector<uint32_t> sourceContact;
+    size_t largest = 0;
+
+    void prepare(const BallStore& balls, std::vector<SolverContact>& contacts) const;
+    void buildIslands(size_t ballCount, const std::vector<SolverContact>& contacts);
+    void solveIsland(BallStore& balls, SolverContact* contacts, size_t count) const;
+    uint32_t root(uint32_t i);
+};
+
+#endif
@@ -0,0 +1,388 @@
+#include "EventSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double never = std::numeric_limits<double>::infinity();
+
+// Polynomials are stored lowest power first: c[0] + c[1] t + ... + c[degree] t^degree
+double evaluate(const double* c, int degree, double t) {
+    double value = c[degree];
+    for (int k = degree - 1; k >= 0; k--) {
+        value = value * t + c[k];
+    }
+    return value;
+}
+
+int effectiveDegree(const double* c, int degree) {
+    double scale = 0.0;
+    for (int k = 0; k <= degree; k++) scale = std::max(scale, std::abs(c[k]));
+    while (degree > 0 && std::abs(c[degree]) <= 1e-14 * scale) degree--;
+    return degree;
+}
+
+// Root of f in [lo, hi] given a sign change: Newton steps, falling back to
+// bisection whenever a step would leave the bracket.
+double refine(const double* c, int degree, double lo, double hi) {
+    bool positiveLo = evaluate(c, degree, lo) > 0.0;
+    double t = 0.5 * (lo + hi);
+
+    for (int k = 0; k < 100; k++) {
+        double value = c[degree], slope = 0.0;
+        for (int m = degree - 1; m >= 0; m--) {
+            slope = slope * t + value;
+            value = value * t + c[m];
+        }
+        if (value == 0.0) return t;
+
+        if ((value > 0.0) == positiveLo) lo = t;
+        else hi = t;
+
+        double next = slope != 0.0 ? t - value / slope : lo;
+        if (!(next > lo && next < hi)) next = 0.5 * (lo + hi);
+        if (std::abs(next - t) < 1e-13 || hi - lo < 1e-13) return next;
+        t = next;
+    }
+    return t;
+}
+
+// Sorted real roots in (lo, hi), at most degree of them. Roots of the derivative
+// split the range into monotonic pieces, each holding at most one root.
+int realRoots(const double* c, int degree, double lo, double hi, double* roots) {
+    degree = effectiveDegree(c, degree);
+    int count = 0;
+
+    if (degree == 0) return 0;
+    if (degree == 1) {
+        double t = -c[0] / c[1];
+        if (t > lo && t < hi) roots[count++] = t;
+        return count;
+    }
+    if (degree == 2) {
+        double disc = c[1] * c[1] - 4.0 * c[2] * c[0];
+        if (disc < 0.0) return 0;
+        double q = -0.5 * (c[1] + std::copysign(std::sqrt(disc), c[1]));
+        double t1 = q / c[2];
+        double t2 = q != 0.0 ? c[0] / q : t1;
+        if (t1 > t2) std::swap(t1, t2);
+        if (t1 > lo && t1 < hi) roots[count++] = t1;
+        if (t2 > lo && t2 < hi && t2 != t1) roots[count++] = t2;
+        return count;
+    }
+
+    double derivative[4];
+    for (int k = 1; k <= degree; k++) derivative[k - 1] = k * c[k];
+
+    double breaks[6];
+    breaks[0] = lo;
+    int breakCount = 1 + realRoots(derivative, degree - 1, lo, hi, breaks + 1);
+    breaks[breakCount++] = hi;
+
+    for (int k = 0; k + 1 < breakCount; k++) {
+        double a = breaks[k], b = breaks[k + 1];
+        double fa = evaluate(c, degree, a), fb = evaluate(c, degree, b);
+        if (fa == 0.0 && a > lo) roots[count++] = a;
+        else if ((fa > 0.0) != (fb > 0.0) && fb != 0.0) roots[count++] = refine(c, degree, a, b);
+    }
+    return count;
+}
+
+// Earliest t in [0, tMax] where f goes from positive to non-positive, i.e. the
+// moment a distance function reaches its contact value while closing in.
+double firstEntry(const double* c, int degree, double tMax) {
+    if (tMax <= 0.0) return never;
+
+    // Already touching: only an immediate event if still closing in
+    if (evaluate(c, degree, 0.0) <= 0.0 && c[1] < 0.0) return 0.0;
+
+    double derivative[4];
+    for (int k = 1; k <= degree; k++) derivative[k - 1] = k * c[k];
+
+    double breaks[6];
+    breaks[0] = 0.0;
+    int breakCount = 1 + realRoots(derivative, degree - 1, 0.0, tMax, breaks + 1);
+    breaks[breakCount++] = tMax;
+
+    for (int k = 0; k + 1 < breakCount; k++) {
+        double a = breaks[k], b = breaks[k + 1];
+        if (evaluate(c, degree, a) > 0.0 && evaluate(c, degree, b) <= 0.0) {
+            return refine(c, degree, a, b);
+        }
+    }
+    return never;
+}
+
+// |A + B t + C t^2|^2 - R^2 as a quartic
+void distanceQuartic(glm::dvec2 A, glm::dvec2 B, glm::dvec2 C, double R, double* c) {
+    c[4] = glm::dot(C, C);
+    c[3] = 2.0 * glm::dot(B, C);
+    c[2] = glm::dot(B, B) + 2.0 * glm::dot(A, C);
+    c[1] = 2.0 * glm::dot(A, B);
+    c[0] = glm::dot(A, A) - R * R;
+}
+
+}
+
+EventSimulator::EventSimulator(const World& world)
+    : edges(world.edges),
+    pockets(world.pockets) {
+    const BallStore& store = world.balls;
+
+    for (size_t i = 0; i < store.size(); i++) {
+        balls.push_back({ glm::dvec2(store.x[i], store.z[i]), glm::dvec2(store.vx[i], store.vz[i]), store.pocketed(i) });
+        radius.push_back(store.radius[i]);
+        mass.push_back(store.mass[i]);
+        restitution.push_back(store.restitution[i]);
+        friction.push_back(store.friction[i]);
+        number.push_back(store.number[i]);
+    }
+
+    timeline.push_back({ 0.0, balls });
+
+    ballEvents.resize(balls.size());
+    pairTimes.assign(balls.size() * balls.size(), never);
+    for (size_t i = 0; i < balls.size(); i++) {
+        scheduleBall(i);
+    }
+}
+
+double EventSimulator::simulateToRest(double maxTime) {
+    // Guards against Zeno-style event storms in degenerate (e.g. wedged) layouts
+    const size_t maxEvents = 100000;
+
+    while (events.size() < maxEvents) {
+        SimEvent event = findNextEvent();
+        if (event.time == never || event.time > maxTime) break;
+
+        advance(balls, event.time - now);
+        now = event.time;
+        apply(event);
+
+        scheduleBall(event.ballA);
+        if (event.type == SIM_BALL_CONTACT) scheduleBall(event.ballB);
+
+        // Events are searched by index; report ball numbers like World does
+        event.ballA = number[event.ballA];
+        if (event.type == SIM_BALL_CONTACT) event.ballB = number[event.ballB];
+
+        events.push_back(event);
+        timeline.push_back({ now, balls });
+    }
+
+    return now;
+}
+
+void EventSimulator::stateAt(double t, World& world) const {
+    t = std::max(t, 0.0);
+
+    // Last keyframe at or before t
+    auto it = std::upper_bound(timeline.begin(), timeline.end(), t,
+        [](double value, const Keyframe& key) { return value < key.time; });
+    const Keyframe& key = *(it - 1);
+
+    std::vector<Motion> state = key.balls;
+    advance(state, t - key.time);
+
+    // By number, since the world may have reordered its balls since construction
+    BallStore& store = world.balls;
+    for (size_t i = 0; i < state.size(); i++) {
+        int index = store.indexOf(number[i]);
+        if (index < 0) continue;
+
+        store.setPosition(index, glm::vec2(state[i].position));
+        store.setVelocity(index, glm::vec2(state[i].velocity));
+        store.setPocketed(index, state[i].pocketed);
+    }
+}
+
+void EventSimulator::advance(std::vector<Motion>& state, double deltaTime) const {
+    if (deltaTime <= 0.0) return;
+
+    for (size_t i = 0; i < state.size(); i++) {
+        Motion& ball = state[i];
+        if (ball.pocketed) continue;
+
+        double speed = glm::length(ball.velocity);
+        if (speed <= 0.0) continue;
+
+        glm::dvec2 direction = ball.velocity / speed;
+        double tau = std::min(deltaTime, speed / friction[i]);
+        ball.position += direction * (speed * tau - 0.5 * friction[i] * tau * tau);
+
+        double newSpeed = speed - friction[i] * tau;
+        ball.velocity = newSpeed > 1e-12 ? direction * newSpeed : glm::dvec2(0.0);
+    }
+}
+
+double EventSimulator::stopTime(size_t i) const {
+    double speed = glm::length(balls[i].velocity);
+    return speed > 0.0 ? speed / friction[i] : never;
+}
+
+void EventSimulator::scheduleBall(size_t i) {
+    SimEvent best = { never, SIM_BALL_STOP, (int)i, -1 };
+    auto consider = [&](double dt, SimEventType type, int other) {
+        if (now + dt < best.time) best = { now + dt, type, (int)i, other };
+    };
+
+    if (!balls[i].pocketed && glm::length(balls[i].velocity) > 0.0) {
+        consider(stopTime(i), SIM_BALL_STOP, -1);
+
+        for (size_t e = 0; e < edges.size(); e++) {
+            consider(edgeContactTime(i, edges[e]), SIM_CUSHION_CONTACT, (int)e);
+        }
+        for (const Pocket& pocket : pockets) {
+            consider(pointEntryTime(i, glm::dvec2(pocket.position), pocket.radius), SIM_POCKETED, -1);
+        }
+    }
+    ballEvents[i] = best;
+
+    size_t n = balls.size();
+    for (size_t j = 0; j < n; j++) {
+        if (j == i) continue;
+        size_t a = std::min(i, j), b = std::max(i, j);
+        bool active = !balls[a].pocketed && !balls[b].pocketed;
+        pairTimes[a * n + b] = active ? now + ballContactTime(a, b) : never;
+    }
+}
+
+SimEvent EventSimulator::findNextEvent() {
+    eventSearches++;
+
+    SimEvent best = { never, SIM_BALL_STOP, -1, -1 };
+    size_t n = balls.size();
+
+    for (size_t i = 0; i < n; i++) {
+        if (ballEvents[i].time < best.time) best = ballEvents[i];
+
+        for (size_t j = i + 1; j < n; j++) {
+            if (pairTimes[i * n + j] < best.time) best = { pairTimes[i * n + j], SIM_BALL_CONTACT, (int)i, (int)j };
+        }
+    }
+
+    return best;
+}
+
+double EventSimulator::ballContactTime(size_t i, size_t j) const {
+    const Motion& a = balls[i];
+    const Motion& b = balls[j];
+
+    double speedA = glm::length(a.velocity);
+    double speedB = glm::length(b.velocity);
+    if (speedA <= 0.0 && speedB <= 0.0) return never;
+
+    // Neither ball can travel far enough to close the gap
+    glm::dvec2 A = b.position - a.position;
+    double R = radius[i] + radius[j];
+    double reachA = speedA * speedA / (2.0 * friction[i]);
+    double reachB = speedB * speedB / (2.0 * friction[j]);
+    if (glm::length(A) - R > reachA + reachB) return never;
+
+    glm::dvec2 decelA = speedA > 0.0 ? a.velocity * (friction[i] / speedA) : glm::dvec2(0.0);
+    glm::dvec2 decelB = speedB > 0.0 ? b.velocity * (friction[j] / speedB) : glm::dvec2(0.0);
+
+    // Valid until the first of the two balls stops; that stop is an event of its own
+    double horizon = std::min(stopTime(i), stopTime(j));
+
+    double c[5];
+    distanceQuartic(A, b.velocity - a.velocity, 0.5 * (decelA - decelB), R, c);
+    return firstEntry(c, 4, horizon);
+}
+
+double EventSimulator::pointEntryTime(size_t i, glm::dvec2 point, double distance) const {
+    const Motion& ball = balls[i];
+
+    double speed = glm::length(ball.velocity);
+    glm::dvec2 A = ball.position - point;
+    if (glm::length(A) - distance > speed * speed / (2.0 * friction[i])) return never;
+
+    double c[5];
+    distanceQuartic(A, ball.velocity, -0.5 * ball.velocity * (friction[i] / speed), distance, c);
+    return firstEntry(c, 4, stopTime(i));
+}
+
+double EventSimulator::edgeContactTime(size_t i, const Edge& edge) const {
+    const Motion& ball = balls[i];
+
+    glm::dvec2 start(edge.start);
+    glm::dvec2 end(edge.end);
+    double length = glm::length(end - start);
+    glm::dvec2 direction = (end - start) / length;
+    glm::dvec2 normal(-direction.y, direction.x);
+
+    double contact = radius[i] + edge.cushionWidth;
+    double speed = glm::length(ball.velocity);
+    double horizon = stopTime(i);
+
+    // Cushions are capsules around their segment; far enough away to never reach it?
+    glm::dvec2 offset = ball.position - start;
+    double along = glm::clamp(glm::dot(offset, direction), 0.0, length);
+    if (glm::length(offset - direction * along) - contact > speed * speed / (2.0 * friction[i])) return never;
+
+    glm::dvec2 decel = ball.velocity * (friction[i] / speed);
+    double best = never;
+
+    // Flat face on whichever side the ball is
+    double side = glm::dot(offset, normal) >= 0.0 ? 1.0 : -1.0;
+    double c[5] = {
+        side * glm::dot(offset, normal) - contact,
+        side * glm::dot(ball.velocity, normal),
+        side * glm::dot(-0.5 * decel, normal),
+        0.0, 0.0
+    };
+    double t = firstEntry(c, 2, horizon);
+    if (t != never) {
+        glm::dvec2 p = ball.position + ball.velocity * t - 0.5 * decel * t * t;
+        double u = glm::dot(p - start, direction);
+        if (u >= 0.0 && u <= length) best = t;
+    }
+
+    // Rounded ends
+    best = std::min(best, pointEntryTime(i, start, contact));
+    best = std::min(best, pointEntryTime(i, end, contact));
+    return best;
+}
+
+void EventSimulator::apply(const SimEvent& event) {
+    switch (event.type) {
+    case SIM_BALL_STOP: {
+        balls[event.ballA].velocity = glm::dvec2(0.0);
+        break;
+    }
+    case SIM_POCKETED: {
+        balls[event.ballA].pocketed = true;
+        balls[event.ballA].velocity = glm::dvec2(0.0);
+        break;
+    }
+    case SIM_CUSHION_CONTACT: {
+        Motion& ball = balls[event.ballA];
+        const Edge& edge = edges[event.ballB];
+
+        glm::dvec2 start(edge.start);
+        glm::dvec2 segment = glm::dvec2(edge.end) - start;
+        double t = glm::clamp(glm::dot(ball.position - start, segment) / glm::dot(segment, segment), 0.0, 1.0);
+        glm::dvec2 normal = glm::normalize(ball.position - (start + segment * t));
+
+        double velocityAlongNormal = glm::dot(ball.velocity, normal);
+        if (velocityAlongNormal < 0.0) {
+            ball.velocity -= (1.0 + restitution[event.ballA]) * velocityAlongNormal * normal;
+        }
+        break;
+    }
+    case SIM_BALL_CONTACT: {
+        size_t i = event.ballA, j = event.ballB;
+        glm::dvec2 normal = glm::normalize(balls[j].position - balls[i].position);
+        double velocityAlongNormal = glm::dot(balls[j].velocity - balls[i].velocity, normal);
+
+        if (velocityAlongNormal < 0.0) {
+            double combinedRestitution = (restitution[i] + restitution[j]) * 0.5;
+            double impulse = -(1.0 + combinedRestitution) * velocityAlongNormal / (1.0 / mass[i] + 1.0 / mass[j]);
+            balls[i].velocity -= normal * (impulse / mass[i]);
+            balls[j].velocity += normal * (impulse / mass[j]);
+        }
+        break;
+    }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef EVENT_SIMULATOR_H
+#define EVENT_SIMULATOR_H
+
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "World.h"
+
+enum SimEventType {
+    SIM_BALL_CONTACT = 0,
+    SIM_CUSHION_CONTACT = 1,
+    SIM_POCKETED = 2,
+    SIM_BALL_STOP = 3
+};
+
+// ballA/ballB are ball numbers; for cushion contacts ballB is the edge index
+struct SimEvent {
+    double time;
+    SimEventType type;
+    int ballA;
+    int ballB;
+};
+
+// Event-driven alternative to World::step(). Between events every ball follows the
+// closed-form constant-deceleration path p(t) = p + v t - f t^2 v/(2|v|), so the
+// simulator solves for the exact time of the next ball contact, cushion contact,
+// pocket capture or stop and jumps straight there. Contacts use the same impulse
+// rules as World but need no positional correction.
+class EventSimulator {
+public:
+    explicit EventSimulator(const World& world);
+
+    // Runs until every ball is at rest or pocketed (or maxTime) and returns that time
+    double simulateToRest(double maxTime = 120.0);
+
+    // Writes the state at time t into world's balls. Keyframes are stored after every
+    // event, so this is a binary search plus one analytic advance; times past the
+    // last simulated event are extrapolated without further contacts.
+    void stateAt(double t, World& world) const;
+
+    const std::vector<SimEvent>& getEvents() const { return events; }
+    double getTime() const { return now; }
+
+    // Number of events searched for (one per simulated event plus the final one)
+    size_t getEventSearches() const { return eventSearches; }
+
+private:
+    struct Motion {
+        glm::dvec2 position;
+        glm::dvec2 velocity;
+        bool pocketed;
+    };
+
+    struct Keyframe {
+        double time;
+        std::vector<Motion> balls;
+    };
+
+    std::vector<Motion> balls;
+    std::vector<double> radius;
+    std::vector<double> mass;
+    std::vector<double> restitution;
+    std::vector<double> friction;
+    std::vector<int> number;
+
+    std::vector<Edge> edges;
+    std::vector<Pocket> pockets;
+
+    std::vector<SimEvent> events;
+    std::vector<Keyframe> timeline;
+    double now = 0.0;
+    size_t eventSearches = 0;
+
+    // Absolute time of each ball's own next event (stop, cushion or pocket) and of
+    // the next contact for every pair (row-major, i < j). An event only changes the
+    // paths of the balls it involves, so only those get rescheduled.
+    std::vector<SimEvent> ballEvents;
+    std::vector<double> pairTimes;
+
+    void scheduleBall(size_t i);
+    SimEvent findNextEvent();
+    void advance(std::vector<Motion>& state, double deltaTime) const;
+    void apply(const SimEvent& event);
+
+    double stopTime(size_t i) const;
+    double ballContactTime(size_t i, size_t j) const;
+    double edgeContactTime(size_t i, const Edge& edge) const;
+    double pointEntryTime(size_t i, glm::dvec2 point, double distance) const;
+};
+
+#endif
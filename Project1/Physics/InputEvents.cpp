@@ -0,0 +1,80 @@
+#include "InputEvents.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char inputLogMagic[4] = { 'B', 'I', 'N', '1' };
+const size_t recordSize = 20;
+
+void putBits(uint8_t* p, uint64_t bits, int bytes) {
+    for (int i = 0; i < bytes; i++) p[i] = (uint8_t)(bits >> (8 * i));
+}
+
+uint64_t getBits(const uint8_t* p, int bytes) {
+    uint64_t bits = 0;
+    for (int i = 0; i < bytes; i++) bits |= (uint64_t)p[i] << (8 * i);
+    return bits;
+}
+
+}
+
+bool saveInputLog(const std::string& path, const std::vector<InputEvent>& events, std::string& error) {
+    std::vector<uint8_t> bytes(4 + events.size() * recordSize);
+    std::memcpy(bytes.data(), inputLogMagic, 4);
+
+    uint8_t* p = bytes.data() + 4;
+    for (const InputEvent& event : events) {
+        uint64_t time;
+        uint32_t x, y;
+        std::memcpy(&time, &event.time, 8);
+        std::memcpy(&x, &event.x, 4);
+        std::memcpy(&y, &event.y, 4);
+        putBits(p, time, 8);
+        p[8] = event.type;
+        p[9] = event.mods;
+        putBits(p + 10, (uint16_t)event.code, 2);
+        putBits(p + 12, x, 4);
+        putBits(p + 16, y, 4);
+        p += recordSize;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool loadInputLog(const std::string& path, std::vector<InputEvent>& events, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 4 || std::memcmp(bytes.data(), inputLogMagic, 4) != 0 || (bytes.size() - 4) % recordSize != 0) {
+        error = path + ": not an input log";
+        return false;
+    }
+
+    events.resize((bytes.size() - 4) / recordSize);
+    const uint8_t* p = bytes.data() + 4;
+    for (InputEvent& event : events) {
+        uint64_t time = getBits(p, 8);
+        uint32_t x = (uint32_t)getBits(p + 12, 4);
+        uint32_t y = (uint32_t)getBits(p + 16, 4);
+        std::memcpy(&event.time, &time, 8);
+        event.type = p[8];
+        event.mods = p[9];
+        event.code = (int16_t)getBits(p + 10, 2);
+        std::memcpy(&event.x, &x, 4);
+        std::memcpy(&event.y, &y, 4);
+        p += recordSize;
+    }
+    return true;
+}
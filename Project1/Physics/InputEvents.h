@@ -0,0 +1,39 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SpscQueue.h"
+
+enum InputEventType {
+    INPUT_KEY_DOWN = 0,
+    INPUT_KEY_UP = 1,
+    INPUT_BUTTON_DOWN = 2,
+    INPUT_BUTTON_UP = 3,
+    INPUT_CURSOR = 4
+};
+
+// One key, mouse button or cursor change as the window reported it. Codes and
+// modifier bits are the windowing library's; the physics library only stores them.
+struct InputEvent {
+    // Seconds on the window clock when the event arrived
+    double time = 0.0;
+    uint8_t type = INPUT_KEY_DOWN;
+    uint8_t mods = 0;
+    int16_t code = 0;
+    // Cursor position in window pixels
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// Window callbacks push; the game loop drains it once per frame
+typedef SpscQueue<InputEvent, 1024> InputQueue;
+
+// An input log is the events a game consumed, in order, as fixed 20-byte little-endian records after
+// a 4-byte magic ("BIN1"), so a session can be fed back in or timed afterwards
+bool saveInputLog(const std::string& path, const std::vector<InputEvent>& events, std::string& error);
+bool loadInputLog(const std::string& path, std::vector<InputEvent>& events, std::string& error);
+
+#endif
@@ -0,0 +1,227 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+namespace {
+
+// Set on each worker thread to its system and queue
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local unsigned currentQueue = 0;
+
+template <typename Queue>
+bool popJob(Queue& queue, bool newest, JobHandle& job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+    if (newest) {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+    }
+    else {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+    }
+    return true;
+}
+
+}
+
+JobSystem::JobSystem(unsigned workerCount) : mainThread(std::this_thread::get_id()) {
+    if (workerCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for (unsigned q = 0; q <= workerCount; q++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned w = 0; w < workerCount; w++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, w);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::shared() {
+    static JobSystem system;
+    return system;
+}
+
+unsigned JobSystem::queueIndex() const {
+    return currentSystem == this ? currentQueue : 0;
+}
+
+JobHandle JobSystem::submit(std::function<void()> work, const std::vector<JobHandle>& dependencies) {
+    return create(std::move(work), dependencies, false);
+}
+
+JobHandle JobSystem::submitMain(std::function<void()> work, const std::vector<JobHandle>& dependencies) {
+    return create(std::move(work), dependencies, true);
+}
+
+JobHandle JobSystem::create(std::function<void()> work, const std::vector<JobHandle>& dependencies, bool mainThread) {
+    JobHandle job = std::make_shared<Job>();
+    job->work = std::move(work);
+    job->mainThread = mainThread;
+
+    for (const JobHandle& dependency : dependencies) {
+        if (!dependency) continue;
+        std::lock_guard<std::mutex> lock(dependency->dependentsMutex);
+        if (dependency->finished.load(std::memory_order_relaxed)) continue;
+        job->waitingFor.fetch_add(1, std::memory_order_relaxed);
+        dependency->dependents.push_back(job);
+    }
+
+    // Drop submit()'s own hold; the last dependency to finish queues it otherwise
+    if (job->waitingFor.fetch_sub(1, std::memory_order_acq_rel) == 1) enqueue(job);
+    return job;
+}
+
+void JobSystem::enqueue(JobHandle job) {
+    if (job->mainThread) {
+        std::lock_guard<std::mutex> lock(mainQueue.mutex);
+        mainQueue.jobs.push_back(std::move(job));
+        return;
+    }
+
+    WorkQueue& queue = *queues[queueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    // A worker counts itself asleep before it checks queued, and this counts the job
+    // before it checks for sleepers, so one of the two sees the other
+    queued.fetch_add(1);
+    if (sleepers.load() > 0) {
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+}
+
+// The main thread's own jobs first, then this worker's newest, then the oldest shared
+// job, then the oldest job of the next worker round from this one that has any
+bool JobSystem::runOne() {
+    JobHandle job;
+    if (onMainThread() && popJob(mainQueue, false, job)) {
+        execute(std::move(job));
+        return true;
+    }
+
+    unsigned own = queueIndex();
+    bool found = (own != 0 && popJob(*queues[own], true, job)) || popJob(*queues[0], false, job);
+    if (!found) {
+        unsigned workerTotal = workerCount();
+        for (unsigned k = 0; k < workerTotal && !found; k++) {
+            unsigned victim = 1 + (own + k) % workerTotal;
+            if (victim == own) continue;
+            found = popJob(*queues[victim], false, job);
+            if (found) stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!found) return false;
+
+    queued.fetch_sub(1);
+    execute(std::move(job));
+    return true;
+}
+
+void JobSystem::execute(JobHandle job) {
+    job->work();
+    job->work = nullptr;
+
+    std::vector<JobHandle> ready;
+    {
+        std::lock_guard<std::mutex> lock(job->dependentsMutex);
+        job->finished.store(true, std::memory_order_release);
+        ready.swap(job->dependents);
+    }
+    executed.fetch_add(1, std::memory_order_relaxed);
+
+    for (JobHandle& dependent : ready) {
+        if (dependent->waitingFor.fetch_sub(1, std::memory_order_acq_rel) == 1) enqueue(std::move(dependent));
+    }
+}
+
+void JobSystem::wait(const JobHandle& job) {
+    while (!finished(job)) {
+        if (!runOne()) std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1) {
+        if (count > 0) body(0, count);
+        return;
+    }
+
+    // Helpers that only start after the loop has finished find no chunk left and
+    // return, touching nothing but this
+    struct Loop {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+    };
+    std::shared_ptr<Loop> loop = std::make_shared<Loop>();
+    const std::function<void(size_t, size_t)>* run = &body;
+    auto claim = [loop, run, count, grain, chunks]() {
+        for (size_t c = loop->next++; c < chunks; c = loop->next++) {
+            size_t begin = c * grain;
+            (*run)(begin, std::min(begin + grain, count));
+            loop->done.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    size_t helpers = std::min<size_t>(workerCount(), chunks - 1);
+    for (size_t h = 0; h < helpers; h++) {
+        submit(claim);
+    }
+    claim();
+
+    // The chunks still running were claimed by threads that are running them, so
+    // this only waits for those; it does not take on other work meanwhile
+    while (loop->done.load(std::memory_order_acquire) < chunks) {
+        std::this_thread::yield();
+    }
+}
+
+size_t JobSystem::runMainThreadJobs() {
+    size_t waiting;
+    {
+        std::lock_guard<std::mutex> lock(mainQueue.mutex);
+        waiting = mainQueue.jobs.size();
+    }
+
+    // Only the jobs already waiting, so one that queues another cannot hold the frame
+    size_t ran = 0;
+    JobHandle job;
+    while (ran < waiting && popJob(mainQueue, false, job)) {
+        execute(std::move(job));
+        ran++;
+    }
+    return ran;
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    currentSystem = this;
+    currentQueue = index + 1;
+
+    while (true) {
+        if (runOne()) continue;
+        if (stopping) break;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepers.fetch_add(1);
+        wake.wait(lock, [this]() { return queued.load() > 0 || stopping; });
+        sleepers.fetch_sub(1);
+    }
+}
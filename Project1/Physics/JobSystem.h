@@ -0,0 +1,119 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One piece of work for a JobSystem. The system holds a job until it has run; a
+// JobHandle keeps it for whoever waits on it.
+struct Job {
+    std::function<void()> work;
+    // Run on the main thread only, e.g. for OpenGL calls
+    bool mainThread = false;
+
+    // Unfinished dependencies, plus one that submit() drops once the job is wired up
+    std::atomic<int> waitingFor{ 1 };
+    std::atomic<bool> finished{ false };
+
+    // Jobs that depend on this one; guarded so a dependency cannot finish while a new
+    // dependent is being added
+    std::mutex dependentsMutex;
+    std::vector<std::shared_ptr<Job>> dependents;
+};
+
+typedef std::shared_ptr<Job> JobHandle;
+
+// Runs jobs on a fixed set of worker threads, so features share the cores instead of
+// each starting threads of its own.
+//
+// Each worker has a deque: a job submitted from a worker goes on the back of its own
+// deque, the worker takes its newest job first, and idle workers steal the oldest job
+// from the front of another's. Jobs submitted from other threads go on a shared deque
+// that every worker takes from. A job may depend on others and is only queued once
+// they have all finished. Main-thread jobs wait in a queue of their own until the main
+// thread runs them in runMainThreadJobs() or wait().
+//
+// wait() runs other jobs while it waits, so a job may wait on jobs it submitted
+// without tying up its worker.
+class JobSystem {
+public:
+    // 0 starts a worker per hardware thread but one, for the thread that submits, and
+    // always at least one. The thread that constructs the system is its main thread.
+    explicit JobSystem(unsigned workerCount = 0);
+    // Finishes every queued job other than main-thread ones, then stops the workers
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // The job system features share, started on first use; first use should be on the
+    // main thread
+    static JobSystem& shared();
+
+    unsigned workerCount() const { return (unsigned)queues.size() - 1; }
+    bool onMainThread() const { return std::this_thread::get_id() == mainThread; }
+
+    // Queues work to run on any thread once every job in dependencies has finished
+    JobHandle submit(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+    // The same, but the job only runs on the main thread
+    JobHandle submitMain(std::function<void()> work, const std::vector<JobHandle>& dependencies = {});
+
+    static bool finished(const JobHandle& job) { return job->finished.load(std::memory_order_acquire); }
+
+    // Runs other jobs until job has finished
+    void wait(const JobHandle& job);
+
+    // Calls body(begin, end) for chunks of at most grain indices covering [0, count),
+    // on this thread and on any idle workers, and returns once every chunk is done.
+    // Chunks are taken in index order, one at a time, so long and short chunks balance.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    // Runs every main-thread job that is ready; the game calls it once per frame.
+    // Returns how many ran.
+    size_t runMainThreadJobs();
+
+    // Jobs run, and jobs a worker took from another worker's deque, since construction
+    uint64_t jobsRun() const { return executed.load(std::memory_order_relaxed); }
+    uint64_t jobsStolen() const { return stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+
+    // queues[0] is shared by every thread that is not a worker; queues[1 + w] is
+    // worker w's. All are made before the workers start, and workers is not read by
+    // them, as it is still growing while the first ones run.
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    WorkQueue mainQueue;
+    std::vector<std::thread> workers;
+    std::thread::id mainThread;
+
+    // Jobs in queues; it can dip below zero while a pop overtakes the count of its push
+    std::atomic<int64_t> queued{ 0 };
+    std::atomic<unsigned> sleepers{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    std::atomic<uint64_t> executed{ 0 };
+    std::atomic<uint64_t> stolen{ 0 };
+
+    JobHandle create(std::function<void()> work, const std::vector<JobHandle>& dependencies, bool mainThread);
+    void enqueue(JobHandle job);
+    bool runOne();
+    void execute(JobHandle job);
+    void workerLoop(unsigned index);
+    // This thread's queue: its own if it is one of this system's workers, else 0
+    unsigned queueIndex() const;
+};
+
+#endif
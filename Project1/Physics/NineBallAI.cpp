@@ -0,0 +1,182 @@
+#include "NineBallAI.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const float twoPi = 6.2831853f;
+
+const float winScore = 1000.0f;
+const float foulScore = -200.0f;
+const float keepTurnScore = 100.0f;
+const float pocketedBallScore = 10.0f;
+
+// Per metre between the cue ball and the next ball: close is good position for the
+// shooter, far is a good safety when the turn passes
+const float positionScore = 10.0f;
+const float safetyScore = 5.0f;
+
+float angleTowards(glm::vec2 from, glm::vec2 to) {
+    glm::vec2 d = to - from;
+    return std::atan2(d.x, d.y);
+}
+
+}
+
+AISettings aiSettingsFor(AIDifficulty difficulty) {
+    switch (difficulty) {
+    case AI_EASY:
+        return { 36, 1, 4, 0.1, 0.03f, 0.1f };
+    case AI_HARD:
+        return { 180, 6, 12, 2.0, 0.002f, 0.01f };
+    default:
+        return { 90, 3, 8, 0.5, 0.01f, 0.05f };
+    }
+}
+
+NineBallAI::NineBallAI(AIDifficulty difficulty, uint32_t seed)
+    : settings(aiSettingsFor(difficulty)), rng(seed) {
+}
+
+float NineBallAI::scoreOutcome(const ShotOutcome& outcome) {
+    // evaluateTurn() awards the game to whoever is up after the shot
+    if (outcome.gameOver) return outcome.keepsTurn ? winScore : -winScore;
+    if (outcome.foul) return foulScore;
+
+    float distance = glm::length(outcome.cueBallPosition - outcome.lowestBallPosition);
+    if (outcome.keepsTurn) {
+        return keepTurnScore + pocketedBallScore * outcome.ballsPocketed.size() - positionScore * distance;
+    }
+    return safetyScore * distance;
+}
+
+bool NineBallAI::scoreHigher(const Scored& l, const Scored& r) {
+    return l.score > r.score;
+}
+
+void NineBallAI::evaluateCandidates(const World& world, const NineBallRules& rules) {
+    evaluator.evaluate(world, rules, candidates, outcomes);
+    for (size_t i = 0; i < candidates.size(); i++) {
+        scored.push_back({ candidates[i], scoreOutcome(outcomes[i]) });
+    }
+    candidates.clear();
+}
+
+AIDecision NineBallAI::chooseShot(const World& world, const NineBallRules& rules) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    auto elapsed = [&]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+    // Without a time budget the search depends only on its inputs, so decisions repeat
+    // exactly whatever the thread count or machine speed
+    auto outOfTime = [&]() { return settings.timeBudget > 0.0 && elapsed() >= settings.timeBudget; };
+
+    scored.clear();
+    candidates.clear();
+
+    int cueBall = world.findBall(cueBallNumber);
+    int target = world.findBall(rules.lowestBallNumber);
+    glm::vec2 cuePosition = cueBall >= 0 ? world.balls.position(cueBall) : glm::vec2(0.0f);
+
+    // Aimed shots first: full ball on the ball on, and the ghost-ball angle that cuts it
+    // towards each pocket
+    std::vector<float> angles;
+    if (target >= 0) {
+        glm::vec2 targetPosition = world.balls.position(target);
+        angles.push_back(angleTowards(cuePosition, targetPosition));
+
+        float contact = world.balls.radius[target] + (cueBall >= 0 ? world.balls.radius[cueBall] : ballRadius);
+        for (const Pocket& pocket : world.pockets) {
+            glm::vec2 toPocket = pocket.position - targetPosition;
+            if (glm::dot(toPocket, toPocket) <= 0.0f) continue;
+            glm::vec2 ghost = targetPosition - glm::normalize(toPocket) * contact;
+            angles.push_back(angleTowards(cuePosition, ghost));
+        }
+    }
+    for (int a = 0; a < settings.fanAngles; a++) {
+        angles.push_back(twoPi * a / settings.fanAngles);
+    }
+
+    for (float angle : angles) {
+        for (float power : shotPowers) {
+            candidates.push_back({ angle, power });
+        }
+    }
+
+    // The first batch is the aimed shots, so even a tiny budget plays something sensible
+    size_t aimed = (angles.size() - settings.fanAngles) * shotPowerLevels;
+    std::vector<ShotCandidate> all;
+    all.swap(candidates);
+    size_t batch = std::max<size_t>(aimed, 64);
+    for (size_t from = 0; from < all.size(); from += batch) {
+        if (from > 0 && outOfTime()) break;
+        candidates.assign(all.begin() + from, all.begin() + std::min(all.size(), from + batch));
+        evaluateCandidates(world, rules);
+    }
+
+    // Narrow in around the best shots, halving the angle step each round
+    float step = twoPi / std::max(settings.fanAngles, 1) * 0.5f;
+    for (int round = 0; round < settings.refineRounds && !outOfTime(); round++) {
+        std::stable_sort(scored.begin(), scored.end(), scoreHigher);
+
+        size_t keep = std::min<size_t>(settings.refineCandidates, scored.size());
+        for (size_t k = 0; k < keep; k++) {
+            ShotCandidate best = scored[k].shot;
+            candidates.push_back({ best.angle - step, best.power });
+            candidates.push_back({ best.angle + step, best.power });
+            candidates.push_back({ best.angle - step * 0.5f, best.power });
+            candidates.push_back({ best.angle + step * 0.5f, best.power });
+        }
+        evaluateCandidates(world, rules);
+        step *= 0.5f;
+    }
+
+    std::stable_sort(scored.begin(), scored.end(), scoreHigher);
+
+    AIDecision decision;
+    decision.intended = scored.empty() ? ShotCandidate{ 0.0f, shotPowers[0] } : scored.front().shot;
+    decision.score = scored.empty() ? 0.0f : scored.front().score;
+    decision.shotsEvaluated = scored.size();
+
+    // A shot that only works at its exact angle is no use to a player who cannot cue
+    // that precisely, so the best few are rescored by their average over the aim error
+    size_t keep = std::min<size_t>(settings.refineCandidates, scored.size());
+    if (settings.aimNoise > 0.0f && keep > 1) {
+        const float spread[] = { -2.0f, -1.0f, 1.0f, 2.0f };
+        for (size_t k = 0; k < keep; k++) {
+            for (float s : spread) {
+                candidates.push_back({ scored[k].shot.angle + s * settings.aimNoise, scored[k].shot.power });
+            }
+        }
+        evaluator.evaluate(world, rules, candidates, outcomes);
+        decision.shotsEvaluated += candidates.size();
+        candidates.clear();
+
+        const size_t samples = sizeof(spread) / sizeof(spread[0]);
+        for (size_t k = 0; k < keep; k++) {
+            float total = scored[k].score;
+            for (size_t i = 0; i < samples; i++) {
+                total += scoreOutcome(outcomes[k * samples + i]);
+            }
+            float average = total / (samples + 1);
+            if (k == 0 || average > decision.score) {
+                decision.intended = scored[k].shot;
+                decision.score = average;
+            }
+        }
+    }
+
+    decision.shot = decision.intended;
+    if (settings.aimNoise > 0.0f) {
+        decision.shot.angle += std::normal_distribution<float>(0.0f, settings.aimNoise)(rng);
+    }
+    if (settings.powerNoise > 0.0f) {
+        float error = std::normal_distribution<float>(0.0f, settings.powerNoise)(rng);
+        decision.shot.power = glm::clamp(decision.shot.power * (1.0f + error), shotPowers[0], shotPowers[shotPowerLevels - 1]);
+    }
+
+    decision.seconds = elapsed();
+    return decision;
+}
@@ -0,0 +1,77 @@
+#ifndef NINE_BALL_AI_H
+#define NINE_BALL_AI_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "ShotEvaluator.h"
+
+// The five cue powers selected by keys 1-5 in the game
+const int shotPowerLevels = 5;
+const float shotPowers[shotPowerLevels] = { 2.0f, 4.0f, 6.0f, 8.0f, 10.0f };
+
+enum AIDifficulty {
+    AI_EASY = 0,
+    AI_MEDIUM = 1,
+    AI_HARD = 2
+};
+
+// How hard the computer looks and how well it cues
+struct AISettings {
+    int fanAngles;          // evenly spaced angles tried all around the cue ball
+    int refineRounds;       // rounds of narrowing in around the best shots
+    int refineCandidates;   // shots kept for each refinement round
+    double timeBudget;      // seconds of search per shot, 0 for none; refinement stops when it runs out
+    float aimNoise;         // standard deviation of the angle error in radians
+    float powerNoise;       // standard deviation of the relative power error
+};
+
+AISettings aiSettingsFor(AIDifficulty difficulty);
+
+struct AIDecision {
+    ShotCandidate intended; // best shot the search found
+    ShotCandidate shot;     // what is actually played, with the aim noise applied
+    float score;            // expected over the aim error when there is any
+    size_t shotsEvaluated;
+    double seconds;
+};
+
+// Computer opponent for 9-ball. Each decision plays candidate shots through a
+// ShotEvaluator: straight at the ball on and at the ghost-ball angle for every pocket,
+// then a fan of angles all around, each at all five powers. The best shots are then
+// refined with ever smaller angle changes until the rounds or the time budget run out,
+// and the finalists are rescored over the aim error of the difficulty. Outcomes are
+// scored with the game's rules.
+class NineBallAI {
+public:
+    AISettings settings;
+    ShotEvaluator evaluator;
+
+    explicit NineBallAI(AIDifficulty difficulty = AI_MEDIUM, uint32_t seed = 1);
+
+    void setDifficulty(AIDifficulty difficulty) { settings = aiSettingsFor(difficulty); }
+
+    AIDecision chooseShot(const World& world, const NineBallRules& rules);
+
+    // Higher is better for the player taking the shot
+    static float scoreOutcome(const ShotOutcome& outcome);
+
+private:
+    std::mt19937 rng;
+
+    std::vector<ShotCandidate> candidates;
+    std::vector<ShotOutcome> outcomes;
+
+    // Every candidate evaluated so far this decision, best first after each round
+    struct Scored {
+        ShotCandidate shot;
+        float score;
+    };
+    std::vector<Scored> scored;
+    static bool scoreHigher(const Scored& l, const Scored& r);
+
+    void evaluateCandidates(const World& world, const NineBallRules& rules);
+};
+
+#endif
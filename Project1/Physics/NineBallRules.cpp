@@ -0,0 +1,114 @@
+#include "NineBallRules.h"
+
+NineBallRules::NineBallRules() {
+    reset();
+}
+
+void NineBallRules::reset() {
+    currentPlayer = 1;
+    lowestBallNumber = 1;
+    firstBallHit = -1;
+    firstBallHitCorrect = false;
+    ballsPocketedThisTurn = false;
+    foulThisTurn = false;
+    playerWon = 0;
+    foulPosition = glm::vec2(-1.0f, 0.0f);
+}
+
+void NineBallRules::beginShot() {
+    firstBallHit = -1;
+    firstBallHitCorrect = false;
+    ballsPocketedThisTurn = false;
+    foulThisTurn = false;
+}
+
+void NineBallRules::processEvents(const World& world, const std::vector<WorldEvent>& events) {
+    bool anyPocketed = false;
+
+    for (const WorldEvent& event : events) {
+        if (event.type == BALL_CONTACT) {
+            // Only the first cue ball contact of the turn matters
+            if (firstBallHit != -1) continue;
+
+            if (event.ballA == cueBallNumber) {
+                firstBallHit = event.ballB;
+            }
+            else if (event.ballB == cueBallNumber) {
+                firstBallHit = event.ballA;
+            }
+            else {
+                continue;
+            }
+
+            firstBallHitCorrect = (firstBallHit == lowestBallNumber);
+        }
+        else if (event.type == BALL_POCKETED) {
+            anyPocketed = true;
+
+            if (event.ballA == cueBallNumber) {
+                // Scratch
+                handleFoul();
+            }
+            else {
+                ballsPocketedThisTurn = true;
+            }
+        }
+    }
+
+    if (anyPocketed) {
+        lowestBallNumber = findLowestBallNumber(world);
+    }
+}
+
+TurnResult NineBallRules::evaluateTurn(const World& world) {
+    TurnResult result = { false, false };
+
+    // If wrong ball was hit first, it's a foul
+    if (!firstBallHitCorrect) {
+        handleFoul();
+    }
+
+    // If no balls were pocketed, switch players
+    if (!ballsPocketedThisTurn && firstBallHitCorrect) {
+        currentPlayer = (currentPlayer == 1) ? 2 : 1;
+    }
+
+    // If the 9-ball was pocketed the game is over; on a foul the player switch already
+    // happened, so the current player is the winner either way
+    int nineBall = world.findBall(9);
+    if (nineBall >= 0 && world.balls.pocketed(nineBall)) {
+        playerWon = currentPlayer;
+        result.gameOver = true;
+    }
+
+    // If there was a foul this turn, reset the cue ball position
+    int cueBall = world.findBall(cueBallNumber);
+    result.respotCueBall = foulThisTurn || (cueBall >= 0 && world.balls.pocketed(cueBall));
+
+    // Reset turn tracking variables
+    firstBallHit = -1;
+    firstBallHitCorrect = false;
+    ballsPocketedThisTurn = false;
+
+    return result;
+}
+
+int NineBallRules::findLowestBallNumber(const World& world) const {
+    int lowest = 9;
+
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        int number = world.balls.number[i];
+        if (number != cueBallNumber && !world.balls.pocketed(i) && number < lowest) {
+            lowest = number;
+        }
+    }
+
+    return lowest;
+}
+
+void NineBallRules::handleFoul() {
+    // Switch players
+    currentPlayer = (currentPlayer == 1) ? 2 : 1;
+
+    foulThisTurn = true;
+}
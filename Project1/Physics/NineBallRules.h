@@ -0,0 +1,40 @@
+#ifndef NINE_BALL_RULES_H
+#define NINE_BALL_RULES_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "World.h"
+
+// What the game has to do once the balls come to rest after a shot.
+struct TurnResult {
+    bool respotCueBall;
+    bool gameOver;
+};
+
+class NineBallRules {
+public:
+    int currentPlayer;
+    int lowestBallNumber;
+    int firstBallHit;
+    bool firstBallHitCorrect;
+    bool ballsPocketedThisTurn;
+    bool foulThisTurn;
+    int playerWon;
+    glm::vec2 foulPosition;
+
+    NineBallRules();
+
+    void reset();
+    void beginShot();
+
+    // Consumes the contact/pocket events produced by World::step()
+    void processEvents(const World& world, const std::vector<WorldEvent>& events);
+    TurnResult evaluateTurn(const World& world);
+
+private:
+    int findLowestBallNumber(const World& world) const;
+    void handleFoul();
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef PHYSICS_CONSTANTS_H
+#define PHYSICS_CONSTANTS_H
+
+const float ballRadius = 0.08f;
+const float ballMass = 1.5f;
+const float ballRestitution = 0.8f;
+const float ballFriction = 0.25f;
+const float stopSpeed = 0.01f;
+const float frameTime = 1.0f / 120.0f;
+
+// MOTION_SPIN: cloth friction coefficient while a ball's contact point slips, with
+// gravity giving its deceleration; the angular deceleration of spin about the
+// vertical (rad/s^2); and the cushions' friction coefficient, which turns side spin
+// into sideways speed
+const float gravity = 9.81f;
+const float ballSlidingFriction = 0.2f;
+const float ballSpinDeceleration = 12.0f;
+const float cushionFriction = 0.2f;
+
+// 16 fractional bits for World::fixedPoint
+const float fixedPointScale = 65536.0f;
+
+const int cueBallNumber = 0;
+#endif
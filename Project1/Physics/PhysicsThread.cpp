@@ -0,0 +1,120 @@
+#include "PhysicsThread.h"
+
+#include <algorithm>
+#include <chrono>
+
+PhysicsThread::PhysicsThread(World& world, std::function<void(float)> step, std::function<void(SimulationSnapshot&)> publish)
+    : world(world), step(step), publish(publish) {
+}
+
+PhysicsThread::~PhysicsThread() {
+    stop();
+}
+
+double PhysicsThread::now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PhysicsThread::start() {
+    if (running()) return;
+    stopRequested = false;
+    thread = std::thread(&PhysicsThread::loop, this);
+}
+
+void PhysicsThread::stop() {
+    if (!running()) return;
+    stopRequested = true;
+    thread.join();
+}
+
+void PhysicsThread::update(double elapsed) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    tick(elapsed);
+}
+
+void PhysicsThread::withState(const std::function<void()>& f) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    f();
+    statePlaced = true;
+}
+
+float PhysicsThread::interpolationAlpha() const {
+    if (!running()) return scheduler.interpolationAlpha();
+
+    // The thread publishes right after stepping, so the time since then is how far the
+    // next step has come
+    double since = now() - snapshot().publishTime;
+    return (float)std::min(std::max(since / scheduler.stepTime, 0.0), 1.0);
+}
+
+void PhysicsThread::loop() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(scheduler.stepTime));
+
+    Clock::time_point last = Clock::now();
+    Clock::time_point next = last + period;
+    while (!stopRequested) {
+        Clock::time_point current = Clock::now();
+        double elapsed = std::chrono::duration<double>(current - last).count();
+        last = current;
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            tick(elapsed);
+        }
+
+        // A tick that overran starts the schedule afresh rather than rushing to catch
+        // up; the scheduler already counts the time as dropped or owed
+        next += period;
+        if (next < Clock::now()) next = Clock::now() + period;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void PhysicsThread::tick(double elapsed) {
+    scheduler.advance(world, elapsed, [this](float deltaTime) {
+        keepPositions(beforeStep);
+        step(deltaTime);
+    });
+
+    // Only steps and withState() change anything worth showing
+    bool stepped = scheduler.frame.worldSteps > 0;
+    if (!stepped && !statePlaced && ticks > 0) return;
+
+    // Balls placed since the last step are drawn where they are
+    if (!stepped) keepPositions(beforeStep);
+    statePlaced = false;
+
+    SimulationSnapshot& out = snapshots.back();
+    out.sequence = ++ticks;
+    out.publishTime = now();
+
+    keepPositions(out.positions);
+    out.previous = beforeStep;
+    out.present.assign(out.positions.size(), 0);
+    out.pocketed.assign(out.positions.size(), 0);
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        int number = world.balls.number[i];
+        out.present[number] = 1;
+        out.pocketed[number] = world.balls.pocketed(i);
+    }
+    out.atRest = world.isAtRest();
+
+    out.frame = scheduler.frame;
+    out.total = scheduler.total;
+    out.mostStepsPerFrame = scheduler.mostStepsPerFrame;
+
+    publish(out);
+    snapshots.publish();
+}
+
+void PhysicsThread::keepPositions(std::vector<glm::vec2>& positions) const {
+    size_t numbers = 0;
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        numbers = std::max(numbers, (size_t)world.balls.number[i] + 1);
+    }
+    positions.assign(numbers, glm::vec2(0.0f));
+    for (size_t i = 0; i < world.balls.size(); i++) {
+        positions[world.balls.number[i]] = world.balls.position(i);
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef PHYSICS_THREAD_H
+#define PHYSICS_THREAD_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "World.h"
+#include "NineBallRules.h"
+#include "StepScheduler.h"
+#include "TripleBuffer.h"
+
+// Everything the renderer reads about the game, copied out after the physics ticks.
+// Ball data is indexed by ball number.
+struct SimulationSnapshot {
+    // Counts snapshots; 0 before the first
+    uint64_t sequence = 0;
+    // Steady clock seconds at which it was published
+    double publishTime = 0.0;
+
+    std::vector<glm::vec2> previous;  // before the last step
+    std::vector<glm::vec2> positions;
+    std::vector<uint8_t> present;     // a ball with this number exists
+    std::vector<uint8_t> pocketed;
+    bool atRest = true;
+
+    // Filled by the owner's publish function
+    NineBallRules rules;
+    bool canShoot = true;
+    bool gameOver = false;
+    // Counts finished turns, so the reader can tell a new one came in
+    uint32_t turns = 0;
+    bool respotted = false;
+
+    SchedulerMetrics frame;
+    SchedulerMetrics total;
+    int mostStepsPerFrame = 0;
+
+    bool hasBall(int number) const { return number >= 0 && number < (int)present.size() && present[number]; }
+};
+
+// Runs a world's fixed steps either on a thread of its own, at the step rate, or in
+// update() calls from the owner's thread. Either way the owner reads snapshots: the
+// renderer never waits for the physics, and the physics never waits for a frame.
+//
+// step(dt) and publish(snapshot) run on the physics side with the state lock held;
+// they may touch world and whatever else the owner keeps for them. Anything else
+// that touches that state must go through withState().
+class PhysicsThread {
+public:
+    StepScheduler scheduler;
+
+    PhysicsThread(World& world, std::function<void(float)> step, std::function<void(SimulationSnapshot&)> publish);
+    ~PhysicsThread();
+
+    PhysicsThread(const PhysicsThread&) = delete;
+    PhysicsThread& operator=(const PhysicsThread&) = delete;
+
+    void start();
+    void stop();
+    bool running() const { return thread.joinable(); }
+
+    // Without the thread: advances by elapsed seconds and publishes, on this thread
+    void update(double elapsed);
+
+    // Runs f between two physics ticks, e.g. to strike the cue ball or copy the world.
+    // The next tick publishes the result.
+    void withState(const std::function<void()>& f);
+
+    // Takes the newest snapshot; call once per frame, then read snapshot()
+    void acquire() { snapshots.acquire(); }
+    const SimulationSnapshot& snapshot() const { return snapshots.front(); }
+
+    // How far the physics has got from the snapshot's last step towards the next one,
+    // in [0, 1], to draw the balls between the two
+    float interpolationAlpha() const;
+
+    static double now();
+
+private:
+    World& world;
+    std::function<void(float)> step;
+    std::function<void(SimulationSnapshot&)> publish;
+
+    std::mutex stateMutex;
+    std::thread thread;
+    std::atomic<bool> stopRequested{ false };
+    TripleBuffer<SimulationSnapshot> snapshots;
+    uint64_t ticks = 0;
+
+    // Positions by number before the last step
+    std::vector<glm::vec2> beforeStep;
+    // Set by withState(), whose changes the next tick publishes even without a step
+    bool statePlaced = true;
+
+    void loop();
+    void tick(double elapsed);
+    void keepPositions(std::vector<glm::vec2>& positions) const;
+};
+
+#endif
@@ -0,0 +1,591 @@
+#include "Replay.h"
+#include "BoundaryField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const uint8_t replayMagic[4] = { 'B', 'R', 'P', 'L' };
+const size_t indexEntrySize = 16;
+const size_t trailerSize = 12;
+
+// Values per ball in a captured state: x, z, vx, vz, wx, wy, wz. Keyframes store the
+// spin only for MOTION_SPIN worlds.
+const int ballValues = 7;
+const int rollingBallValues = 4;
+
+enum ReplayFlags : uint8_t {
+    REPLAY_CONTINUOUS = 1u << 0,
+    REPLAY_FIXED_POINT = 1u << 1,
+    REPLAY_BOUNDARY_FIELD = 1u << 2,
+    REPLAY_FIELD_CUSHIONS = 1u << 3,
+    REPLAY_ISLAND_CONTACTS = 1u << 4,
+    // Two bits of Integrator
+    REPLAY_INTEGRATOR_SHIFT = 5,
+    REPLAY_INTEGRATOR_MASK = 3u << 5,
+    REPLAY_SPIN = 1u << 7
+};
+
+void putU8(std::vector<uint8_t>& out, uint8_t value) {
+    out.push_back(value);
+}
+
+void putU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back((uint8_t)value);
+    out.push_back((uint8_t)(value >> 8));
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int byte = 0; byte < 4; byte++) out.push_back((uint8_t)(value >> (8 * byte)));
+}
+
+void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int byte = 0; byte < 8; byte++) out.push_back((uint8_t)(value >> (8 * byte)));
+}
+
+void putF32(std::vector<uint8_t>& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(out, bits);
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// Small magnitudes of either sign become small varints
+void putSigned(std::vector<uint8_t>& out, int64_t value) {
+    putVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+uint32_t loadU32(const uint8_t* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Bounds-checked reads from the mapped file; any overrun clears ok and reads zeros
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+
+    Reader(const uint8_t* begin, const uint8_t* stop) : p(begin), end(stop), ok(true) {}
+
+    bool need(size_t bytes) {
+        if (ok && (size_t)(end - p) >= bytes) return true;
+        ok = false;
+        return false;
+    }
+
+    uint8_t u8() { return need(1) ? *p++ : 0; }
+
+    uint16_t u16() {
+        if (!need(2)) return 0;
+        uint16_t value = (uint16_t)(p[0] | p[1] << 8);
+        p += 2;
+        return value;
+    }
+
+    uint32_t u32() {
+        if (!need(4)) return 0;
+        uint32_t value = loadU32(p);
+        p += 4;
+        return value;
+    }
+
+    uint64_t u64() {
+        uint64_t low = u32();
+        return low | (uint64_t)u32() << 32;
+    }
+
+    float f32() {
+        uint32_t bits = u32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+};
+
+// High bit of a ball's flags byte: its values follow as raw f32 rather than fixed point
+const uint8_t replayRawValues = 0x80;
+
+// State of every ball, in the order of numbers
+void captureState(const World& world, const std::vector<int>& numbers, std::vector<float>& state, std::vector<uint8_t>& flags) {
+    state.resize(numbers.size() * ballValues);
+    flags.resize(numbers.size());
+    for (size_t b = 0; b < numbers.size(); b++) {
+        int i = world.findBall(numbers[b]);
+        float* values = &state[b * ballValues];
+        values[0] = world.balls.x[i];
+        values[1] = world.balls.z[i];
+        values[2] = world.balls.vx[i];
+        values[3] = world.balls.vz[i];
+        values[4] = world.balls.wx[i];
+        values[5] = world.balls.wy[i];
+        values[6] = world.balls.wz[i];
+        flags[b] = (uint8_t)world.balls.flags[i];
+    }
+}
+
+bool sameBits(const float* l, const float* r, int count) {
+    return std::memcmp(l, r, count * sizeof(float)) == 0;
+}
+
+// Every ball that has moved in a fixed-point world is on the 16.16 grid and is
+// written as deltas from base. The rest (the rack, a fresh strike) go out raw.
+void putBall(std::vector<uint8_t>& out, uint8_t flags, const float* values, const float* base, int count) {
+    // Compared bit for bit, since -0.0 would come back as 0.0
+    bool onGrid = true;
+    for (int v = 0; v < count; v++) {
+        float back = fromFixedPoint(toFixedPoint(values[v]));
+        onGrid = onGrid && std::fabs(values[v]) < 32768.0f && std::memcmp(&back, &values[v], sizeof(float)) == 0;
+    }
+
+    if (!onGrid) {
+        putU8(out, flags | replayRawValues);
+        for (int v = 0; v < count; v++) putF32(out, values[v]);
+        return;
+    }
+
+    putU8(out, flags);
+    for (int v = 0; v < count; v++) {
+        putSigned(out, (int64_t)toFixedPoint(values[v]) - (base ? toFixedPoint(base[v]) : 0));
+    }
+}
+
+void readBall(Reader& in, uint8_t& flags, float* values, const float* base, int count) {
+    flags = in.u8();
+    if (flags & replayRawValues) {
+        flags &= ~replayRawValues;
+        for (int v = 0; v < count; v++) values[v] = in.f32();
+        return;
+    }
+
+    for (int v = 0; v < count; v++) {
+        values[v] = fromFixedPoint((int32_t)(in.signedVarint() + (base ? toFixedPoint(base[v]) : 0)));
+    }
+}
+
+}
+
+void ReplayRecorder::begin(const World& world) {
+    header.clear();
+    shots.clear();
+    index.clear();
+    shotOffsets.clear();
+    shotOpen = false;
+    nextStep = 0;
+
+    header.insert(header.end(), replayMagic, replayMagic + 4);
+    putU16(header, replayVersion);
+    putU16(header, keyframeInterval);
+    bool field = world.boundary && !world.boundary->empty();
+    putU8(header, (world.continuousCollision ? REPLAY_CONTINUOUS : 0) | (world.fixedPoint ? REPLAY_FIXED_POINT : 0) |
+        (field ? REPLAY_BOUNDARY_FIELD : 0) | (world.cushionModel == CUSHION_FIELD ? REPLAY_FIELD_CUSHIONS : 0) |
+        (world.contactModel == CONTACTS_ISLANDS ? REPLAY_ISLAND_CONTACTS : 0) |
+        (((unsigned)world.integrator << REPLAY_INTEGRATOR_SHIFT) & REPLAY_INTEGRATOR_MASK) |
+        (world.motionModel == MOTION_SPIN ? REPLAY_SPIN : 0));
+    putU8(header, (uint8_t)world.broadPhase.type);
+    storedValues = world.motionModel == MOTION_SPIN ? ballValues : rollingBallValues;
+
+    // Add order, so the player's world compacts pocketed balls into the same order
+    std::vector<size_t> added(world.balls.size());
+    for (size_t i = 0; i < added.size(); i++) added[i] = i;
+    std::sort(added.begin(), added.end(), [&world](size_t l, size_t r) {
+        return world.balls.addOrder(l) < world.balls.addOrder(r);
+    });
+
+    numbers.clear();
+    putU16(header, (uint16_t)added.size());
+    for (size_t i : added) {
+        numbers.push_back(world.balls.number[i]);
+        putSigned(header, world.balls.number[i]);
+        putF32(header, world.balls.radius[i]);
+        putF32(header, world.balls.mass[i]);
+        putF32(header, world.balls.restitution[i]);
+        putF32(header, world.balls.friction[i]);
+    }
+
+    putU8(header, (uint8_t)world.edges.size());
+    for (const Edge& edge : world.edges) {
+        const float values[] = { edge.start.x, edge.start.y, edge.end.x, edge.end.y, edge.normal.x, edge.normal.y, edge.cushionWidth };
+        for (float value : values) putF32(header, value);
+    }
+
+    putU8(header, (uint8_t)world.pockets.size());
+    for (const Pocket& pocket : world.pockets) {
+        putF32(header, pocket.position.x);
+        putF32(header, pocket.position.y);
+        putF32(header, pocket.radius);
+    }
+
+    // The field is rebuilt from the edges above, so only its grid and jaws are stored
+    if (field) {
+        const BoundaryField& boundary = *world.boundary;
+        const float grid[] = { boundary.cellSize, boundary.areaMin.x, boundary.areaMin.y, boundary.areaMax.x, boundary.areaMax.y };
+        for (float value : grid) putF32(header, value);
+
+        putU8(header, (uint8_t)boundary.jaws.size());
+        for (const CushionJaw& jaw : boundary.jaws) {
+            putF32(header, jaw.centre.x);
+            putF32(header, jaw.centre.y);
+            putF32(header, jaw.radius);
+        }
+    }
+}
+
+void ReplayRecorder::beginShot(const World& world, ShotCandidate input) {
+    if (!isRecording()) return;
+
+    shotOpen = true;
+    shot = input;
+    shotStart = nextStep;
+    shotSteps = 0;
+    keyframes.clear();
+    addKeyframe(world, true);
+}
+
+void ReplayRecorder::recordStep(const World& world) {
+    if (!shotOpen) return;
+
+    shotSteps++;
+    if (shotSteps % keyframeInterval == 0) {
+        addKeyframe(world, false);
+    }
+}
+
+void ReplayRecorder::addKeyframe(const World& world, bool first) {
+    std::vector<float> state;
+    std::vector<uint8_t> flags;
+    captureState(world, numbers, state, flags);
+
+    std::vector<uint8_t> data;
+    if (first) {
+        startState = state;
+        startFlags = flags;
+        for (size_t b = 0; b < numbers.size(); b++) {
+            putBall(data, flags[b], &state[b * ballValues], nullptr, storedValues);
+        }
+    }
+    else {
+        // Balls that have not moved since the strike, typically most of them, cost one bit
+        data.resize((numbers.size() + 7) / 8, 0);
+        for (size_t b = 0; b < numbers.size(); b++) {
+            const float* now = &state[b * ballValues];
+            const float* start = &startState[b * ballValues];
+            if (sameBits(now, start, storedValues) && flags[b] == startFlags[b]) continue;
+
+            data[b / 8] |= (uint8_t)(1u << (b % 8));
+            putBall(data, flags[b], now, start, storedValues);
+        }
+    }
+    keyframes.push_back(data);
+}
+
+void ReplayRecorder::endShot(const World& world) {
+    if (!shotOpen) return;
+    shotOpen = false;
+
+    uint32_t shotOffset = (uint32_t)shots.size();
+    uint32_t shotNumber = (uint32_t)shotOffsets.size();
+    shotOffsets.push_back(shotOffset);
+
+    putU32(shots, shotStart);
+    putF32(shots, shot.angle);
+    putF32(shots, shot.power);
+    putF32(shots, shot.tipOffset.x);
+    putF32(shots, shot.tipOffset.y);
+    putVarint(shots, shotSteps);
+    putU64(shots, world.stateHash);
+    putVarint(shots, keyframes.size());
+
+    for (size_t k = 0; k < keyframes.size(); k++) {
+        putVarint(shots, keyframes[k].size());
+        index.push_back({ shotStart + (uint32_t)(k * keyframeInterval), (uint32_t)shots.size(), shotOffset, shotNumber });
+        shots.insert(shots.end(), keyframes[k].begin(), keyframes[k].end());
+    }
+
+    nextStep = shotStart + shotSteps + 1;
+}
+
+std::vector<uint8_t> ReplayRecorder::finish() const {
+    std::vector<uint8_t> out(header);
+    out.insert(out.end(), shots.begin(), shots.end());
+
+    uint32_t base = (uint32_t)header.size();
+    uint32_t indexOffset = (uint32_t)out.size();
+    for (const IndexEntry& entry : index) {
+        putU32(out, entry.step);
+        putU32(out, base + entry.keyframe);
+        putU32(out, base + entry.shot);
+        putU32(out, entry.shotNumber);
+    }
+
+    putU32(out, indexOffset);
+    putU32(out, (uint32_t)index.size());
+    out.insert(out.end(), replayMagic, replayMagic + 4);
+    return out;
+}
+
+bool ReplayRecorder::save(const std::string& path) const {
+    std::vector<uint8_t> bytes = finish();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    return (bool)out;
+}
+
+bool ReplayPlayer::open(const std::string& path) {
+    close();
+    if (!file.open(path) || file.size() < 4 + trailerSize) {
+        close();
+        return false;
+    }
+
+    const uint8_t* bytes = file.data();
+    const uint8_t* trailer = bytes + file.size() - trailerSize;
+    uint32_t indexOffset = loadU32(trailer);
+    uint32_t count = loadU32(trailer + 4);
+    if (std::memcmp(trailer + 8, replayMagic, 4) != 0 || count == 0 ||
+        (uint64_t)indexOffset + (uint64_t)count * indexEntrySize != file.size() - trailerSize) {
+        close();
+        return false;
+    }
+
+    Reader in(bytes, bytes + indexOffset);
+    uint8_t magic[4] = { in.u8(), in.u8(), in.u8(), in.u8() };
+    uint16_t version = in.u16();
+    keyframeInterval = in.u16();
+    uint8_t flags = in.u8();
+    uint8_t broadPhaseType = in.u8();
+    if (!in.ok || std::memcmp(magic, replayMagic, 4) != 0 || version != replayVersion || keyframeInterval == 0) {
+        close();
+        return false;
+    }
+
+    world = World();
+    world.deterministic = true;
+    world.fixedPoint = (flags & REPLAY_FIXED_POINT) != 0;
+    world.continuousCollision = (flags & REPLAY_CONTINUOUS) != 0;
+    world.contactModel = (flags & REPLAY_ISLAND_CONTACTS) ? CONTACTS_ISLANDS : CONTACTS_PAIRWISE;
+    world.integrator = (Integrator)((flags & REPLAY_INTEGRATOR_MASK) >> REPLAY_INTEGRATOR_SHIFT);
+    world.motionModel = (flags & REPLAY_SPIN) ? MOTION_SPIN : MOTION_ROLLING;
+    storedValues = world.motionModel == MOTION_SPIN ? ballValues : rollingBallValues;
+    world.broadPhase.type = (BroadPhaseType)broadPhaseType;
+
+    uint16_t ballCount = in.u16();
+    for (uint16_t b = 0; b < ballCount && in.ok; b++) {
+        int number = (int)in.signedVarint();
+        PhysicsBall ball(0.0f, 0.0f, in.f32(), number);
+        ball.mass = in.f32();
+        ball.restitution = in.f32();
+        ball.friction = in.f32();
+        world.balls.add(ball);
+        numbers.push_back(number);
+    }
+
+    uint8_t edgeCount = in.u8();
+    for (uint8_t e = 0; e < edgeCount && in.ok; e++) {
+        float values[7];
+        for (float& value : values) value = in.f32();
+        world.edges.push_back(Edge(glm::vec2(values[0], values[1]), glm::vec2(values[2], values[3]),
+            glm::vec2(values[4], values[5]), values[6]));
+    }
+
+    uint8_t pocketCount = in.u8();
+    for (uint8_t p = 0; p < pocketCount && in.ok; p++) {
+        float x = in.f32();
+        float z = in.f32();
+        world.pockets.push_back(Pocket(glm::vec2(x, z), in.f32()));
+    }
+    world.pocketZone = pocketFreeZone(world.pockets);
+
+    if (flags & REPLAY_BOUNDARY_FIELD) {
+        std::shared_ptr<BoundaryField> field = std::make_shared<BoundaryField>();
+        field->cellSize = in.f32();
+        glm::vec2 min, max;
+        min.x = in.f32();
+        min.y = in.f32();
+        max.x = in.f32();
+        max.y = in.f32();
+
+        std::vector<CushionJaw> jaws(in.u8());
+        for (CushionJaw& jaw : jaws) {
+            jaw.centre.x = in.f32();
+            jaw.centre.y = in.f32();
+            jaw.radius = in.f32();
+        }
+        if (in.ok) {
+            field->build(world.edges, jaws, min, max);
+            world.boundary = field;
+        }
+    }
+    world.cushionModel = (flags & REPLAY_FIELD_CUSHIONS) ? CUSHION_FIELD : CUSHION_SEGMENTS;
+
+    entries = bytes + indexOffset;
+    entryCount = count;
+
+    // The last shot ends the timeline
+    uint32_t last = entryCount - 1;
+    Reader lastShot(bytes + entryField(last, 2), entries);
+    uint32_t lastStart = lastShot.u32();
+    for (int v = 0; v < 4; v++) lastShot.f32();
+    totalSteps = lastStart + lastShot.varint() + 1;
+    shotTotal = entryField(last, 3) + 1;
+
+    if (!in.ok || !lastShot.ok || !restore(0)) {
+        close();
+        return false;
+    }
+    time = 0.0;
+    return true;
+}
+
+void ReplayPlayer::close() {
+    file.close();
+    numbers.clear();
+    entries = nullptr;
+    entryCount = 0;
+    totalSteps = 0;
+    shotTotal = 0;
+    step = 0;
+    time = 0.0;
+    shotNumber = -1;
+}
+
+uint32_t ReplayPlayer::entryField(uint32_t entry, int field) const {
+    return loadU32(entries + entry * indexEntrySize + field * 4);
+}
+
+bool ReplayPlayer::restore(uint32_t entry) {
+    const uint8_t* end = entries;
+    uint32_t keyframeOffset = entryField(entry, 1);
+    uint32_t offset = entryField(entry, 2);
+    if (offset >= (uint32_t)(end - file.data()) || keyframeOffset >= (uint32_t)(end - file.data())) return false;
+
+    Reader in(file.data() + offset, end);
+    uint32_t start = in.u32();
+    ShotCandidate input;
+    input.angle = in.f32();
+    input.power = in.f32();
+    input.tipOffset.x = in.f32();
+    input.tipOffset.y = in.f32();
+    uint64_t steps = in.varint();
+    uint64_t hash = in.u64();
+    in.varint();
+    in.varint();
+
+    // The first keyframe is the base every later one is a delta from
+    std::vector<float> state(numbers.size() * ballValues);
+    std::vector<uint8_t> flags(numbers.size());
+    for (size_t b = 0; b < numbers.size(); b++) {
+        readBall(in, flags[b], &state[b * ballValues], nullptr, storedValues);
+    }
+
+    if (entryField(entry, 0) != start) {
+        std::vector<float> base(state);
+        Reader delta(file.data() + keyframeOffset, end);
+        const uint8_t* mask = delta.p;
+        if (!delta.need((numbers.size() + 7) / 8)) return false;
+        delta.p += (numbers.size() + 7) / 8;
+        for (size_t b = 0; b < numbers.size(); b++) {
+            if ((mask[b / 8] & (1u << (b % 8))) == 0) continue;
+            readBall(delta, flags[b], &state[b * ballValues], &base[b * ballValues], storedValues);
+        }
+        if (!delta.ok) return false;
+    }
+    if (!in.ok) return false;
+
+    for (size_t b = 0; b < numbers.size(); b++) {
+        int i = world.findBall(numbers[b]);
+        const float* values = &state[b * ballValues];
+        world.balls.setFlags(i, flags[b]);
+        world.balls.setPosition(i, glm::vec2(values[0], values[1]));
+        world.balls.vx[i] = values[2];
+        world.balls.vz[i] = values[3];
+        world.balls.wx[i] = values[4];
+        world.balls.wy[i] = values[5];
+        world.balls.wz[i] = values[6];
+    }
+    world.events.clear();
+    // Keyframes hold no contact impulses; a shot starts without any
+    world.solver.clearWarmStart();
+
+    step = entryField(entry, 0);
+    shotNumber = (int)entryField(entry, 3);
+    shotStart = start;
+    shotEnd = start + (size_t)steps;
+    shotOffset = offset;
+    shotInput = input;
+    shotHash = hash;
+    return true;
+}
+
+void ReplayPlayer::stepForward(size_t target) {
+    while (step < target) {
+        if (step == shotEnd) {
+            // The next shot starts from its own first keyframe, after any respotting
+            seekStep(step + 1);
+            continue;
+        }
+
+        world.step(frameTime);
+        world.events.clear();
+        step++;
+    }
+}
+
+void ReplayPlayer::seekStep(size_t target) {
+    if (!isOpen()) return;
+    target = std::min(target, totalSteps - 1);
+
+    bool stepOn = target >= step && target <= shotEnd && target - step <= keyframeInterval;
+    if (!stepOn) {
+        // Last keyframe at or before target
+        uint32_t low = 0;
+        uint32_t high = entryCount;
+        while (high - low > 1) {
+            uint32_t middle = (low + high) / 2;
+            if (entryField(middle, 0) <= target) low = middle;
+            else high = middle;
+        }
+        if (!restore(low)) return;
+    }
+
+    stepForward(target);
+    time = step * (double)frameTime;
+}
+
+void ReplayPlayer::seek(double seconds) {
+    seekStep((size_t)std::max(0.0, std::floor(seconds / frameTime)));
+}
+
+void ReplayPlayer::advance(double realSeconds) {
+    if (!isOpen() || paused) return;
+
+    double next = std::min(std::max(time + realSeconds * speed, 0.0), (totalSteps - 1) * (double)frameTime);
+    seekStep((size_t)std::floor(next / frameTime));
+    time = next;
+}
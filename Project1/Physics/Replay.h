@@ -0,0 +1,153 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "World.h"
+#include "ShotEvaluator.h"
+#include "MappedFile.h"
+
+// Binary replay of a run of shots. A deterministic world reproduces a shot exactly
+// from its starting state, so a shot is stored as its input plus keyframes: the full
+// state right after the cue strike, and every keyframeInterval steps the balls that
+// differ from it. Values are 16.16 fixed point, zigzag varint encoded, or raw f32 for
+// balls not on that grid (flags bit 7). A trailing index of fixed-size entries, one
+// per keyframe, allows seeking by binary search.
+//
+// Layout, little endian:
+//   header   "BRPL", version u16, keyframeInterval u16, flags u8, broad phase u8,
+//            balls u16 (number varint, radius, mass, restitution, friction f32 each,
+//            in add order), edges u8 (7 f32 each), pockets u8 (3 f32 each), and
+//            with a boundary field (flags bit 2) its cell size, min x, z and max x, z
+//            f32 and jaws u8 (3 f32 each)
+//   shots    first global step u32, angle, power, tip offset x and y f32, steps
+//            varint, final stateHash u64, keyframes varint, then per keyframe its
+//            length varint and data: the first holds flags u8 and x, z, vx, vz (then
+//            wx, wy, wz for MOTION_SPIN, header flags bit 7) of every ball, the others a
+//            changed-ball bit mask, then flags and deltas from the first for those
+//   index    per keyframe: global step u32, keyframe offset u32, shot offset u32,
+//            shot number u32
+//   trailer  index offset u32, entry count u32, "BRPL"
+const uint16_t replayVersion = 3;
+
+// Keyframes are exact only if the recorded world has deterministic and fixedPoint set.
+class ReplayRecorder {
+public:
+    // Steps between keyframes; seeking replays at most this many steps
+    uint16_t keyframeInterval = 240;
+
+    // Starts a new recording of world's table and balls
+    void begin(const World& world);
+
+    // Call right after strikeCueBall(), then recordStep() after every step until the
+    // balls come to rest, then endShot()
+    void beginShot(const World& world, ShotCandidate shot);
+    void recordStep(const World& world);
+    void endShot(const World& world);
+
+    bool isRecording() const { return !header.empty(); }
+    bool inShot() const { return shotOpen; }
+    size_t shotCount() const { return shotOffsets.size(); }
+
+    // Header, shots, index and trailer
+    std::vector<uint8_t> finish() const;
+    bool save(const std::string& path) const;
+
+private:
+    std::vector<uint8_t> header;
+    std::vector<uint8_t> shots;
+
+    // Ball numbers in header order
+    std::vector<int> numbers;
+    // Values stored per ball: the spin too under MOTION_SPIN
+    int storedValues = 4;
+
+    struct IndexEntry {
+        uint32_t step;
+        uint32_t keyframe;
+        uint32_t shot;
+        uint32_t shotNumber;
+    };
+    std::vector<IndexEntry> index;
+    std::vector<uint32_t> shotOffsets;
+
+    // The shot being recorded
+    bool shotOpen = false;
+    ShotCandidate shot = {};
+    uint32_t shotStart = 0;
+    uint32_t shotSteps = 0;
+    uint32_t nextStep = 0;
+    std::vector<float> startState;
+    std::vector<uint8_t> startFlags;
+    std::vector<std::vector<uint8_t>> keyframes;
+
+    void addKeyframe(const World& world, bool first);
+};
+
+// Plays a replay file back through a World, mapped into memory so opening is cheap
+// and seeking touches only the keyframes it needs.
+class ReplayPlayer {
+public:
+    // State at the current step, for rendering
+    World world;
+
+    // Playback rate: 1 is real time, below 1 slow motion, above fast forward, negative rewinds
+    float speed = 1.0f;
+    bool paused = false;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return entryCount != 0; }
+
+    size_t stepCount() const { return totalSteps; }
+    size_t currentStep() const { return step; }
+    double duration() const { return totalSteps * (double)frameTime; }
+    double currentTime() const { return step * (double)frameTime; }
+    size_t shotCount() const { return shotTotal; }
+
+    // Jumps to a step (clamped): binary search for the keyframe, then at most
+    // keyframeInterval steps. Moving forward within a shot just keeps stepping.
+    void seekStep(size_t target);
+    void seek(double seconds);
+
+    // Moves playback on by realSeconds of wall time at the current speed
+    void advance(double realSeconds);
+
+    // Number and input of the shot on screen
+    int currentShot() const { return shotNumber; }
+    ShotCandidate currentShotInput() const { return shotInput; }
+
+    // stateHash recorded at the end of the current shot, to check playback against
+    uint64_t currentShotHash() const { return shotHash; }
+    size_t currentShotEnd() const { return shotEnd; }
+
+private:
+    MappedFile file;
+
+    uint16_t keyframeInterval = 0;
+    std::vector<int> numbers;
+    int storedValues = 4;
+
+    const uint8_t* entries = nullptr;
+    uint32_t entryCount = 0;
+    size_t totalSteps = 0;
+    size_t shotTotal = 0;
+
+    size_t step = 0;
+    double time = 0.0;
+
+    int shotNumber = -1;
+    size_t shotStart = 0;
+    size_t shotEnd = 0;
+    uint32_t shotOffset = 0;
+    ShotCandidate shotInput = {};
+    uint64_t shotHash = 0;
+
+    uint32_t entryField(uint32_t entry, int field) const;
+    bool restore(uint32_t entry);
+    void stepForward(size_t target);
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "ShotEvaluator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "JobSystem.h"
+
+void strikeCueBall(World& world, ShotCandidate shot) {
+    int cueBall = world.findBall(cueBallNumber);
+    if (cueBall < 0) return;
+
+    glm::vec2 direction = glm::normalize(glm::vec2(std::sin(shot.angle), std::cos(shot.angle)));
+    world.balls.setVelocity(cueBall, direction * shot.power);
+    if (world.motionModel != MOTION_SPIN) return;
+
+    glm::vec2 tip = shot.tipOffset;
+    float reach = glm::length(tip);
+    if (reach > maxTipOffset) tip *= maxTipOffset / reach;
+
+    // Follow spins the ball about the horizontal axis it rolls on, at the rolling rate
+    // (vz, -vx) / r for a tip 2/5 up; side spin is about the vertical
+    float rate = 2.5f * shot.power / world.balls.radius[cueBall];
+    glm::vec3 spin(direction.y * tip.y * rate, tip.x * rate, -direction.x * tip.y * rate);
+    world.balls.setSpin(cueBall, spin);
+}
+
+ShotOutcome ShotEvaluator::evaluateShot(const World& world, const NineBallRules& rules,
+    ShotCandidate shot, World& scratch) const {
+    // Assignment keeps the scratch world's buffers, so a reused scratch allocates nothing
+    scratch = world;
+    scratch.events.clear();
+
+    NineBallRules shotRules = rules;
+    shotRules.beginShot();
+    int shooter = shotRules.currentPlayer;
+
+    ShotOutcome outcome;
+    outcome.steps = 0;
+
+    strikeCueBall(scratch, shot);
+
+    // Same loop as the game: step, hand the events to the rules, stop once at rest
+    int maxSteps = (int)std::ceil(maxTime / frameTime);
+    do {
+        scratch.step(frameTime);
+        outcome.steps++;
+
+        for (const WorldEvent& event : scratch.events) {
+            if (event.type == BALL_POCKETED) outcome.ballsPocketed.push_back(event.ballA);
+        }
+        shotRules.processEvents(scratch, scratch.events);
+        scratch.events.clear();
+    } while (!scratch.isAtRest() && outcome.steps < maxSteps);
+
+    outcome.firstBallHit = shotRules.firstBallHit;
+
+    int cueBall = scratch.findBall(cueBallNumber);
+    outcome.cueBallPocketed = cueBall < 0 || scratch.balls.pocketed(cueBall);
+    outcome.cueBallPosition = cueBall >= 0 ? scratch.balls.position(cueBall) : glm::vec2(0.0f);
+
+    outcome.historyHash = scratch.deterministic ? scratch.historyHash : 0;
+
+    outcome.lowestBallNumber = shotRules.lowestBallNumber;
+    int lowestBall = scratch.findBall(shotRules.lowestBallNumber);
+    outcome.lowestBallPosition = lowestBall >= 0 ? scratch.balls.position(lowestBall) : glm::vec2(0.0f);
+
+    TurnResult result = shotRules.evaluateTurn(scratch);
+    outcome.foul = shotRules.foulThisTurn;
+    outcome.keepsTurn = shotRules.currentPlayer == shooter;
+    outcome.gameOver = result.gameOver;
+
+    return outcome;
+}
+
+void ShotEvaluator::evaluate(const World& world, const NineBallRules& rules,
+    const std::vector<ShotCandidate>& shots, std::vector<ShotOutcome>& outcomes) const {
+    outcomes.resize(shots.size());
+
+    JobSystem& jobs = JobSystem::shared();
+    unsigned threads = threadCount != 0 ? threadCount : jobs.workerCount() + 1;
+    threads = (unsigned)std::min<size_t>(threads, shots.size());
+
+    // Each of up to threads lanes takes the next unclaimed shot, which balances long
+    // and short shots, and reuses one scratch World
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        World scratch;
+        for (size_t i = next++; i < shots.size(); i = next++) {
+            outcomes[i] = evaluateShot(world, rules, shots[i], scratch);
+        }
+    };
+
+    if (threads <= 1) {
+        work();
+        return;
+    }
+    jobs.parallelFor(threads, 1, [&](size_t, size_t) { work(); });
+}
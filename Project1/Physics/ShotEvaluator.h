@@ -0,0 +1,65 @@
+#ifndef SHOT_EVALUATOR_H
+#define SHOT_EVALUATOR_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "World.h"
+#include "NineBallRules.h"
+
+// A cue strike as the game plays it: angle in radians around the table normal
+// (0 points along +z), power is the cue ball speed. tipOffset is where the cue tip
+// meets the ball, seen from behind it, in ball radii from its centre: x to the right
+// for right english, y up for follow and down for draw. It only counts under
+// MOTION_SPIN, and is kept within maxTipOffset.
+struct ShotCandidate {
+    float angle;
+    float power;
+    glm::vec2 tipOffset = glm::vec2(0.0f);
+};
+
+// Further out the tip would miscue
+const float maxTipOffset = 0.5f;
+
+struct ShotOutcome {
+    int firstBallHit;              // ball number, -1 if the cue ball hit nothing
+    std::vector<int> ballsPocketed; // ball numbers in the order they dropped
+    bool cueBallPocketed;
+    bool foul;
+    bool keepsTurn;                // shooter is still the current player afterwards
+    bool gameOver;
+    glm::vec2 cueBallPosition;     // where the cue ball came to rest (before any respot)
+    int lowestBallNumber;          // ball to hit next, and where it came to rest
+    glm::vec2 lowestBallPosition;
+    int steps;
+    uint64_t historyHash;          // World::historyHash at rest; only set in deterministic mode
+};
+
+// Sets the cue ball moving for the given shot, exactly as the game does. Under
+// MOTION_SPIN an off-centre tip also spins it: the strike's impulse at the tip gives
+// a solid sphere 5/2 of the offset times speed / radius, so a tip 2/5 above centre
+// starts it rolling straight away.
+void strikeCueBall(World& world, ShotCandidate shot);
+
+// Plays shots on copies of a world and reports what the rules make of each one,
+// without touching the original. Shots are independent, so a batch is spread over
+// the shared JobSystem, each lane reusing one scratch World.
+class ShotEvaluator {
+public:
+    // Shots played at once, at most; 0 uses every worker of the shared JobSystem and
+    // the calling thread
+    unsigned threadCount = 0;
+
+    // Simulated seconds after which a shot is cut off as if the balls had stopped
+    float maxTime = 60.0f;
+
+    // outcomes[i] belongs to shots[i]. Results do not depend on the thread count.
+    void evaluate(const World& world, const NineBallRules& rules,
+        const std::vector<ShotCandidate>& shots, std::vector<ShotOutcome>& outcomes) const;
+
+    // One shot, stepped in scratch (overwritten with a copy of world)
+    ShotOutcome evaluateShot(const World& world, const NineBallRules& rules,
+        ShotCandidate shot, World& scratch) const;
+};
+
+#endif
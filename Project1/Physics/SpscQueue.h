@@ -0,0 +1,67 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// A bounded ring buffer between one producer thread and one consumer thread, without
+// locks. push() never blocks: when the ring is full it refuses the value and counts
+// it. Capacity must be a power of two; the ring holds Capacity - 1 values.
+//
+// Each side keeps its own index on a cache line of its own, with a cached copy of the
+// other side's, so a push or pop only reads the other side's line when the cached
+// copy says the ring is full or empty.
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    // Producer side
+    bool push(const T& value) {
+        size_t head = producer.index.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & mask;
+        if (next == producer.otherIndex) {
+            producer.otherIndex = consumer.index.load(std::memory_order_acquire);
+            if (next == producer.otherIndex) {
+                producer.dropped++;
+                return false;
+            }
+        }
+        slots[head] = value;
+        producer.index.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false if the ring is empty
+    bool pop(T& value) {
+        size_t tail = consumer.index.load(std::memory_order_relaxed);
+        if (tail == consumer.otherIndex) {
+            consumer.otherIndex = producer.index.load(std::memory_order_acquire);
+            if (tail == consumer.otherIndex) return false;
+        }
+        value = slots[tail];
+        consumer.index.store((tail + 1) & mask, std::memory_order_release);
+        return true;
+    }
+
+    // Values refused because the ring was full; read on the producer side
+    size_t dropped() const { return producer.dropped; }
+
+    static size_t capacity() { return Capacity - 1; }
+
+private:
+    static const size_t mask = Capacity - 1;
+
+    struct alignas(64) Side {
+        std::atomic<size_t> index{ 0 };
+        // The other side's index when last read
+        size_t otherIndex = 0;
+        size_t dropped = 0;
+    };
+
+    Side producer;
+    Side consumer;
+    T slots[Capacity];
+};
+
+#endif
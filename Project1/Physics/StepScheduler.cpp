@@ -0,0 +1,57 @@
+#include "StepScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+void StepScheduler::advance(World& world, double elapsed, const std::function<void(float)>& step) {
+    frame = SchedulerMetrics();
+
+    if (elapsed > maxFrameTime) {
+        frame.droppedTime += elapsed - maxFrameTime;
+        elapsed = maxFrameTime;
+    }
+    accumulator += elapsed;
+
+    while (accumulator >= stepTime) {
+        if (frame.steps == maxStepsPerFrame) {
+            // Keep the fraction of a step so the interpolation stays smooth
+            double whole = std::floor(accumulator / stepTime) * stepTime;
+            frame.droppedTime += whole;
+            accumulator -= whole;
+            break;
+        }
+
+        accumulator -= stepTime;
+        frame.steps++;
+
+        // Nothing moves until the caller wakes a ball, e.g. by striking the cue ball
+        if (world.isAtRest() && !world.hasAwakeBalls()) {
+            frame.restingSteps++;
+            continue;
+        }
+
+        int substeps = 1;
+        if (!world.deterministic && world.stats.contacts >= denseContacts) {
+            substeps = std::max(denseSubsteps, 1);
+        }
+        for (int k = 0; k < substeps; k++) {
+            step(stepTime / substeps);
+            frame.worldSteps++;
+        }
+    }
+
+    frames++;
+    mostStepsPerFrame = std::max(mostStepsPerFrame, frame.steps);
+    total.steps += frame.steps;
+    total.worldSteps += frame.worldSteps;
+    total.restingSteps += frame.restingSteps;
+    total.droppedTime += frame.droppedTime;
+}
+
+void StepScheduler::reset() {
+    accumulator = 0.0;
+    frame = SchedulerMetrics();
+    total = SchedulerMetrics();
+    frames = 0;
+    mostStepsPerFrame = 0;
+}
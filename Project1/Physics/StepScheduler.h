@@ -0,0 +1,54 @@
+#ifndef STEP_SCHEDULER_H
+#define STEP_SCHEDULER_H
+
+#include <cstddef>
+#include <functional>
+
+#include "World.h"
+
+// Counters of one advance(), or summed over many
+struct SchedulerMetrics {
+    int steps = 0;            // fixed steps taken
+    int worldSteps = 0;       // calls to the step function, counting substeps
+    int restingSteps = 0;     // steps passed over because no ball was awake
+    double droppedTime = 0.0; // seconds of simulation given up to the caps
+};
+
+// Turns real frame times into fixed physics steps. Frame time accumulates and is paid
+// out in steps of stepTime, with the remainder left for the next frame. Unlike an
+// open-ended catch-up loop it never runs more than maxStepsPerFrame steps in a frame:
+// time beyond that is dropped, so a slow frame cannot make the next one slower still.
+class StepScheduler {
+public:
+    float stepTime = frameTime;
+    int maxStepsPerFrame = 8;
+
+    // A longer frame (a debugger stop, a window drag) counts as this long
+    double maxFrameTime = 0.25;
+
+    // A step that follows one with at least denseContacts contacts is split into
+    // denseSubsteps substeps. Only for worlds without deterministic set, since a
+    // deterministic world must step exactly frameTime at a time.
+    size_t denseContacts = 4;
+    int denseSubsteps = 4;
+
+    SchedulerMetrics frame;
+    SchedulerMetrics total;
+    size_t frames = 0;
+    int mostStepsPerFrame = 0;
+
+    // Advances world by elapsed seconds of real time. step(dt) must run world.step(dt)
+    // once, along with anything else the caller does per step.
+    void advance(World& world, double elapsed, const std::function<void(float)>& step);
+
+    // How far real time has got from the last step towards the next one, in [0, 1),
+    // to draw the world between the last two steps
+    float interpolationAlpha() const { return (float)(accumulator / stepTime); }
+
+    void reset();
+
+private:
+    double accumulator = 0.0;
+};
+
+#endif
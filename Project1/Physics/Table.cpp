@@ -0,0 +1,42 @@
+#include "Table.h"
+#include "TableGeometry.h"
+
+void setupStandardTable(World& world) {
+    applyTableGeometry(world, standardTableGeometry());
+}
+
+void rackNineBall(World& world) {
+    world.balls.clear();
+    world.events.clear();
+
+    // Cue ball (white) behind the head string
+    world.balls.add(PhysicsBall(-1.2f, 0.0f, ballRadius, cueBallNumber));
+
+    // Calculate positions for diamond rack formation
+    float row_spacing = ballRadius * 2.1f;  // Slightly more than diameter for tight rack
+    float col_spacing = row_spacing * 0.866f;  // cos(30 degrees) for equilateral triangle spacing
+
+    float rackCenterX = 1.0f;  // Positive X for opposite side from cue ball
+    float rackCenterZ = 0.0f;  // Centered on Z axis
+
+    const glm::vec2 rackPositions[] = {
+        // Front (1-ball)
+        glm::vec2(rackCenterX - col_spacing * 2, rackCenterZ),
+        // Second row (2,3)
+        glm::vec2(rackCenterX - col_spacing, rackCenterZ - row_spacing / 2),
+        glm::vec2(rackCenterX - col_spacing, rackCenterZ + row_spacing / 2),
+        // Third row (4,9,5)
+        glm::vec2(rackCenterX, rackCenterZ - row_spacing),
+        glm::vec2(rackCenterX, rackCenterZ),  // 9-ball in center
+        glm::vec2(rackCenterX, rackCenterZ + row_spacing),
+        // Fourth row (6,7)
+        glm::vec2(rackCenterX + col_spacing, rackCenterZ - row_spacing / 2),
+        glm::vec2(rackCenterX + col_spacing, rackCenterZ + row_spacing / 2),
+        // Back (8-ball)
+        glm::vec2(rackCenterX + col_spacing * 2, rackCenterZ)
+    };
+
+    for (int i = 0; i < 9; i++) {
+        world.balls.add(PhysicsBall(rackPositions[i].x, rackPositions[i].y, ballRadius, i + 1));
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "World.h"
+
+const float tableHalfLength = 2.0f;
+const float tableHalfWidth = 1.0f;
+const float holeRadius = 0.15f;
+const float cushionWidth = 0.125f;
+
+// Six pockets and cushion segments of the standard table
+void setupStandardTable(World& world);
+
+// Cue ball plus the nine object balls in the diamond rack
+void rackNineBall(World& world);
+
+#endif
@@ -0,0 +1,180 @@
+#include "TableGeometry.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "Table.h"
+
+namespace {
+
+// Radius of the pocket centred at point, or 0 if there is none
+float pocketRadiusAt(const std::vector<Pocket>& pockets, glm::vec2 point) {
+    for (const Pocket& pocket : pockets) {
+        glm::vec2 gap = pocket.position - point;
+        if (glm::dot(gap, gap) < 1e-8f) return pocket.radius;
+    }
+    return 0.0f;
+}
+
+}
+
+void TableGeometry::finalize() {
+    edges.clear();
+    rails.clear();
+
+    for (const CushionRun& run : runs) {
+        glm::vec2 direction = glm::normalize(run.end - run.start);
+
+        // Away from the middle of the table; adding 0 turns -0 into +0
+        glm::vec2 outward(-direction.y, direction.x);
+        if (glm::dot(outward, (run.start + run.end) * 0.5f) < 0.0f) outward = -outward;
+        outward += glm::vec2(0.0f);
+
+        edges.push_back(Edge(
+            run.start - direction * cushionOffset + outward * cushionOffset,
+            run.end + direction * cushionOffset + outward * cushionOffset,
+            glm::vec2(0.0f) - outward, cushionWidth));
+
+        CushionRail rail;
+        rail.innerStart = run.start + direction * pocketRadiusAt(pockets, run.start);
+        rail.innerEnd = run.end - direction * pocketRadiusAt(pockets, run.end);
+        rail.outerStart = rail.innerStart + outward * cushionWidth;
+        rail.outerEnd = rail.innerEnd + outward * cushionWidth;
+        rails.push_back(rail);
+    }
+
+    pocketZone = pocketFreeZone(pockets);
+
+    boundary.reset();
+    if (edges.empty() && jaws.empty()) return;
+
+    // Everything within reach of a cushion or jaw, and a cell beyond
+    glm::vec2 min(INFINITY), max(-INFINITY);
+    for (const Edge& edge : edges) {
+        min = glm::min(min, glm::min(edge.start, edge.end) - edge.cushionWidth);
+        max = glm::max(max, glm::max(edge.start, edge.end) + edge.cushionWidth);
+    }
+    for (const CushionJaw& jaw : jaws) {
+        min = glm::min(min, jaw.centre - jaw.radius);
+        max = glm::max(max, jaw.centre + jaw.radius);
+    }
+
+    std::shared_ptr<BoundaryField> field = std::make_shared<BoundaryField>();
+    field->build(edges, jaws, min - field->cellSize, max + field->cellSize);
+    boundary = field;
+}
+
+TableGeometry standardTableGeometry() {
+    TableGeometry table;
+    table.halfLength = tableHalfLength;
+    table.halfWidth = tableHalfWidth;
+    table.cushionWidth = cushionWidth;
+
+    // sqrt(2) * holeRadius past the pocket, less 0.1
+    table.cushionOffset = -(-holeRadius * 1.4142f + 0.1f);
+
+    const float x = tableHalfLength;
+    const float z = tableHalfWidth;
+    const glm::vec2 holePositions[] = {
+        glm::vec2(-x, z),       // Top-left corner
+        glm::vec2(0.0f, z),     // Top-middle
+        glm::vec2(x, z),        // Top-right corner
+        glm::vec2(-x, -z),      // Bottom-left corner
+        glm::vec2(0.0f, -z),    // Bottom-middle
+        glm::vec2(x, -z)        // Bottom-right corner
+    };
+    for (glm::vec2 position : holePositions) {
+        table.pockets.push_back(Pocket(position, holeRadius));
+    }
+
+    // Top, bottom, then the two ends
+    table.runs = {
+        { holePositions[0], holePositions[1] },
+        { holePositions[1], holePositions[2] },
+        { holePositions[3], holePositions[4] },
+        { holePositions[4], holePositions[5] },
+        { holePositions[0], holePositions[3] },
+        { holePositions[2], holePositions[5] }
+    };
+
+    table.finalize();
+    return table;
+}
+
+bool loadTableGeometry(const std::string& path, TableGeometry& table, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    TableGeometry loaded;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) continue;
+
+        bool ok = true;
+        if (key == "name") {
+            std::getline(in >> std::ws, loaded.name);
+        }
+        else if (key == "size") {
+            float length, width;
+            ok = (bool)(in >> length >> width) && length > 0.0f && width > 0.0f;
+            loaded.halfLength = length * 0.5f;
+            loaded.halfWidth = width * 0.5f;
+        }
+        else if (key == "bed") {
+            ok = (bool)(in >> loaded.bedThickness >> loaded.legHeight);
+        }
+        else if (key == "cushion") {
+            ok = (bool)(in >> loaded.cushionWidth >> loaded.cushionHeight >> loaded.cushionOffset);
+        }
+        else if (key == "pocket") {
+            float x, z, radius;
+            ok = (bool)(in >> x >> z >> radius) && radius > 0.0f;
+            if (ok) loaded.pockets.push_back(Pocket(glm::vec2(x, z), radius));
+        }
+        else if (key == "run") {
+            CushionRun run;
+            ok = (bool)(in >> run.start.x >> run.start.y >> run.end.x >> run.end.y) && run.start != run.end;
+            if (ok) loaded.runs.push_back(run);
+        }
+        else if (key == "jaw") {
+            CushionJaw jaw;
+            ok = (bool)(in >> jaw.centre.x >> jaw.centre.y >> jaw.radius) && jaw.radius > 0.0f;
+            if (ok) loaded.jaws.push_back(jaw);
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = path + ":" + std::to_string(lineNumber) + ": bad line '" + line + "'";
+            return false;
+        }
+    }
+
+    if (loaded.pockets.empty() || loaded.runs.empty()) {
+        error = path + ": a table needs pockets and cushion runs";
+        return false;
+    }
+
+    loaded.finalize();
+    table = loaded;
+    return true;
+}
+
+void applyTableGeometry(World& world, const TableGeometry& table) {
+    world.pockets = table.pockets;
+    world.edges = table.edges;
+    world.pocketZone = table.pocketZone;
+    world.boundary = table.boundary;
+    world.cushionModel = table.jaws.empty() ? CUSHION_SEGMENTS : CUSHION_FIELD;
+}
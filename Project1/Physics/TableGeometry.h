@@ -0,0 +1,78 @@
+#ifndef TABLE_GEOMETRY_H
+#define TABLE_GEOMETRY_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "World.h"
+#include "BoundaryField.h"
+
+// A cushion running along a rail from one pocket centre to the next
+struct CushionRun {
+    glm::vec2 start;
+    glm::vec2 end;
+};
+
+// Render quad of one cushion: the face on the table edge, inset by the pockets at
+// each end, and the outer face cushionWidth further out
+struct CushionRail {
+    glm::vec2 innerStart;
+    glm::vec2 innerEnd;
+    glm::vec2 outerStart;
+    glm::vec2 outerEnd;
+};
+
+// One description of the table that both the physics and the meshes are built from.
+// Load it from a .table file, or use standardTableGeometry() for the game's table.
+//
+// File format, one entry per line, # starts a comment:
+//   name <text>
+//   size <length> <width>                   playing surface, centred on the origin
+//   bed <thickness> <leg height>
+//   cushion <width> <height> <offset>       offset: contact line outside the rail
+//   pocket <x> <z> <radius>
+//   run <x0> <z0> <x1> <z1>                 cushion from pocket centre to pocket centre
+//   jaw <x> <z> <radius>                    round obstacle, e.g. a curved pocket jaw
+//
+// Jaws only exist in the boundary field, so a table with any plays with CUSHION_FIELD.
+struct TableGeometry {
+    std::string name = "standard";
+    float halfLength = 2.0f;
+    float halfWidth = 1.0f;
+    float bedThickness = 0.2f;
+    float legHeight = 0.7f;
+    float cushionWidth = 0.125f;
+    float cushionHeight = 0.02f;
+
+    // The physics contact line of a cushion sits this far outside the rail and runs
+    // this far past the pocket centres at its ends
+    float cushionOffset = 0.0f;
+
+    std::vector<Pocket> pockets;
+    std::vector<CushionRun> runs;
+    std::vector<CushionJaw> jaws;
+
+    // Derived by finalize(): edges and rails in run order, the pocket-free zone and
+    // the signed distance field of the edges and jaws
+    std::vector<Edge> edges;
+    std::vector<CushionRail> rails;
+    PocketZone pocketZone;
+    std::shared_ptr<const BoundaryField> boundary;
+
+    // Fills the derived data; call after changing any of the fields above
+    void finalize();
+};
+
+// The 4 x 2 nine-ball table the game has always used
+TableGeometry standardTableGeometry();
+
+// False with a message in error if the file cannot be read or is not a valid table
+bool loadTableGeometry(const std::string& path, TableGeometry& table, std::string& error);
+
+// Replaces world's pockets, cushions and boundary field with the table's, and picks
+// CUSHION_FIELD if the table has jaws and CUSHION_SEGMENTS otherwise
+void applyTableGeometry(World& world, const TableGeometry& table);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Hands values from one writer thread to one reader thread without locks. The writer
+// fills back() and publish()es it; the reader acquire()s the newest published value
+// and reads front() until its next acquire(). Neither side ever waits: the writer
+// may publish any number of times between two reads, and only the newest value is
+// kept. Buffers are reused, so a T holding vectors stops allocating once warm.
+template <typename T>
+class TripleBuffer {
+public:
+    T& back() { return slots[backIndex]; }
+    const T& front() const { return slots[frontIndex]; }
+
+    // Makes back() the newest value and hands the writer a free buffer
+    void publish() {
+        backIndex = middle.exchange(backIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Takes the newest value if there is one since the last call; true if there was
+    bool acquire() {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0) return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+private:
+    static const uint8_t indexMask = 3;
+    static const uint8_t freshBit = 4;
+
+    T slots[3];
+    uint8_t backIndex = 0;
+    uint8_t frontIndex = 1;
+    // Index of the buffer between the two sides, with freshBit set if it is newer
+    // than front()
+    std::atomic<uint8_t> middle{ 2 };
+};
+
+#endif
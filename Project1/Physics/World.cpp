@@ -0,0 +1,850 @@
+#include "World.h"
+#include "BallKernels.h"
+#include "BoundaryField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Returned by the impact-time tests when there is no contact within the step
+const float noImpact = -1.0f;
+
+// Caps the contacts followed up per ball and step, against balls wedged between
+// cushions and other balls trading impacts endlessly
+const size_t maxImpactsPerBall = 8;
+
+// Sphere tracing through the boundary field: a ball this close to the boundary is
+// touching it, and the march gives up after this many lookups
+const float fieldContactTolerance = 1e-4f;
+const int maxFieldSteps = 48;
+
+// Island contacts: balls this close count as touching, so a packed cluster whose
+// balls are a hair apart is still solved as one
+const float islandContactSlop = 1e-3f;
+
+// pairSlot of a ball with no candidate pairs
+const uint32_t noPairSlot = 0xffffffffu;
+
+// Fraction u of the step at which a point moving by delta per step first comes within
+// distance of target, counting from where it is now. Only while closing in.
+float pointImpactTime(glm::vec2 position, glm::vec2 delta, glm::vec2 target, float distance) {
+    glm::vec2 gap = position - target;
+    float closing = glm::dot(gap, delta);
+    if (closing >= 0.0f) return noImpact;
+
+    float c = glm::dot(gap, gap) - distance * distance;
+    if (c <= 0.0f) return 0.0f;
+
+    float disc = closing * closing - glm::dot(delta, delta) * c;
+    if (disc < 0.0f) return noImpact;
+
+    // Smaller root of |gap + delta u| = distance, in the cancellation-free form
+    return c / (-closing + std::sqrt(disc));
+}
+
+bool pairLater(const BallPair& l, const BallPair& r) {
+    return pairLess(r, l);
+}
+
+}
+
+void World::step(float deltaTime) {
+    if (deterministic) deltaTime = frameTime;
+
+    // Pocketed balls move behind the ones in play, so every loop can stop at liveSize()
+    balls.compact();
+    collectAwake();
+
+    stats = {};
+    stats.awakeBalls = awake.size();
+    stats.asleepBalls = balls.liveSize() - awake.size();
+
+    // Sleeping balls cannot start moving on their own
+    if (awake.empty()) {
+        atRest = true;
+        // Nothing is touching while everything sleeps, so the next shot starts afresh
+        solver.clearWarmStart();
+    }
+    else {
+        updateAwakeRanges();
+        if (contactModel == CONTACTS_ISLANDS) {
+            stepIslands(deltaTime);
+        }
+        else if (continuousCollision) {
+            stepSwept(deltaTime);
+        }
+        else {
+            stepDiscrete(deltaTime);
+        }
+
+        if (deterministic && fixedPoint) {
+            snapToFixedPoint();
+        }
+
+        // Balls that stopped go to sleep and leave the list, as do pocketed ones; the
+        // broad phase hears of both next step
+        size_t kept = 0;
+        for (uint32_t i : awake) {
+            if (balls.flags[i] == 0) {
+                bool moving = balls.vx[i] != 0.0f || balls.vz[i] != 0.0f;
+                if (motionModel == MOTION_SPIN && (balls.wx[i] != 0.0f || balls.wy[i] != 0.0f || balls.wz[i] != 0.0f)) moving = true;
+                if (moving) {
+                    awake[kept++] = i;
+                    continue;
+                }
+                balls.flags[i] |= BALL_FLAG_ASLEEP;
+            }
+            moved.push_back(i);
+        }
+        awake.resize(kept);
+    }
+
+    if (deterministic) {
+        stateHash = computeStateHash();
+        historyHash = hashCombine(historyHash, stateHash);
+    }
+}
+
+bool World::hasAwakeBalls() const {
+    if (balls.layout() != awakeLayout) {
+        for (size_t i = 0; i < balls.liveSize(); i++) {
+            if (balls.flags[i] == 0) return true;
+        }
+        return false;
+    }
+
+    // The list as the last step left it, and anything woken since
+    for (const std::vector<uint32_t>* list : { &awake, &balls.changed() }) {
+        for (uint32_t i : *list) {
+            if (i < balls.liveSize() && balls.flags[i] == 0) return true;
+        }
+    }
+    return false;
+}
+
+// Brings awake up to date for this step: balls woken from outside since the last one
+// join it and balls flagged from outside leave it. A new layout voids every index
+// kept, so then it is a scan.
+void World::collectAwake() {
+    uint32_t count = (uint32_t)balls.liveSize();
+    balls.takeChanged(moved);
+
+    if (balls.layout() != awakeLayout) {
+        awakeLayout = balls.layout();
+        awake.clear();
+        moved.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            if (balls.flags[i] == 0) awake.push_back(i);
+        }
+        return;
+    }
+
+    // Flags only change from outside through BallStore, which logs them, so with
+    // nothing logged the list is as the last step left it
+    if (moved.empty()) return;
+
+    for (uint32_t i : moved) {
+        if (i < count && balls.flags[i] == 0) awake.push_back(i);
+    }
+    std::sort(awake.begin(), awake.end());
+    awake.erase(std::unique(awake.begin(), awake.end()), awake.end());
+    awake.erase(std::remove_if(awake.begin(), awake.end(), [this](uint32_t i) { return balls.flags[i] != 0; }), awake.end());
+
+    // Steps with nothing awake leave moved to build up for the broad phase
+    if (moved.size() > count) {
+        std::sort(moved.begin(), moved.end());
+        moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+    }
+}
+
+// Blocks of lanes holding an awake ball, merged where they touch. awake is in index
+// order but for balls woken during the step, so sorting is rarely needed.
+void World::updateAwakeRanges() {
+    awakeRanges.clear();
+    bool sorted = true;
+    for (uint32_t i : awake) {
+        size_t begin = i / ballLaneWidth * ballLaneWidth;
+        if (!awakeRanges.empty()) {
+            BallRange& last = awakeRanges.back();
+            if (begin >= last.begin && begin <= last.end) {
+                last.end = std::max(last.end, begin + ballLaneWidth);
+                continue;
+            }
+            if (begin < last.begin) sorted = false;
+        }
+        awakeRanges.push_back({ begin, begin + ballLaneWidth });
+    }
+    if (sorted) return;
+
+    std::sort(awakeRanges.begin(), awakeRanges.end(),
+        [](const BallRange& l, const BallRange& r) { return l.begin < r.begin; });
+    size_t kept = 0;
+    for (const BallRange& range : awakeRanges) {
+        if (kept > 0 && range.begin <= awakeRanges[kept - 1].end) {
+            awakeRanges[kept - 1].end = std::max(awakeRanges[kept - 1].end, range.end);
+        }
+        else {
+            awakeRanges[kept++] = range;
+        }
+    }
+    awakeRanges.resize(kept);
+}
+
+// FNV-1a over 32-bit words of the raw bits, so -0.0 and 0.0 hash apart
+uint64_t World::computeStateHash() const {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint32_t word) {
+        hash ^= word;
+        hash *= 1099511628211ull;
+    };
+    auto mixFloat = [&mix](float value) {
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        mix(word);
+    };
+
+    // Index order is itself deterministic: compaction is stable in add order
+    for (size_t i = 0; i < balls.size(); i++) {
+        mix((uint32_t)balls.number[i]);
+        mix(balls.flags[i]);
+        mixFloat(balls.x[i]);
+        mixFloat(balls.z[i]);
+        mixFloat(balls.vx[i]);
+        mixFloat(balls.vz[i]);
+        if (motionModel == MOTION_SPIN) {
+            mixFloat(balls.wx[i]);
+            mixFloat(balls.wy[i]);
+            mixFloat(balls.wz[i]);
+        }
+    }
+    return hash;
+}
+
+size_t World::memoryBytes() const {
+    return balls.memoryBytes() + broadPhase.memoryBytes() + capacityBytes(edges) + capacityBytes(pockets) +
+        capacityBytes(events) + capacityBytes(pairs) + capacityBytes(awake) + capacityBytes(awakeRanges) +
+        capacityBytes(moved) + capacityBytes(wokenPairs) + capacityBytes(neighbours) + capacityBytes(pendingPairs) +
+        capacityBytes(sweepOrigin) + capacityBytes(sweepDelta) + capacityBytes(sweepStart) +
+        capacityBytes(sweepVersion) + capacityBytes(sweepStamp) + capacityBytes(pairSlot) +
+        capacityBytes(pairStart) + capacityBytes(pairIndex) + capacityBytes(pairFill) + capacityBytes(impacts) +
+        capacityBytes(solverContacts) + solver.memoryBytes();
+}
+
+PocketZone pocketFreeZone(const std::vector<Pocket>& pockets) {
+    PocketZone zone;
+    if (pockets.empty()) return zone;
+
+    zone.min = zone.max = pockets[0].position;
+    for (const Pocket& pocket : pockets) {
+        zone.min = glm::min(zone.min, pocket.position);
+        zone.max = glm::max(zone.max, pocket.position);
+    }
+
+    // Each pocket's box, with a margin against rounding in the pocket test, is cut
+    // off along whichever side keeps the most area
+    const float margin = 1e-4f;
+    for (const Pocket& pocket : pockets) {
+        glm::vec2 low = pocket.position - glm::vec2(pocket.radius + margin);
+        glm::vec2 high = pocket.position + glm::vec2(pocket.radius + margin);
+        if (high.x <= zone.min.x || low.x >= zone.max.x || high.y <= zone.min.y || low.y >= zone.max.y) continue;
+
+        PocketZone cuts[4] = { zone, zone, zone, zone };
+        cuts[0].min.x = high.x;
+        cuts[1].max.x = low.x;
+        cuts[2].min.y = high.y;
+        cuts[3].max.y = low.y;
+
+        float bestArea = 0.0f;
+        PocketZone best;
+        for (const PocketZone& cut : cuts) {
+            glm::vec2 size = cut.max - cut.min;
+            if (size.x > 0.0f && size.y > 0.0f && size.x * size.y > bestArea) {
+                bestArea = size.x * size.y;
+                best = cut;
+            }
+        }
+        if (bestArea == 0.0f) return PocketZone();
+        zone = best;
+    }
+    return zone;
+}
+
+uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    // boost::hash_combine widened to 64 bits
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 12) + (seed >> 4));
+}
+
+void World::snapToFixedPoint() {
+    auto snap = [](float value) {
+        return std::nearbyint(value * fixedPointScale) / fixedPointScale;
+    };
+
+    for (uint32_t i : awake) {
+        balls.x[i] = snap(balls.x[i]);
+        balls.z[i] = snap(balls.z[i]);
+        balls.vx[i] = snap(balls.vx[i]);
+        balls.vz[i] = snap(balls.vz[i]);
+        if (motionModel == MOTION_SPIN) {
+            balls.wx[i] = snap(balls.wx[i]);
+            balls.wy[i] = snap(balls.wy[i]);
+            balls.wz[i] = snap(balls.wz[i]);
+        }
+    }
+}
+
+bool World::integrate(float deltaTime) {
+    if (motionModel == MOTION_SPIN) return integrateSpinningBalls(balls, awakeRanges, deltaTime);
+    return integrateBalls(balls, awakeRanges, deltaTime, integrator);
+}
+
+void World::stepDiscrete(float deltaTime) {
+    bool moving = integrate(deltaTime);
+    atRest = !moving;
+
+    // Only check for pocketed balls while balls are in motion
+    if (moving) {
+        capturePocketedBalls(balls, awakeRanges, pockets, pocketZone, events);
+    }
+
+    broadPhase.findPairs(balls, awake, moved, pairs);
+    moved.clear();
+    stats.pairsTested = broadPhase.pairsTested;
+    stats.candidatePairs = pairs.size();
+
+    // Pairs arrive in index order; the cue ball sits first, so its contacts resolve before the rest.
+    // Pairs of a woken ball merge in behind the current pair, as if they had been listed all along.
+    pendingPairs.clear();
+    size_t next = 0;
+    while (next < pairs.size() || !pendingPairs.empty()) {
+        BallPair pair;
+        if (!pendingPairs.empty() && (next == pairs.size() || pairLess(pendingPairs.front(), pairs[next]))) {
+            std::pop_heap(pendingPairs.begin(), pendingPairs.end(), pairLater);
+            pair = pendingPairs.back();
+            pendingPairs.pop_back();
+        }
+        else {
+            pair = pairs[next++];
+        }
+
+        float dx = balls.x[pair.b] - balls.x[pair.a];
+        float dz = balls.z[pair.b] - balls.z[pair.a];
+        float minDistance = balls.radius[pair.a] + balls.radius[pair.b];
+        if (dx * dx + dz * dz < minDistance * minDistance) {
+            events.push_back({ BALL_CONTACT, balls.number[pair.a], balls.number[pair.b] });
+            resolveBallCollision(pair.a, pair.b);
+            stats.contacts++;
+
+            for (const BallPair& woken : wokenPairs) {
+                if (!pairLess(pair, woken)) continue;
+                pendingPairs.push_back(woken);
+                std::push_heap(pendingPairs.begin(), pendingPairs.end(), pairLater);
+            }
+            wokenPairs.clear();
+        }
+    }
+
+    for (uint32_t i : awake) {
+        if (balls.pocketed(i)) continue;
+        if (cushionModel == CUSHION_FIELD) {
+            resolveFieldCollision(i, 0.0f);
+            continue;
+        }
+        if (clearOfCushions(i, balls.position(i), 0.0f)) continue;
+        for (const Edge& edge : edges) {
+            resolveEdgeCollision(i, edge);
+        }
+    }
+}
+
+void World::stepIslands(float deltaTime) {
+    bool moving = integrate(deltaTime);
+    atRest = !moving;
+
+    if (moving) {
+        capturePocketedBalls(balls, awakeRanges, pockets, pocketZone, events);
+    }
+
+    broadPhase.findPairs(balls, awake, moved, pairs);
+    moved.clear();
+    stats.pairsTested = broadPhase.pairsTested;
+    stats.candidatePairs = pairs.size();
+
+    // Touching pairs become contacts. A sleeping ball touching an awake one wakes and
+    // brings its pairs with sleeping neighbours, so a touching cluster is solved whole.
+    solverContacts.clear();
+    size_t candidates = pairs.size();
+    for (size_t k = 0; k < pairs.size(); k++) {
+        BallPair pair = pairs[k];
+        float dx = balls.x[pair.b] - balls.x[pair.a];
+        float dz = balls.z[pair.b] - balls.z[pair.a];
+        float reach = balls.radius[pair.a] + balls.radius[pair.b] + islandContactSlop;
+        if (dx * dx + dz * dz >= reach * reach) continue;
+
+        SolverContact contact = {};
+        contact.a = pair.a;
+        contact.b = pair.b;
+        solverContacts.push_back(contact);
+
+        if (balls.asleep(pair.a) != balls.asleep(pair.b)) {
+            wakeBall(balls.asleep(pair.a) ? pair.a : pair.b);
+            pairs.insert(pairs.end(), wokenPairs.begin(), wokenPairs.end());
+            wokenPairs.clear();
+        }
+    }
+    stats.candidatePairs += pairs.size() - candidates;
+
+    solver.solve(balls, solverContacts);
+    stats.islands = solver.islandCount();
+    stats.largestIsland = solver.largestIsland();
+
+    // Contacts come back in ball number order, so the cue ball's come first
+    for (const SolverContact& contact : solverContacts) {
+        if (contact.approach > 0.0f) {
+            events.push_back({ BALL_CONTACT, balls.number[contact.a], balls.number[contact.b] });
+        }
+        if (contact.impulse > 0.0f) stats.contacts++;
+    }
+
+    for (uint32_t i : awake) {
+        if (balls.pocketed(i)) continue;
+        if (cushionModel == CUSHION_FIELD) {
+            resolveFieldCollision(i, 0.0f);
+            continue;
+        }
+        if (clearOfCushions(i, balls.position(i), 0.0f)) continue;
+        for (const Edge& edge : edges) {
+            resolveEdgeCollision(i, edge);
+        }
+    }
+}
+
+void World::stepSwept(float deltaTime) {
+    size_t count = balls.liveSize();
+
+    // Balls move in straight lines and contacts never speed them up, so two balls can
+    // only meet this step if they start within the two longest moves of each other.
+    // A sliding ball can speed up, by at most the sliding deceleration over the step.
+    float gain = motionModel == MOTION_SPIN ? ballSlidingFriction * gravity * deltaTime : 0.0f;
+    float longest = 0.0f, second = 0.0f;
+    for (uint32_t i : awake) {
+        float length = (glm::length(balls.velocity(i)) + gain) * deltaTime;
+        if (length > longest) {
+            second = longest;
+            longest = length;
+        }
+        else if (length > second) {
+            second = length;
+        }
+    }
+
+    // Only balls that move or have a candidate pair get a path this step; the rest of
+    // the arrays keep whatever an earlier step left there
+    sweepOrigin.resize(count);
+    sweepDelta.resize(count);
+    sweepStart.resize(count);
+    sweepVersion.resize(count);
+    sweepStamp.resize(count, 0);
+    pairSlot.resize(count);
+    if (++sweepEpoch == 0) {
+        std::fill(sweepStamp.begin(), sweepStamp.end(), 0);
+        sweepEpoch = 1;
+    }
+    for (uint32_t i : awake) {
+        beginSweep(i);
+    }
+
+    broadPhase.findPairs(balls, awake, moved, pairs, longest + second);
+    moved.clear();
+    stats.pairsTested = broadPhase.pairsTested;
+    stats.candidatePairs = pairs.size();
+
+    bool moving = integrate(deltaTime);
+    atRest = !moving;
+
+    for (uint32_t i : awake) {
+        sweepDelta[i] = balls.position(i) - sweepOrigin[i];
+    }
+
+    // Pairs of each ball, gathered into one array in the order the balls first
+    // appear in pairs
+    pairStart.clear();
+    for (const BallPair& pair : pairs) {
+        for (uint32_t i : { pair.a, pair.b }) {
+            beginSweep(i);
+            if (pairSlot[i] == noPairSlot) {
+                pairSlot[i] = (uint32_t)pairStart.size();
+                pairStart.push_back(0);
+            }
+            pairStart[pairSlot[i]]++;
+        }
+    }
+    uint32_t total = 0;
+    for (uint32_t& start : pairStart) {
+        uint32_t pairCount = start;
+        start = total;
+        total += pairCount;
+    }
+    pairStart.push_back(total);
+
+    indexedPairs = pairs.size();
+    pairIndex.resize(total);
+    pairFill.assign(pairStart.begin(), pairStart.end() - 1);
+    for (uint32_t p = 0; p < (uint32_t)pairs.size(); p++) {
+        pairIndex[pairFill[pairSlot[pairs[p].a]]++] = p;
+        pairIndex[pairFill[pairSlot[pairs[p].b]]++] = p;
+    }
+
+    impacts.clear();
+    for (const BallPair& pair : pairs) {
+        scheduleBallImpact(pair);
+    }
+    for (uint32_t i : awake) {
+        scheduleEdgeImpact(i);
+    }
+
+    // Resolve impacts in time order; each one restarts the paths of the balls it
+    // involves and reschedules only their impacts
+    size_t budget = maxImpactsPerBall * count;
+    while (!impacts.empty() && budget > 0) {
+        std::pop_heap(impacts.begin(), impacts.end(), impactLater);
+        SweptImpact impact = impacts.back();
+        impacts.pop_back();
+
+        if (impact.versionA != sweepVersion[impact.a]) continue;
+        if (!impact.edge && impact.versionB != sweepVersion[impact.b]) continue;
+        budget--;
+
+        if (impact.edge && cushionModel == CUSHION_FIELD) {
+            moveToImpact(impact.a, impact.time);
+            resolveFieldCollision(impact.a, fieldContactTolerance);
+            restartSweep(impact.a, impact.time, deltaTime);
+        }
+        else if (impact.edge) {
+            const Edge& edge = edges[impact.b];
+            moveToImpact(impact.a, impact.time);
+
+            glm::vec2 position = balls.position(impact.a);
+            glm::vec2 edgeVector = edge.end - edge.start;
+            float t = glm::clamp(glm::dot(position - edge.start, edgeVector) / glm::dot(edgeVector, edgeVector), 0.0f, 1.0f);
+            bounceOffEdge(impact.a, glm::normalize(position - (edge.start + edgeVector * t)));
+
+            restartSweep(impact.a, impact.time, deltaTime);
+        }
+        else {
+            events.push_back({ BALL_CONTACT, balls.number[impact.a], balls.number[impact.b] });
+            moveToImpact(impact.a, impact.time);
+            moveToImpact(impact.b, impact.time);
+            resolveBallCollision(impact.a, impact.b);
+            // The sleeping neighbours of a woken ball have not moved since the step began
+            for (const BallPair& pair : wokenPairs) {
+                beginSweep(pair.a);
+                beginSweep(pair.b);
+            }
+            pairs.insert(pairs.end(), wokenPairs.begin(), wokenPairs.end());
+            wokenPairs.clear();
+            restartSweep(impact.a, impact.time, deltaTime);
+            restartSweep(impact.b, impact.time, deltaTime);
+            stats.contacts++;
+        }
+    }
+
+    // Pockets are tested once every ball is at its true end position, so a ball
+    // cannot drop through a pocket it would have bounced away from. Balls woken on
+    // the way are in awake by now.
+    if (moving) {
+        updateAwakeRanges();
+        capturePocketedBalls(balls, awakeRanges, pockets, pocketZone, events);
+    }
+}
+
+float World::ballImpactTime(size_t a, size_t b) const {
+    float start = std::max(sweepStart[a], sweepStart[b]);
+    glm::vec2 delta = sweepDelta[b] - sweepDelta[a];
+    glm::vec2 gap = sweepOrigin[b] + sweepDelta[b] * start - (sweepOrigin[a] + sweepDelta[a] * start);
+
+    // Relative motion of b seen from a, as a point against a circle of both radii
+    float u = pointImpactTime(gap, delta, glm::vec2(0.0f), balls.radius[a] + balls.radius[b]);
+    if (u == noImpact || start + u > 1.0f) return noImpact;
+    return start + u;
+}
+
+float World::edgeImpactTime(size_t i, const Edge& edge) const {
+    float start = sweepStart[i];
+    glm::vec2 delta = sweepDelta[i];
+    if (delta.x == 0.0f && delta.y == 0.0f) return noImpact;
+
+    glm::vec2 position = sweepOrigin[i] + delta * start;
+    float edgeLength = edge.length;
+    glm::vec2 edgeDirection = edge.direction;
+    glm::vec2 edgeNormal = edge.perpendicular;
+    float contactDistance = balls.radius[i] + edge.cushionWidth;
+
+    // Too far from the cushion's line to reach any part of it this step
+    float offset = glm::dot(position - edge.start, edgeNormal);
+    float remaining = 1.0f - start;
+    if (std::abs(offset) - contactDistance > std::abs(glm::dot(delta, edgeNormal)) * remaining) return noImpact;
+
+    float best = noImpact;
+
+    // Flat face on whichever side the ball is
+    float side = offset >= 0.0f ? 1.0f : -1.0f;
+    float approach = side * glm::dot(delta, edgeNormal);
+    if (approach < 0.0f) {
+        float u = std::max(side * offset - contactDistance, 0.0f) / -approach;
+        float along = glm::dot(position + delta * u - edge.start, edgeDirection);
+        if (start + u <= 1.0f && along >= 0.0f && along <= edgeLength) {
+            best = start + u;
+        }
+    }
+
+    // Rounded ends of the cushion
+    const glm::vec2 ends[2] = { edge.start, edge.end };
+    for (glm::vec2 end : ends) {
+        float u = pointImpactTime(position, delta, end, contactDistance);
+        if (u != noImpact && start + u <= 1.0f && (best == noImpact || start + u < best)) {
+            best = start + u;
+        }
+    }
+
+    return best;
+}
+
+// First s at which ball i touches the boundary field while moving into it, found by
+// stepping along its path by the distance to the boundary
+float World::fieldImpactTime(size_t i) const {
+    float start = sweepStart[i];
+    glm::vec2 delta = sweepDelta[i];
+    float length = glm::length(delta);
+    if (length == 0.0f || !boundary || boundary->empty()) return noImpact;
+
+    // Leaving a contact, or inside a jaw, the distance says little; step on by this
+    float minStep = boundary->cellSize * 0.5f;
+
+    float s = start;
+    for (int k = 0; k < maxFieldSteps; k++) {
+        BoundarySample sample = boundary->sample(sweepOrigin[i] + delta * s);
+        float gap = sample.distance - balls.radius[i];
+        if (gap <= fieldContactTolerance && glm::dot(delta, sample.normal) < 0.0f) return s;
+
+        s += std::max(gap, minStep) / length;
+        if (s > 1.0f) return noImpact;
+    }
+    return noImpact;
+}
+
+// Heap order: earliest first, ties broken by kind and index so the result never
+// depends on heap internals
+bool World::impactLater(const SweptImpact& l, const SweptImpact& r) {
+    if (l.time != r.time) return l.time > r.time;
+    if (l.edge != r.edge) return l.edge < r.edge;
+    if (l.a != r.a) return l.a > r.a;
+    return l.b > r.b;
+}
+
+void World::pushImpact(const SweptImpact& impact) {
+    impacts.push_back(impact);
+    std::push_heap(impacts.begin(), impacts.end(), impactLater);
+}
+
+void World::scheduleBallImpact(const BallPair& pair) {
+    float s = ballImpactTime(pair.a, pair.b);
+    if (s != noImpact) {
+        pushImpact({ s, false, pair.a, pair.b, sweepVersion[pair.a], sweepVersion[pair.b] });
+    }
+}
+
+void World::scheduleEdgeImpact(size_t i) {
+    if (cushionModel == CUSHION_FIELD) {
+        float s = fieldImpactTime(i);
+        if (s != noImpact) {
+            pushImpact({ s, true, (uint32_t)i, 0, sweepVersion[i], 0 });
+        }
+        return;
+    }
+
+    // The rest of the path is at most this long
+    glm::vec2 position = sweepOrigin[i] + sweepDelta[i] * sweepStart[i];
+    if (clearOfCushions(i, position, glm::length(sweepDelta[i]) * (1.0f - sweepStart[i]))) return;
+
+    float first = noImpact;
+    uint32_t firstEdge = 0;
+    for (uint32_t e = 0; e < (uint32_t)edges.size(); e++) {
+        float s = edgeImpactTime(i, edges[e]);
+        if (s != noImpact && (first == noImpact || s < first)) {
+            first = s;
+            firstEdge = e;
+        }
+    }
+
+    if (first != noImpact) {
+        pushImpact({ first, true, (uint32_t)i, firstEdge, sweepVersion[i], 0 });
+    }
+}
+
+// Starts ball i's path for this step where it stands, once per step
+void World::beginSweep(uint32_t i) {
+    if (sweepStamp[i] == sweepEpoch) return;
+    sweepStamp[i] = sweepEpoch;
+    sweepOrigin[i] = balls.position(i);
+    sweepDelta[i] = glm::vec2(0.0f);
+    sweepStart[i] = 0.0f;
+    sweepVersion[i] = 0;
+    pairSlot[i] = noPairSlot;
+}
+
+void World::moveToImpact(size_t i, float s) {
+    balls.setPosition(i, sweepOrigin[i] + sweepDelta[i] * s);
+}
+
+// Continues ball i from its current position at s with its current velocity, then
+// reschedules everything it can hit on the new path
+void World::restartSweep(size_t i, float s, float deltaTime) {
+    glm::vec2 position = balls.position(i);
+    sweepDelta[i] = balls.velocity(i) * deltaTime;
+    sweepOrigin[i] = position - sweepDelta[i] * s;
+    sweepStart[i] = s;
+    sweepVersion[i]++;
+    balls.setPosition(i, position + sweepDelta[i] * (1.0f - s));
+
+    scheduleEdgeImpact(i);
+    if (pairSlot[i] != noPairSlot) {
+        for (uint32_t k = pairStart[pairSlot[i]]; k < pairStart[pairSlot[i] + 1]; k++) {
+            scheduleBallImpact(pairs[pairIndex[k]]);
+        }
+    }
+    for (size_t k = indexedPairs; k < pairs.size(); k++) {
+        if (pairs[k].a == i || pairs[k].b == i) scheduleBallImpact(pairs[k]);
+    }
+}
+
+void World::resolveBallCollision(size_t a, size_t b) {
+    bool asleepA = balls.asleep(a);
+    bool asleepB = balls.asleep(b);
+
+    if (!resolveContact(a, b)) return;
+
+    // A touched ball wakes even if it was only pushed aside; the sleep pass at the
+    // end of the step puts it back to sleep if it did not start moving
+    if (asleepA) wakeBall((uint32_t)a);
+    if (asleepB) wakeBall((uint32_t)b);
+}
+
+void World::wakeBall(uint32_t i) {
+    balls.flags[i] &= ~BALL_FLAG_ASLEEP;
+    awake.push_back(i);
+
+    broadPhase.findSleepingNeighbours(balls, i, neighbours);
+    for (uint32_t j : neighbours) {
+        wokenPairs.push_back(makePair(i, j));
+    }
+}
+
+// Returns false if the balls were left alone
+bool World::resolveContact(size_t a, size_t b) {
+    glm::vec2 delta = balls.position(b) - balls.position(a);
+    float distance = glm::length(delta);
+    if (distance <= 0.0f) return false;
+
+    glm::vec2 normal = delta / distance;
+    float velocityAlongNormal = glm::dot(balls.velocity(b) - balls.velocity(a), normal);
+
+    // Only resolve if balls are moving toward each other
+    if (velocityAlongNormal > 0) return false;
+
+    float combinedRestitution = (balls.restitution[a] + balls.restitution[b]) * 0.5f;
+    float j = -(1.0f + combinedRestitution) * velocityAlongNormal;
+    j /= 1.0f / balls.mass[a] + 1.0f / balls.mass[b];
+
+    glm::vec2 impulse = j * normal;
+    balls.setVelocity(a, balls.velocity(a) - impulse / balls.mass[a]);
+    balls.setVelocity(b, balls.velocity(b) + impulse / balls.mass[b]);
+
+    // Separate balls to prevent sticking
+    float overlap = balls.radius[a] + balls.radius[b] - distance;
+    if (overlap > 0) {
+        glm::vec2 separation = normal * overlap * 0.5f;
+        balls.setPosition(a, balls.position(a) - separation);
+        balls.setPosition(b, balls.position(b) + separation);
+    }
+    return true;
+}
+
+void World::resolveEdgeCollision(size_t i, const Edge& edge) {
+    glm::vec2 position = balls.position(i);
+    float edgeLength = edge.length;
+    glm::vec2 edgeDirection = edge.direction;
+
+    // Project ball position onto edge and clamp to the segment
+    float t = glm::clamp(glm::dot(position - edge.start, edgeDirection), 0.0f, edgeLength);
+    glm::vec2 closestPoint = edge.start + edgeDirection * t;
+
+    glm::vec2 collisionVector = position - closestPoint;
+    float distanceSquared = glm::dot(collisionVector, collisionVector);
+    float contactDistance = balls.radius[i] + edge.cushionWidth;
+    if (distanceSquared >= contactDistance * contactDistance || distanceSquared <= 0.0f) return;
+
+    float distance = std::sqrt(distanceSquared);
+    glm::vec2 collisionNormal = collisionVector / distance;
+
+    // Only bounce if moving toward edge
+    if (glm::dot(balls.velocity(i), collisionNormal) > 0) return;
+
+    bounceOffEdge(i, collisionNormal);
+
+    // Move ball out of edge to prevent sticking
+    balls.setPosition(i, position + collisionNormal * (contactDistance - distance));
+}
+
+void World::bounceOffEdge(size_t i, glm::vec2 normal) {
+    glm::vec2 velocity = balls.velocity(i);
+    float velocityAlongNormal = glm::dot(velocity, normal);
+    if (velocityAlongNormal > 0) return;
+
+    glm::vec2 bounced = velocity - (1.0f + balls.restitution[i]) * velocityAlongNormal * normal;
+    if (motionModel != MOTION_SPIN) {
+        balls.setVelocity(i, bounced);
+        return;
+    }
+
+    // The cushion grips the ball at its side, where side spin makes the surface slip
+    // along the cushion. Friction works against the slip, limited by the normal
+    // impulse; a solid sphere's slip changes by 7/2 of the speed it gives.
+    glm::vec2 tangent(-normal.y, normal.x);
+    float radius = balls.radius[i];
+    float slip = glm::dot(velocity, tangent) + radius * balls.wy[i];
+    float limit = cushionFriction * (1.0f + balls.restitution[i]) * -velocityAlongNormal;
+    float grip = glm::clamp(slip / 3.5f, -limit, limit);
+
+    balls.setVelocity(i, bounced - grip * tangent);
+    balls.wy[i] -= 2.5f * grip / radius;
+}
+
+// True if ball i at position cannot come within contact distance of any cushion while
+// moving at most reach, so its segment tests would all find nothing
+bool World::clearOfCushions(size_t i, glm::vec2 position, float reach) {
+    if (!boundary || boundary->empty() || !boundary->covers(position)) return false;
+    if (boundary->distance(position) - boundary->error() <= balls.radius[i] + reach) return false;
+
+    stats.cushionTestsSkipped++;
+    return true;
+}
+
+// Bounces ball i off the boundary field if it is within tolerance of it
+void World::resolveFieldCollision(size_t i, float tolerance) {
+    if (!boundary || boundary->empty()) return;
+
+    glm::vec2 position = balls.position(i);
+    BoundarySample sample = boundary->sample(position);
+    float gap = sample.distance - balls.radius[i];
+    if (gap > tolerance) return;
+
+    // Only bounce if moving toward the boundary
+    if (glm::dot(balls.velocity(i), sample.normal) > 0) return;
+
+    bounceOffEdge(i, sample.normal);
+
+    // Move ball out of the boundary to prevent sticking
+    if (gap < 0.0f) balls.setPosition(i, position - sample.normal * gap);
+}
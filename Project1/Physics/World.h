@@ -0,0 +1,300 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "PhysicsConstants.h"
+#include "BallStore.h"
+#include "BroadPhase.h"
+#include "ContactSolver.h"
+
+// All physics runs in the table plane: a glm::vec2 here is (x, z) of the rendered scene.
+struct Edge {
+    glm::vec2 start;
+    glm::vec2 end;
+    glm::vec2 normal;
+    float cushionWidth;
+
+    // Derived from start and end once, for the contact tests
+    glm::vec2 direction;
+    float length;
+    glm::vec2 perpendicular;
+
+    Edge(glm::vec2 s, glm::vec2 e, glm::vec2 n, float w)
+        : start(s), end(e), normal(n), cushionWidth(w),
+        direction((e - s) / glm::length(e - s)), length(glm::length(e - s)),
+        perpendicular(-direction.y, direction.x) {}
+};
+
+struct Pocket {
+    glm::vec2 position;
+    float radius;
+    float radiusSquared;
+
+    Pocket(glm::vec2 p, float r) : position(p), radius(r), radiusSquared(r * r) {}
+};
+
+// Open rectangle that no pocket reaches, so balls inside it skip the pocket test.
+// The default is empty: every ball is tested.
+struct PocketZone {
+    glm::vec2 min = glm::vec2(0.0f);
+    glm::vec2 max = glm::vec2(0.0f);
+
+    bool contains(float x, float z) const { return x > min.x && x < max.x && z > min.y && z < max.y; }
+};
+
+// Largest pocket-free rectangle found by trimming the pockets' centre bounds
+PocketZone pocketFreeZone(const std::vector<Pocket>& pockets);
+
+class BoundaryField;
+
+// Where ball/cushion contacts come from
+enum CushionModel {
+    // Exact tests against every cushion segment (and no jaws)
+    CUSHION_SEGMENTS = 0,
+    // The boundary field alone, one lookup per ball whatever the table's shape
+    CUSHION_FIELD = 1
+};
+
+// How ball/ball contacts are resolved
+enum ContactModel {
+    // One pair at a time, in pair order (or time of impact order in swept steps)
+    CONTACTS_PAIRWISE = 0,
+    // All contacts of a step at once by ContactSolver, in discrete steps
+    CONTACTS_ISLANDS = 1
+};
+
+// How a step moves each ball under rolling friction, a constant deceleration of
+// friction (m/s^2) against its direction of travel
+enum Integrator {
+    // Moves at the old velocity, then slows, stopping below stopSpeed; slowing can
+    // overshoot near rest. The original, and what earlier replays and hashes used.
+    INTEGRATOR_EULER = 0,
+    // Slows first, never past a stop, then moves at the new velocity
+    INTEGRATOR_SEMI_IMPLICIT = 1,
+    // The closed-form path, stopping at the exact time the speed reaches zero
+    INTEGRATOR_EXACT = 2,
+    // Classic fourth-order Runge-Kutta; a ball that friction stops within the step
+    // stops at its end
+    INTEGRATOR_RK4 = 3
+};
+
+// What a ball's motion is made of
+enum MotionModel {
+    // Balls only roll: no spin, friction is a constant deceleration, and world.integrator
+    // advances them. The original, and what earlier replays and hashes used.
+    MOTION_ROLLING = 0,
+    // Balls carry spin (BallStore::wx, wy, wz). A ball slides while its contact point
+    // slips, rolls once it stops slipping and then stops, and its side spin runs down;
+    // each change of phase is solved for its exact time within the step. Ball/ball
+    // contacts leave spin alone, so follow, draw and stun come out of the sliding that
+    // follows; cushions turn side spin into sideways speed.
+    MOTION_SPIN = 1
+};
+
+enum WorldEventType {
+    BALL_CONTACT = 0,
+    BALL_POCKETED = 1
+};
+
+// Events carry ball numbers, not indices, so they stay valid if the ball list is reordered.
+struct WorldEvent {
+    WorldEventType type;
+    int ballA;
+    int ballB;
+};
+
+// Counters for the last step(); awake and asleep count balls in play at its start
+struct StepStats {
+    size_t pairsTested;
+    size_t candidatePairs;
+    size_t contacts;
+    size_t awakeBalls;
+    size_t asleepBalls;
+    // Awake balls the boundary field showed to be clear of every cushion
+    size_t cushionTestsSkipped;
+    // With CONTACTS_ISLANDS: islands solved and contacts in the largest
+    size_t islands;
+    size_t largestIsland;
+};
+
+// Mixes value into a running hash, e.g. a per-step state hash into a history
+uint64_t hashCombine(uint64_t seed, uint64_t value);
+
+inline int32_t toFixedPoint(float value) { return (int32_t)std::lround(value * fixedPointScale); }
+inline float fromFixedPoint(int32_t value) { return value / fixedPointScale; }
+
+class World {
+public:
+    BallStore balls;
+    std::vector<Edge> edges;
+    std::vector<Pocket> pockets;
+
+    // Must not overlap any pocket; applyTableGeometry() sets it, and it can stay
+    // empty when pockets are set up by hand
+    PocketZone pocketZone;
+
+    // Signed distance field of the cushions and jaws, shared by copies of the world.
+    // With CUSHION_SEGMENTS it only skips the segment tests of balls clear of every
+    // cushion, which leaves results unchanged; CUSHION_FIELD takes contacts from it
+    // alone. applyTableGeometry() sets both, and the field must match edges.
+    std::shared_ptr<const BoundaryField> boundary;
+    CushionModel cushionModel = CUSHION_SEGMENTS;
+
+    // Selects brute force, grid or sweep and prune at runtime
+    BroadPhase broadPhase;
+
+    // Swept contact tests: each ball moves in a straight line during a step and
+    // contacts are resolved at their time of impact, so fast balls cannot pass
+    // through each other or a cushion however long the step is
+    bool continuousCollision = true;
+
+    // INTEGRATOR_EXACT keeps rolling paths exact at any step length, so 1/60 or 1/30
+    // s steps lose nothing between contacts. Replays record the choice.
+    Integrator integrator = INTEGRATOR_EULER;
+
+    // MOTION_SPIN moves balls by their own closed-form step and ignores integrator.
+    // strikeCueBall() only gives the cue ball spin under it. Replays record the choice;
+    // EventSimulator follows MOTION_ROLLING paths only.
+    MotionModel motionModel = MOTION_ROLLING;
+
+    // CONTACTS_ISLANDS takes discrete steps whatever continuousCollision says, and
+    // solves each step's contacts together with solver; touching clusters wake and
+    // move as one. Replays record the choice.
+    ContactModel contactModel = CONTACTS_PAIRWISE;
+    ContactSolver solver;
+
+    // Deterministic mode: every step takes exactly frameTime whatever deltaTime is
+    // passed, and stateHash/historyHash are updated after each step. Ball order, pair
+    // order and contact order are fixed anyway. Built without multiply-add
+    // contraction (-ffp-contract=off, /fp:precise; see the README) the SIMD kernels
+    // match the scalar code bit for bit and the same inputs give the same hashes on
+    // any thread count and instruction set; a build that contracts gives other hashes.
+    bool deterministic = false;
+
+    // With deterministic set, positions and velocities are rounded to multiples of
+    // 1 / fixedPointScale after every step, so the state is exactly representable as
+    // 16.16 fixed point (see toFixedPoint)
+    bool fixedPoint = false;
+
+    // Hash of the ball state after the last step, and the chain of all of them since
+    // historyHash was last reset
+    uint64_t stateHash = 0;
+    uint64_t historyHash = 0;
+
+    StepStats stats = {};
+
+    // Appended to by step(); the owner drains it (e.g. NineBallRules) and clears it.
+    std::vector<WorldEvent> events;
+
+    void step(float deltaTime);
+    bool isAtRest() const { return atRest; }
+
+    // True if any ball in play is moving or was set moving since the last step
+    bool hasAwakeBalls() const;
+
+    // Index of the ball with the given number in balls, or -1
+    int findBall(int number) const { return balls.indexOf(number); }
+
+    // 64-bit hash of every ball's number, flags, position and velocity bits, and spin
+    // bits under MOTION_SPIN
+    uint64_t computeStateHash() const;
+
+    // Heap bytes held by the balls, table, events, broad phase and step scratch,
+    // capacity included; a shared boundary field is not counted
+    size_t memoryBytes() const;
+
+private:
+    bool atRest = true;
+    std::vector<BallPair> pairs;
+
+    // Balls awake at the start of the step plus any woken by a contact during it.
+    // Balls at rest sleep until a contact or a shot moves them, so per-step work
+    // follows the moving balls rather than the whole table. The list is kept from
+    // step to step: the sleep pass drops the balls it puts to sleep, and the next
+    // step adds the ones BallStore logged as woken. It is rebuilt by a scan only
+    // when the balls' layout changes.
+    std::vector<uint32_t> awake;
+    uint64_t awakeLayout = 0;
+    // Lane blocks holding the awake balls, for the kernels
+    std::vector<BallRange> awakeRanges;
+
+    // Balls the broad phase has not seen move: put to sleep or pocketed by the last
+    // step, or changed from outside since
+    std::vector<uint32_t> moved;
+
+    // The broad phase skips pairs of two sleeping balls, so a ball woken mid-step
+    // brings its pairs with sleeping neighbours here for the step to pick up
+    std::vector<BallPair> wokenPairs;
+    std::vector<uint32_t> neighbours;
+
+    // Woken pairs still to be tested in a discrete step, a min-heap in pair order
+    std::vector<BallPair> pendingPairs;
+
+    // Path of each ball during a swept step: sweepOrigin + sweepDelta * s for s in
+    // [sweepStart, 1], s being the fraction of the step. A contact at s restarts the
+    // path there with the new velocity and bumps sweepVersion, which retires every
+    // impact scheduled against the old path. Only the awake balls and their partners
+    // have a path in a step: those whose sweepStamp is the step's sweepEpoch.
+    std::vector<glm::vec2> sweepOrigin;
+    std::vector<glm::vec2> sweepDelta;
+    std::vector<float> sweepStart;
+    std::vector<uint32_t> sweepVersion;
+    std::vector<uint32_t> sweepStamp;
+    uint32_t sweepEpoch = 0;
+
+    // Candidate pairs of each ball with a path and pairs: pairIndex[pairStart[s]..
+    // pairStart[s + 1]) index pairs, s being the ball's pairSlot (noPairSlot for none)
+    std::vector<uint32_t> pairSlot;
+    std::vector<uint32_t> pairStart;
+    std::vector<uint32_t> pairIndex;
+    std::vector<uint32_t> pairFill;
+    // Pairs past this count were added by woken balls and are not in the index
+    size_t indexedPairs = 0;
+
+    // Min-heap on time; for cushion contacts b is the edge index (0 with CUSHION_FIELD)
+    struct SweptImpact {
+        float time;
+        bool edge;
+        uint32_t a;
+        uint32_t b;
+        uint32_t versionA;
+        uint32_t versionB;
+    };
+    std::vector<SweptImpact> impacts;
+
+    std::vector<SolverContact> solverContacts;
+
+    void collectAwake();
+    void updateAwakeRanges();
+    bool integrate(float deltaTime);
+    void stepDiscrete(float deltaTime);
+    void snapToFixedPoint();
+    void stepSwept(float deltaTime);
+    void stepIslands(float deltaTime);
+
+    void resolveBallCollision(size_t a, size_t b);
+    bool resolveContact(size_t a, size_t b);
+    void wakeBall(uint32_t i);
+    void resolveEdgeCollision(size_t i, const Edge& edge);
+    void bounceOffEdge(size_t i, glm::vec2 normal);
+    bool clearOfCushions(size_t i, glm::vec2 position, float reach);
+    void resolveFieldCollision(size_t i, float tolerance);
+
+    float ballImpactTime(size_t a, size_t b) const;
+    float edgeImpactTime(size_t i, const Edge& edge) const;
+    float fieldImpactTime(size_t i) const;
+    void scheduleBallImpact(const BallPair& pair);
+    void scheduleEdgeImpact(size_t i);
+    void pushImpact(const SweptImpact& impact);
+    static bool impactLater(const SweptImpact& l, const SweptImpact& r);
+    void beginSweep(uint32_t i);
+    void moveToImpact(size_t i, float s);
+    void restartSweep(size_t i, float s, float deltaTime);
+};
+
+#endif
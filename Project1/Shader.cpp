@@ -1,7 +1,12 @@
 #include "Shader.h"
 
+#include <glm/gtc/type_ptr.hpp>
+
+int Shader::uniformUploads = 0;
+
 Shader::Shader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
 	shaderProgram = createShader(vertexShaderPath, fragmentShaderPath);
+	readUniforms();
 }
 
 Shader::~Shader() {
@@ -58,4 +63,56 @@ unsigned int Shader::createShader(const std::string& vertexShaderPath, const std
 	glDeleteShader(fragmentShader);
 
 	return program;
+}
+
+// Every active uniform's location, and the Frame block tied to its binding point
+void Shader::readUniforms() {
+	if (shaderProgram == 0) return;
+
+	GLint count = 0;
+	glGetProgramiv(shaderProgram, GL_ACTIVE_UNIFORMS, &count);
+	for (GLint i = 0; i < count; i++) {
+		char name[256];
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(shaderProgram, (GLuint)i, sizeof(name), &length, &size, &type, name);
+
+		// Block members have no location of their own
+		GLint location = glGetUniformLocation(shaderProgram, name);
+		if (location < 0) continue;
+
+		// Arrays are listed as "name[0]"; keep them under their plain name as well
+		std::string uniform(name, length);
+		uniformLocations[uniform] = location;
+		size_t bracket = uniform.find('[');
+		if (bracket != std::string::npos) uniformLocations[uniform.substr(0, bracket)] = location;
+	}
+
+	GLuint frameBlock = glGetUniformBlockIndex(shaderProgram, "Frame");
+	if (frameBlock != GL_INVALID_INDEX) glUniformBlockBinding(shaderProgram, frameBlock, frameUniformBinding);
+}
+
+GLint Shader::uniformLocation(const std::string& name) const {
+	auto found = uniformLocations.find(name);
+	return found == uniformLocations.end() ? -1 : found->second;
+}
+
+void Shader::use() const {
+	glUseProgram(shaderProgram);
+}
+
+void Shader::setInt(GLint location, int value) const {
+	glUniform1i(location, value);
+	uniformUploads++;
+}
+
+void Shader::setVec3(GLint location, const glm::vec3& value) const {
+	glUniform3fv(location, 1, glm::value_ptr(value));
+	uniformUploads++;
+}
+
+void Shader::setMat4(GLint location, const glm::mat4& value) const {
+	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	uniformUploads++;
 }
\ No newline at end of file
@@ -5,7 +5,23 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 #include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Camera and light for the 3D shaders, laid out as their std140 uniform block "Frame".
+// The game uploads it once per frame to a buffer bound at frameUniformBinding.
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    // xyz used; vec4 so the C++ layout matches std140
+    glm::vec4 lightPos;
+    glm::vec4 lightColor;
+    glm::vec4 viewPos;
+};
+static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 block");
+
+const GLuint frameUniformBinding = 0;
 
 class Shader {
 public:
@@ -14,9 +30,26 @@ public:
     Shader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
     ~Shader();
 
+    // Location of a uniform from the table read when the program linked, or -1 if the
+    // program has none by that name. Look locations up once and keep them; the setters
+    // take the location, so drawing needs no string lookups.
+    GLint uniformLocation(const std::string& name) const;
+
+    // The setters expect this program to be in use
+    void use() const;
+    void setInt(GLint location, int value) const;
+    void setVec3(GLint location, const glm::vec3& value) const;
+    void setMat4(GLint location, const glm::mat4& value) const;
+
+    // Uniform uploads through every Shader since the owner last set it to zero
+    static int uniformUploads;
+
 private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+
     unsigned int compileShader(GLenum type, const std::string& source);
     unsigned int createShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+    void readUniforms();
 };
 
 #endif
\ No newline at end of file
@@ -1,18 +1,24 @@
-﻿#include <iostream>
-#include <fstream>
-#include <sstream>
+﻿#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "FontAtlas.h"
 #include "TextRender.h"
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 TextRender::TextRender(const std::string& fontPath, const std::string& vertexShaderPath, const std::string& fragmentShaderPath, int fontSize) {
 
-    shaderProgram = createShader(vertexShaderPath, fragmentShaderPath);
+    shader = std::make_unique<Shader>(vertexShaderPath, fragmentShaderPath);
+
+    // The screen projection never changes, so it is set once
+    float width = 1200.0f;
+    float height = 850.0f;
+    shader->use();
+    shader->setMat4(shader->uniformLocation("projection"), glm::ortho(0.0f, width, 0.0f, height, -1.0f, 1.1f));
+    glUseProgram(0);
 
     loadCharacters(fontPath, fontSize);
 
@@ -20,9 +26,11 @@ TextRender::TextRender(const std::string& fontPath, const std::string& vertexSha
     glGenBuffers(1, &VBO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, nullptr, GL_DYNAMIC_DRAW);
+    // Position and atlas coordinates, then color
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, color));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
@@ -30,142 +38,79 @@ TextRender::TextRender(const std::string& fontPath, const std::string& vertexSha
 TextRender::~TextRender() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
-}
-
-unsigned int TextRender::compileShader(GLenum type, const std::string& source) {
-    unsigned int shader = glCreateShader(type);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    int success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Shader compilation failed:\n" << infoLog << std::endl;
-    }
-
-    return shader;
-}
-
-unsigned int TextRender::createShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
-    std::ifstream vsFile(vertexShaderPath);
-    std::ifstream fsFile(fragmentShaderPath);
-
-    if (!vsFile.is_open() || !fsFile.is_open()) {
-        std::cerr << "Failed to load shader files: " << vertexShaderPath << ", " << fragmentShaderPath << std::endl;
-        return 0;
-    }
-
-    std::stringstream vsStream, fsStream;
-    vsStream << vsFile.rdbuf();
-    fsStream << fsFile.rdbuf();
-
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vsStream.str());
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fsStream.str());
-
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
-        std::cerr << "Shader program linking failed:\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return program;
+    glDeleteTextures(1, &atlasTexture);
 }
 
 void TextRender::loadCharacters(const std::string& fontPath, int fontSize) {
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
-        std::cerr << "ERROR::FREETYPE: Could not initialize FreeType Library" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    FontAtlas atlas;
+    std::string error;
+    if (!loadFontAtlas(fontPath, fontSize, atlas, atlasFromCache, error)) {
+        std::cerr << "ERROR::FONT_ATLAS: " << error << std::endl;
         return;
     }
-
-    FT_Face face;
-    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
-        std::cerr << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        FT_Done_FreeType(ft);
-        return;
+    atlasLoadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    static_assert(characterCount == FontAtlas::glyphCount, "one atlas glyph per character");
+    glm::vec2 atlasSize((float)atlas.width, (float)atlas.height);
+    for (int c = 0; c < characterCount; c++) {
+        const AtlasGlyph& glyph = atlas.glyphs[c];
+        Character& character = Characters[c];
+        character.Size = glyph.size;
+        character.Bearing = glyph.bearing;
+        character.Advance = glyph.advance;
+        character.AtlasMin = glm::vec2(glyph.atlasOrigin) / atlasSize;
+        character.AtlasMax = glm::vec2(glyph.atlasOrigin + glyph.atlasSize) / atlasSize;
+        character.Loaded = glyph.loaded;
     }
 
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    for (unsigned char c = 0; c < 128; c++) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            std::cerr << "ERROR::FREETYPE: Failed to load Glyph" << std::endl;
-            continue;
-        }
-
-        GLuint texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-        );
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
-        };
-        Characters.insert(std::pair<char, Character>(c, character));
-    }
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, atlas.width, atlas.height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.pixels.data());
 
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 void TextRender::RenderText(const std::string& text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color) {
-    glUseProgram(shaderProgram);
-
-    float width = 1200.0f;
-    float height = 850.0f;
-
-    glm::mat4 projection = glm::ortho(0.0f, width, 0.0f, height, -1.0f, 1.1f);
-    GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
-
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    layOut(text, x, y, scale, color, vertices);
+    layouts++;
+}
 
-    glUniform3f(glGetUniformLocation(shaderProgram, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
+void TextRender::RenderLabel(TextLabel& label, std::string_view text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color) {
+    if (label.laidOut && text == label.text && x == label.x && y == label.y && scale == label.scale && color == label.color) {
+        labelHits++;
+    }
+    else {
+        label.text.assign(text.data(), text.size());
+        label.x = x;
+        label.y = y;
+        label.scale = scale;
+        label.color = color;
+        label.vertices.clear();
+        layOut(text, x, y, scale, color, label.vertices);
+        label.laidOut = true;
+        layouts++;
+    }
+    vertices.insert(vertices.end(), label.vertices.begin(), label.vertices.end());
+}
 
+// Appends six vertices per glyph, from the baseline at (x, y)
+void TextRender::layOut(std::string_view text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, std::vector<TextVertex>& out) {
     for (const char& c : text) {
-
-        if (Characters.find(c) == Characters.end()) {
+        unsigned char code = static_cast<unsigned char>(c);
+        if (code >= characterCount || !Characters[code].Loaded) {
             std::cerr << "WARNING::TEXT_RENDERER: Character '" << c
-                << "' (ASCII: " << static_cast<int>(c) << ") not found in Characters map." << std::endl;
+                << "' (ASCII: " << static_cast<int>(c) << ") not found in the atlas." << std::endl;
             continue; // Preskoči karakter
         }
 
-        Character ch = Characters[c];
+        const Character& ch = Characters[code];
 
         GLfloat xpos = x + ch.Bearing.x * scale;
         GLfloat ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
@@ -173,27 +118,41 @@ void TextRender::RenderText(const std::string& text, GLfloat x, GLfloat y, GLflo
         GLfloat w = ch.Size.x * scale;
         GLfloat h = ch.Size.y * scale;
 
-        GLfloat vertices[6][4] = {
-            { xpos,     ypos + h, 0.0f, 0.0f },
-            { xpos,     ypos,     0.0f, 1.0f },
-            { xpos + w, ypos,     1.0f, 1.0f },
+        glm::vec2 uvMin = ch.AtlasMin;
+        glm::vec2 uvMax = ch.AtlasMax;
+        out.insert(out.end(), {
+            { { xpos,     ypos + h }, { uvMin.x, uvMin.y }, color },
+            { { xpos,     ypos     }, { uvMin.x, uvMax.y }, color },
+            { { xpos + w, ypos     }, { uvMax.x, uvMax.y }, color },
 
-            { xpos,     ypos + h, 0.0f, 0.0f },
-            { xpos + w, ypos,     1.0f, 1.0f },
-            { xpos + w, ypos + h, 1.0f, 0.0f }
-        };
+            { { xpos,     ypos + h }, { uvMin.x, uvMin.y }, color },
+            { { xpos + w, ypos     }, { uvMax.x, uvMax.y }, color },
+            { { xpos + w, ypos + h }, { uvMax.x, uvMin.y }, color }
+        });
 
+        x += ch.Advance * scale;
+    }
+}
 
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
+void TextRender::flush() {
+    if (vertices.empty()) return;
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    shader->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glBindVertexArray(VAO);
 
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+    // Orphan the old storage so the driver need not wait for last frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    vertexCapacity = std::max(vertexCapacity, vertices.size());
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * sizeof(TextVertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(TextVertex), vertices.data());
+    bufferUploads++;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        x += (ch.Advance >> 6) * scale;
-    }
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    drawCalls++;
+    vertices.clear();
 
     glBindVertexArray(0);
     glUseProgram(0);
@@ -1,34 +1,87 @@
 ﻿#ifndef TEXT_RENDER_H
 #define TEXT_RENDER_H
 
-#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "Shader.h"
+
+// Metrics in pixels at the font size asked for. The quad covers the glyph's distance
+// field, so it runs past the outline on every side.
 struct Character {
-    GLuint TextureID;
-    glm::ivec2 Size;
-    glm::ivec2 Bearing;
-    GLuint Advance;
+    glm::vec2 Size;
+    glm::vec2 Bearing;
+    GLfloat Advance;
+    // Corners of the glyph in the atlas, in texture coordinates, top left first
+    glm::vec2 AtlasMin;
+    glm::vec2 AtlasMax;
+    bool Loaded = false;
+};
+
+// One corner of a glyph quad: screen position, atlas position and color
+struct TextVertex {
+    glm::vec2 position;
+    glm::vec2 texCoords;
+    glm::vec3 color;
+};
+
+// A string kept laid out between frames. RenderLabel lays it out again only when the
+// text, position, scale or color it is drawn with differ from the last layout.
+struct TextLabel {
+    std::string text;
+    GLfloat x = 0.0f;
+    GLfloat y = 0.0f;
+    GLfloat scale = 0.0f;
+    glm::vec3 color = glm::vec3(0.0f);
+    std::vector<TextVertex> vertices;
+    bool laidOut = false;
 };
 
+// All glyphs live in one signed distance field atlas (see FontAtlas.h), which stays
+// sharp at any scale and is baked once, then read from its cache file. RenderText
+// only lays text out into a batch; flush() draws everything added since the last
+// flush in a single call, so the game flushes once per frame after the last text.
 class TextRender {
 public:
     TextRender(const std::string& fontPath, const std::string& vertexShaderPath, const std::string& fragmentShaderPath, int fontSize);
 
     TextRender(const TextRender& textRender) = delete;
     void RenderText(const std::string& text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
+    // For text drawn every frame: adds the label's kept vertices to the batch
+    void RenderLabel(TextLabel& label, std::string_view text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
+    void flush();
     ~TextRender();
 
+    // Draw calls, vertex uploads, labels drawn as they were laid out and strings laid
+    // out (RenderText always lays out) since the owner last set them to zero
+    int drawCalls = 0;
+    int bufferUploads = 0;
+    int labelHits = 0;
+    int layouts = 0;
+
+    // Time to read or bake the atlas, in milliseconds, and which it was
+    double atlasLoadTime = 0.0;
+    bool atlasFromCache = false;
+
 private:
+    static const int characterCount = 128;
+
     GLuint VAO, VBO;
-    GLuint shaderProgram;
-    std::map<char, Character> Characters;
+    GLuint atlasTexture = 0;
+    std::unique_ptr<Shader> shader;
+    // Indexed by ASCII code
+    Character Characters[characterCount];
+
+    // This frame's text, and how many vertices the buffer has room for
+    std::vector<TextVertex> vertices;
+    size_t vertexCapacity = 0;
 
-    unsigned int compileShader(GLenum type, const std::string& source);
-    unsigned int createShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
     void loadCharacters(const std::string& fontPath, int fontSize);
+    void layOut(std::string_view text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color, std::vector<TextVertex>& out);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+    #version 330 core
+    layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec3 aNormal;
+    // Per ball
+    layout (location = 2) in vec4 aCentreRadius;
+    layout (location = 3) in vec3 aColor;
+    
+    // Camera and light, shared by the 3D shaders
+    layout (std140) uniform Frame {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
+    
+    out vec3 FragPos;
+    out vec3 Normal;
+    out vec3 Color;
+    
+    void main() {
+        // The unit sphere scaled and moved to the ball; its normals need no change
+        FragPos = aCentreRadius.xyz + aPos * aCentreRadius.w;
+        Normal = aNormal;
+        Color = aColor;
+        gl_Position = projection * view * vec4(FragPos, 1.0);
+    }
\ No newline at end of file
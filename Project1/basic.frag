@@ -2,30 +2,34 @@
     in vec3 FragPos;
     in vec3 Normal;
     
-    uniform vec3 lightPos;
-    uniform vec3 viewPos;
     uniform vec3 objectColor;
-    uniform vec3 lightColor;
+    layout (std140) uniform Frame {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
     
     out vec4 FragColor;
     
     void main() {
         // Ambient
         float ambientStrength = 0.2;
-        vec3 ambient = ambientStrength * lightColor;
+        vec3 ambient = ambientStrength * lightColor.rgb;
         
         // Diffuse
         vec3 norm = normalize(Normal);
-        vec3 lightDir = normalize(lightPos - FragPos);
+        vec3 lightDir = normalize(lightPos.xyz - FragPos);
         float diff = max(dot(norm, lightDir), 0.0);
-        vec3 diffuse = diff * lightColor;
+        vec3 diffuse = diff * lightColor.rgb;
         
         // Specular
         float specularStrength = 0.5;
-        vec3 viewDir = normalize(viewPos - FragPos);
+        vec3 viewDir = normalize(viewPos.xyz - FragPos);
         vec3 reflectDir = reflect(-lightDir, norm);
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-        vec3 specular = specularStrength * spec * lightColor;
+        vec3 specular = specularStrength * spec * lightColor.rgb;
         
         vec3 result = (ambient + diffuse + specular) * objectColor;
         FragColor = vec4(result, 1.0);
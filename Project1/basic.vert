@@ -3,8 +3,14 @@
     layout (location = 1) in vec3 aNormal;
     
     uniform mat4 model;
-    uniform mat4 view;
-    uniform mat4 projection;
+    // Camera and light, shared by the 3D shaders
+    layout (std140) uniform Frame {
+        mat4 view;
+        mat4 projection;
+        vec4 lightPos;
+        vec4 lightColor;
+        vec4 viewPos;
+    };
     
     out vec3 FragPos;
     out vec3 Normal;
@@ -4,9 +4,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
+#include <memory>
 #include <iostream>
 #include <string>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <map>
 
 #include "TextRender.h"
 #include "Shader.h"
@@ -15,6 +21,16 @@
 #include "Cue.h"
 #include "Button.h"
 #include "Constants.h"
+#include "Physics/World.h"
+#include "Physics/Table.h"
+#include "Physics/TableGeometry.h"
+#include "Physics/NineBallRules.h"
+#include "Physics/ShotEvaluator.h"
+#include "Physics/NineBallAI.h"
+#include "Physics/Replay.h"
+#include "Physics/PhysicsThread.h"
+#include "Physics/InputEvents.h"
+#include "Physics/JobSystem.h"
 
 std::map<int, std::string> ballNames = {
     {1, "Yellow"},
@@ -30,21 +46,21 @@ std::map<int, std::string> ballNames = {
 
 class BilliardsGame {
 private:
+    // Created by the first member, so on the main thread before anything submits
+    JobSystem& jobs = JobSystem::shared();
+
     GameStatus gameStatus;
-    int currentPlayer;
-    int lowestBallNumber;
-    bool firstBallHitCorrect;
-    int firstBallHit;
-    bool ballsPocketedThisTurn;
-    bool foulThisTurn;
-    glm::vec3 foulPosition;
-    int playerWon;
+    NineBallRules rules;
 
     GLFWwindow* window;
     GLuint shaderProgram;
     GLuint overlayShaderProgram;
     std::unique_ptr<Shader> shader;
     std::unique_ptr<Shader> overlayShader;
+    std::unique_ptr<Shader> ballShader;
+    // The basic shader's own uniforms; camera and light are in the Frame block
+    GLint modelLocation, objectColorLocation;
+    GLuint frameUniformBuffer;
 
     GLuint tableVAO, tableVBO, tableEBO;
     GLuint edgesVAO, edgesVBO, edgesEBO;
@@ -55,140 +71,221 @@ private:
     glm::mat4 projection;
 
     size_t edgeIndicesCount;
+    size_t holeIndicesCount;
     size_t totalTableIndices;
 
-    std::unique_ptr<Ball> cueBall;
-    std::vector<std::unique_ptr<Ball>> balls;
+    // Pockets, cushions and the meshes are all built from this
+    TableGeometry table;
+
+    // Physics state: world, rules, recorder and the turn fields below belong to the
+    // physics side. With the physics thread running, only updatePhysics(),
+    // publishState() and code inside physics->withState() may touch them; everything
+    // else reads the latest snapshot.
+    World world;
+    bool canShoot = true;
+    bool gameOver = false;
+    uint32_t turns = 0;
+    bool respotted = false;
+
+    // Runs the fixed steps, on a thread of its own with --physics-thread
+    std::unique_ptr<PhysicsThread> physics;
+    uint32_t turnsSeen = 0;
+    uint64_t shotSequence = UINT64_MAX;
+    bool showPhysicsStats = false;
+
+    // Indexed by ball number; 0 is the cue ball
+    std::vector<std::unique_ptr<Ball>> ballMeshes;
+    // Every ball is drawn from one sphere in a single instanced draw
+    std::unique_ptr<BallMesh> ballMesh;
+    std::vector<BallInstance> ballInstances;
+    // Display-only balls laid over the cloth with --render-balls, to load the renderer
+    std::vector<BallInstance> stressBalls;
+
+    // Counted through each render(); the F6 stats show the last whole frame
+    struct RenderCounts {
+        int drawCalls = 0;
+        int uniformUploads = 0;
+        // Uniform and instance buffers refilled
+        int bufferUploads = 0;
+        // Text drawn from kept layouts, and strings laid out
+        int labelHits = 0;
+        int layouts = 0;
+        // CPU time spent issuing the frame, in seconds
+        double cpuTime = 0.0;
+    };
+    RenderCounts renderCounts;
+    RenderCounts lastRenderCounts;
 
     float cueAngle = startCueAngle;
+    // Where the cue meets the cue ball, in ball radii from its centre: x is right english,
+    // y follow (up) or draw (down)
+    glm::vec2 cueTip = glm::vec2(0.0f);
     double lastMouseX = 0.0;
     bool firstMouse = true;
     GLuint cueVAO, cueVBO, cueEBO;
 
     std::unique_ptr<Cue> cue;
 
-    std::vector<Edge> tableEdges;
     float lastFrameTime;
 
-    bool canShoot = true;
+    // Player 2 is the computer when enabled; it searches on a copy of the table in the
+    // background as a job and plays once the decision is ready
+    bool cpuOpponent = false;
+    AIDifficulty cpuDifficulty = AI_MEDIUM;
+    NineBallAI ai;
+    JobHandle cpuSearch;
+    AIDecision cpuDecision;
+
+    // Every shot since the last rack is recorded; F5 saves the recording and plays it
+    // back, with the game frozen until F5 is pressed again
+    ReplayRecorder recorder;
+    ReplayPlayer replay;
+    bool replaying = false;
+
+    // Filled by the GLFW callbacks and drained at the start of each frame, so each
+    // press acts once and every event carries the time it arrived
+    InputQueue input;
+    bool dragging = false;
+    double cursorX = 0.0;
+    double cursorY = 0.0;
+    // Consumed events, written to the --record-input file on exit
+    std::string inputLogPath;
+    std::vector<InputEvent> inputLog;
+    // From the press that struck the cue ball to the first frame showing the shot
+    double strikeInputTime = -1.0;
+    double inputLatency = 0.0;
 
     std::unique_ptr<TextRender> textRender;
+    // Seconds from GLFW coming up to the game being ready, font atlas included
+    double startupTime = 0.0;
+    // The HUD's lines, or the replay's while one plays
+    std::vector<TextLabel> hudLabels;
 
     int selectedButton = 0;
 
     std::vector<Button> pauseButtons;
     std::vector<Button> endButtons;
 
-    void handleBallCollision(Ball* ball1, Ball* ball2) {
-        // If this is the first collision of the turn
-        if (firstBallHit == -1) {
-            // Determine which ball is the cue ball
-            if (ball1 == cueBall.get()) {
-                firstBallHit = ball2->number;
-            }
-            else if (ball2 == cueBall.get()) {
-                firstBallHit = ball1->number;
-            }
-
-            // Check if the correct ball was hit
-            firstBallHitCorrect = (firstBallHit == lowestBallNumber);
-        }
+    // Index of the cue ball in world.balls (physics side)
+    size_t cueBall() const {
+        return world.findBall(cueBallNumber);
     }
 
-    int findLowestBallNumber() {
-        int lowest = 9;
-
-        for (const auto& ball : balls) {
-            if (!ball->pocketed && ball->number < lowest) {
-                lowest = ball->number;
-            }
-        }
-
-        return lowest;
+    const SimulationSnapshot& view() const {
+        return physics->snapshot();
     }
 
-    void checkBallsPocketed() {
-        bool anyBallsPocketed = false;
+    bool cueBallOnTable() const {
+        return view().hasBall(cueBallNumber) && !view().pocketed[cueBallNumber];
+    }
 
-        if (!cueBall->pocketed) {
-            cueBall->checkHolePocketed();
-            if (cueBall->pocketed) {
-                // Handle scratch (cue ball pocketed)
-                handleFoul();
-            }
+    // Where ball number is drawn: from the replay while one is playing, otherwise
+    // between the last two physics steps. False if it is not on the table.
+    bool shownBall(int number, glm::vec3& position) const {
+        if (replaying) {
+            int i = replay.world.findBall(number);
+            if (i < 0 || replay.world.balls.pocketed(i)) return false;
+            position = glm::vec3(replay.world.balls.x[i], tableHeight, replay.world.balls.z[i]);
+            return true;
         }
 
-        for (const auto& ball : balls) {
-            bool wasPocketed = ball->pocketed;
-            if (!wasPocketed) {
-                ball->checkHolePocketed();
-                if (ball->pocketed && !wasPocketed) {
-                    anyBallsPocketed = true;
-                    ballsPocketedThisTurn = true;
-                }
-            }
-        }
+        const SimulationSnapshot& state = view();
+        if (!state.hasBall(number) || state.pocketed[number]) return false;
 
-        // Update lowest ball number if needed
-        lowestBallNumber = findLowestBallNumber();
+        glm::vec2 shown = state.positions[number];
+        if (!state.atRest) {
+            shown = glm::mix(state.previous[number], shown, physics->interpolationAlpha());
+        }
+        position = glm::vec3(shown.x, tableHeight, shown.y);
+        return true;
     }
 
-    void handleFoul() {
-        // Set the foul position to behind the head string
-        foulPosition = glm::vec3(-1.0f, tableHeight, 0.0f);
-
-        // Switch players
-        currentPlayer = (currentPlayer == 1) ? 2 : 1;
-
-        foulThisTurn = true;
+    // inputTime is when the shot was asked for, on the window clock
+    void executeShot(double inputTime) {
+        if (!canShootNow() || !cueBallOnTable()) return;
+
+        // Same strike as the shot evaluator uses, so its predictions match the game
+        ShotCandidate shot = { cueAngle, cue->shotPower, cueTip };
+        bool struck = false;
+        physics->withState([this, shot, &struck]() {
+            // The snapshot may be a step old
+            if (!canShoot || world.balls.pocketed(cueBall())) return;
+
+            // Reset turn tracking variables
+            rules.beginShot();
+
+            strikeCueBall(world, shot);
+            recorder.beginShot(world, shot);
+            canShoot = false;
+            struck = true;
+        });
+        if (!struck) return;
+
+        shotSequence = view().sequence;
+        strikeInputTime = inputTime;
+        cueTip = glm::vec2(0.0f);
+        cue->setShotPower(2.0f);
+        cue->updateGeometry();
     }
 
-    void handleWin() {
-        gameStatus = GameStatus::FINISHED;
-        playerWon = currentPlayer;
+    // The callbacks only queue events; processInput() acts on them
+    static void pushInput(GLFWwindow* window, InputEventType type, int code, int mods, double x, double y) {
+        BilliardsGame* game = static_cast<BilliardsGame*>(glfwGetWindowUserPointer(window));
+
+        InputEvent event;
+        event.time = glfwGetTime();
+        event.type = (uint8_t)type;
+        event.mods = (uint8_t)mods;
+        event.code = (int16_t)code;
+        event.x = (float)x;
+        event.y = (float)y;
+        game->input.push(event);
     }
 
-    void handleLose() {
-        gameStatus = GameStatus::FINISHED;
-
-        // Other player wins, but if they lost, its due to a foul which already changed them
-        playerWon = currentPlayer;
+    static void keyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int mods) {
+        // Held keys act once, on the press
+        if (action == GLFW_REPEAT) return;
+        pushInput(window, action == GLFW_PRESS ? INPUT_KEY_DOWN : INPUT_KEY_UP, key, mods, 0.0, 0.0);
     }
 
-    void executeShot() {
-        if (!canShoot || cueBall->pocketed) return;
-
-        // Reset turn tracking variables
-        firstBallHit = -1;
-        firstBallHitCorrect = false;
-        ballsPocketedThisTurn = false;
-        foulThisTurn = false;
-
-        // Calculate shot direction based on cue angle
-        glm::vec3 direction(
-            sin(cueAngle),
-            0.0f,
-            cos(cueAngle)
-        );
-
-        direction = glm::normalize(direction);
-        cueBall->velocity = direction * cue->shotPower;
-
-        cue->setShotPower(2.0f);
-        cue->updateGeometry();
-        canShoot = false;
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+        pushInput(window, action == GLFW_PRESS ? INPUT_BUTTON_DOWN : INPUT_BUTTON_UP, button, mods, 0.0, 0.0);
     }
 
     static void mouseCallback(GLFWwindow* window, double xpos, double ypos) {
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-            BilliardsGame* game = static_cast<BilliardsGame*>(glfwGetWindowUserPointer(window));
+        pushInput(window, INPUT_CURSOR, 0, 0, xpos, ypos);
+    }
 
-            if (game->gameStatus == GameStatus::PAUSED) return;
+    // Acts on the events that arrived since the last frame, in order
+    void processInput() {
+        InputEvent event;
+        while (input.pop(event)) {
+            if (!inputLogPath.empty()) inputLog.push_back(event);
 
-            game->processMouse(xpos, ypos);
+            if (event.type == INPUT_CURSOR) {
+                cursorX = event.x;
+                cursorY = event.y;
+                if (dragging && gameStatus != GameStatus::PAUSED) processMouse(cursorX, cursorY);
+            }
+            if ((event.type == INPUT_BUTTON_DOWN || event.type == INPUT_BUTTON_UP) && event.code == GLFW_MOUSE_BUTTON_LEFT) {
+                // Each drag turns the cue from where it starts
+                dragging = event.type == INPUT_BUTTON_DOWN;
+                firstMouse = true;
+            }
+
+            if (gameStatus == GameStatus::PAUSED) handlePauseInput(event);
+            else if (gameStatus == GameStatus::FINISHED) handleEndInput(event);
+            else if (event.type == INPUT_KEY_DOWN) handleInput(event.code, event.mods, event.time);
         }
     }
 
+    // Latency is measured once the first snapshot after the strike is on screen
+    void measureInputLatency() {
+        if (strikeInputTime < 0.0 || view().sequence == shotSequence) return;
+        inputLatency = glfwGetTime() - strikeInputTime;
+        strikeInputTime = -1.0;
+    }
+
     void initOpenGL() {
         glfwInit();
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -266,9 +363,10 @@ private:
         textRender = std::make_unique<TextRender>("font/Roboto-Regular.ttf", "text.vert", "text.frag", 20);
     }
 
-    void initializeBalls() {
+    void initializeBallMeshes() {
         // Define colors for numbered balls
         std::vector<glm::vec3> ballColors = {
+            glm::vec3(1.0f, 1.0f, 1.0f),    // Cue ball: White
             glm::vec3(1.0f, 1.0f, 0.0f),    // 1-ball: Yellow
             glm::vec3(0.0f, 0.0f, 1.0f),    // 2-ball: Blue
             glm::vec3(1.0f, 0.0f, 0.0f),    // 3-ball: Red
@@ -280,102 +378,35 @@ private:
             glm::vec3(1.0f, 1.0f, 0.4f)     // 9-ball: Yellow with white stripe
         };
 
-        // Calculate positions for diamond rack formation
-        float row_spacing = ballRadius * 2.1f;  // Slightly more than diameter for tight rack
-        float col_spacing = row_spacing * 0.866f;  // cos(30 degrees) for equilateral triangle spacing
-
-        // Rack position
-        float rackCenterX = 1.0f;  // Positive X for opposite side from cue ball
-        float rackCenterZ = 0.0f;  // Centered on Z axis
-
-        // Define rack positions
-        std::vector<glm::vec2> rackPositions = {
-            // Front (1-ball)
-            glm::vec2(rackCenterX - col_spacing * 2, rackCenterZ),
-            // Second row (2,3)
-            glm::vec2(rackCenterX - col_spacing, rackCenterZ - row_spacing / 2),
-            glm::vec2(rackCenterX - col_spacing, rackCenterZ + row_spacing / 2),
-            // Third row (4,9,5)
-            glm::vec2(rackCenterX, rackCenterZ - row_spacing),
-            glm::vec2(rackCenterX, rackCenterZ),  // 9-ball in center
-            glm::vec2(rackCenterX, rackCenterZ + row_spacing),
-            // Fourth row (6,7)
-            glm::vec2(rackCenterX + col_spacing, rackCenterZ - row_spacing / 2),
-            glm::vec2(rackCenterX + col_spacing, rackCenterZ + row_spacing / 2),
-            // Back (8-ball)
-            glm::vec2(rackCenterX + col_spacing * 2, rackCenterZ)
-        };
+        ballMeshes.clear();
 
-        balls.clear();
-
-        // Create the 9 numbered balls
-        for (int i = 0; i < 9; i++) {
-            balls.push_back(std::make_unique<Ball>(
-                rackPositions[i].x,
-                tableHeight,
-                rackPositions[i].y,
-                ballRadius,
-                ballColors[i],
-                i + 1
-            ));
+        for (int i = 0; i < (int)ballColors.size(); i++) {
+            ballMeshes.push_back(std::make_unique<Ball>(ballRadius, ballColors[i], i));
         }
+        ballMesh = std::make_unique<BallMesh>();
     }
 
-    void initializeEdges() {
-        const float cushionWidth = 0.125f;
-        const float holeRadius = 0.15f;
-        const float holeOffset = -holeRadius * 1.4142f + 0.1f; // sqrt(2) * holeRadius for diagonal offset
-
-        // Define the table edges with normals pointing inward
-        // Top edges
-        tableEdges.push_back(Edge(
-            glm::vec3(-2.0f + holeOffset, 0.0f, 1.0f - holeOffset),  // Start after top-left hole
-            glm::vec3(-holeOffset, 0.0f, 1.0f - holeOffset),         // End before top-middle hole
-            glm::vec3(0.0f, 0.0f, -1.0f),
-            cushionWidth
-        ));
-
-        tableEdges.push_back(Edge(
-            glm::vec3(holeOffset, 0.0f, 1.0f - holeOffset),          // Start after top-middle hole
-            glm::vec3(2.0f - holeOffset, 0.0f, 1.0f - holeOffset),   // End before top-right hole
-            glm::vec3(0.0f, 0.0f, -1.0f),
-            cushionWidth
-        ));
-
-        // Bottom edges
-        tableEdges.push_back(Edge(
-            glm::vec3(-2.0f + holeOffset, 0.0f, -1.0f + holeOffset), // Start after bottom-left hole
-            glm::vec3(-holeOffset, 0.0f, -1.0f + holeOffset),        // End before bottom-middle hole
-            glm::vec3(0.0f, 0.0f, 1.0f),
-            cushionWidth
-        ));
-
-        tableEdges.push_back(Edge(
-            glm::vec3(holeOffset, 0.0f, -1.0f + holeOffset),         // Start after bottom-middle hole
-            glm::vec3(2.0f - holeOffset, 0.0f, -1.0f + holeOffset),  // End before bottom-right hole
-            glm::vec3(0.0f, 0.0f, 1.0f),
-            cushionWidth
-        ));
-
-        // Left edge
-        tableEdges.push_back(Edge(
-            glm::vec3(-2.0f + holeOffset, 0.0f, 1.0f - holeOffset),  // Start after top-left hole
-            glm::vec3(-2.0f + holeOffset, 0.0f, -1.0f + holeOffset), // End before bottom-left hole
-            glm::vec3(1.0f, 0.0f, 0.0f),
-            cushionWidth
-        ));
-
-        // Right edge
-        tableEdges.push_back(Edge(
-            glm::vec3(2.0f - holeOffset, 0.0f, 1.0f - holeOffset),   // Start after top-right hole
-            glm::vec3(2.0f - holeOffset, 0.0f, -1.0f + holeOffset),  // End before bottom-right hole
-            glm::vec3(-1.0f, 0.0f, 0.0f),
-            cushionWidth
-        ));
+    // count balls in rows over the cloth, cycling through the ball colors
+    void addStressBalls(int count) {
+        if (count <= 0) return;
+        glm::vec2 half(table.halfLength - ballRadius, table.halfWidth - ballRadius);
+        int columns = std::max(1, (int)std::ceil(std::sqrt(count * half.x / half.y)));
+        int rows = (count + columns - 1) / columns;
+        for (int i = 0; i < count; i++) {
+            glm::vec2 cell((i % columns + 0.5f) / columns, (i / columns + 0.5f) / rows);
+            glm::vec2 centre = -half + 2.0f * half * cell;
+            const Ball& look = *ballMeshes[i % ballMeshes.size()];
+            stressBalls.push_back({ glm::vec3(centre.x, tableHeight, centre.y), ballRadius, look.color });
+        }
+    }
+
+    // Physics side
+    void initializeBalls() {
+        rackNineBall(world);
+        recorder.begin(world);
     }
 
     void setupHoles() {
-        const float holeRadius = 0.15f;
         const int segments = 32;
         const float depth = -0.05f;
         const float holeElevation = 0.06f;
@@ -383,33 +414,26 @@ private:
         std::vector<float> vertices;
         std::vector<unsigned int> indices;
 
-        // Hole positions
-        std::vector<glm::vec2> holePositions = {
-            glm::vec2(-2.0f, 1.0f),    // Top-left corner
-            glm::vec2(0.0f, 1.0f),     // Top-middle
-            glm::vec2(2.0f, 1.0f),     // Top-right corner
-            glm::vec2(-2.0f, -1.0f),   // Bottom-left corner
-            glm::vec2(0.0f, -1.0f),    // Bottom-middle
-            glm::vec2(2.0f, -1.0f)     // Bottom-right corner
-        };
-
         // Generate vertices and indices for each hole
-        for (size_t h = 0; h < holePositions.size(); h++) {
+        for (size_t h = 0; h < table.pockets.size(); h++) {
+            glm::vec2 holePosition = table.pockets[h].position;
+            float holeRadius = table.pockets[h].radius;
+
             // Store the starting vertex index for this hole
             int baseVertex = vertices.size() / 6;
 
             // Add center vertex at the top
-            vertices.push_back(holePositions[h].x);  // x
+            vertices.push_back(holePosition.x);      // x
             vertices.push_back(holeElevation);       // y
-            vertices.push_back(holePositions[h].y);  // z
+            vertices.push_back(holePosition.y);      // z
             vertices.push_back(0.0f);                // normal x
             vertices.push_back(-1.0f);               // normal y
             vertices.push_back(0.0f);                // normal z
 
             // Add center vertex at the bottom
-            vertices.push_back(holePositions[h].x);  // x
+            vertices.push_back(holePosition.x);      // x
             vertices.push_back(depth);               // y
-            vertices.push_back(holePositions[h].y);  // z
+            vertices.push_back(holePosition.y);      // z
             vertices.push_back(0.0f);                // normal x
             vertices.push_back(-1.0f);               // normal y
             vertices.push_back(0.0f);                // normal z
@@ -417,8 +441,8 @@ private:
             // Generate circle vertices at top and bottom
             for (int i = 0; i <= segments; i++) {
                 float angle = 2.0f * M_PI * float(i) / float(segments);
-                float x = holePositions[h].x + holeRadius * cos(angle);
-                float z = holePositions[h].y + holeRadius * sin(angle);
+                float x = holePosition.x + holeRadius * cos(angle);
+                float z = holePosition.y + holeRadius * sin(angle);
 
                 // Top rim vertex
                 vertices.push_back(x);
@@ -459,6 +483,8 @@ private:
             }
         }
 
+        holeIndicesCount = indices.size();
+
         glGenVertexArrays(1, &holesVAO);
         glGenBuffers(1, &holesVBO);
         glGenBuffers(1, &holesEBO);
@@ -481,109 +507,72 @@ private:
 
     void setupTable() {
         const float legWidth = 0.1f;
-        const float legHeight = 0.7f;
+        const float legInset = 0.1f;
+        const float x = table.halfLength;
+        const float z = table.halfWidth;
+        const float bottom = -table.bedThickness;
+        const float legBottom = -table.legHeight;
+
         // Vertices for the table (position, normal)
         std::vector<float> vertices = {
-            // Original table vertices (top surface, sides, bottom)
             // Top surface
-            -2.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,  // 0
-             2.0f,  0.0f,  1.0f,   0.0f,  1.0f,  0.0f,  // 1
-             2.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,  // 2
-            -2.0f,  0.0f, -1.0f,   0.0f,  1.0f,  0.0f,  // 3
+            -x,  0.0f,  z,        0.0f,  1.0f,  0.0f,  // 0
+             x,  0.0f,  z,        0.0f,  1.0f,  0.0f,  // 1
+             x,  0.0f, -z,        0.0f,  1.0f,  0.0f,  // 2
+            -x,  0.0f, -z,        0.0f,  1.0f,  0.0f,  // 3
 
             // Front face
-            -2.0f,  0.0f,  1.0f,   0.0f,  0.0f,  1.0f,  // 4
-             2.0f,  0.0f,  1.0f,   0.0f,  0.0f,  1.0f,  // 5
-             2.0f, -0.2f,  1.0f,   0.0f,  0.0f,  1.0f,  // 6
-            -2.0f, -0.2f,  1.0f,   0.0f,  0.0f,  1.0f,  // 7
+            -x,  0.0f,  z,        0.0f,  0.0f,  1.0f,  // 4
+             x,  0.0f,  z,        0.0f,  0.0f,  1.0f,  // 5
+             x,  bottom,  z,      0.0f,  0.0f,  1.0f,  // 6
+            -x,  bottom,  z,      0.0f,  0.0f,  1.0f,  // 7
 
             // Back face
-            -2.0f,  0.0f, -1.0f,   0.0f,  0.0f, -1.0f,  // 8
-             2.0f,  0.0f, -1.0f,   0.0f,  0.0f, -1.0f,  // 9
-             2.0f, -0.2f, -1.0f,   0.0f,  0.0f, -1.0f,  // 10
-            -2.0f, -0.2f, -1.0f,   0.0f,  0.0f, -1.0f,  // 11
+            -x,  0.0f, -z,        0.0f,  0.0f, -1.0f,  // 8
+             x,  0.0f, -z,        0.0f,  0.0f, -1.0f,  // 9
+             x,  bottom, -z,      0.0f,  0.0f, -1.0f,  // 10
+            -x,  bottom, -z,      0.0f,  0.0f, -1.0f,  // 11
 
             // Left face
-            -2.0f,  0.0f,  1.0f,  -1.0f,  0.0f,  0.0f,  // 12
-            -2.0f,  0.0f, -1.0f,  -1.0f,  0.0f,  0.0f,  // 13
-            -2.0f, -0.2f, -1.0f,  -1.0f,  0.0f,  0.0f,  // 14
-            -2.0f, -0.2f,  1.0f,  -1.0f,  0.0f,  0.0f,  // 15
+            -x,  0.0f,  z,       -1.0f,  0.0f,  0.0f,  // 12
+            -x,  0.0f, -z,       -1.0f,  0.0f,  0.0f,  // 13
+            -x,  bottom, -z,     -1.0f,  0.0f,  0.0f,  // 14
+            -x,  bottom,  z,     -1.0f,  0.0f,  0.0f,  // 15
 
             // Right face
-             2.0f,  0.0f,  1.0f,   1.0f,  0.0f,  0.0f,  // 16
-             2.0f,  0.0f, -1.0f,   1.0f,  0.0f,  0.0f,  // 17
-             2.0f, -0.2f, -1.0f,   1.0f,  0.0f,  0.0f,  // 18
-             2.0f, -0.2f,  1.0f,   1.0f,  0.0f,  0.0f,  // 19
-
-             // Bottom face
-             -2.0f, -0.2f,  1.0f,   0.0f, -1.0f,  0.0f,  // 20
-              2.0f, -0.2f,  1.0f,   0.0f, -1.0f,  0.0f,  // 21
-              2.0f, -0.2f, -1.0f,   0.0f, -1.0f,  0.0f,  // 22
-             -2.0f, -0.2f, -1.0f,   0.0f, -1.0f,  0.0f,  // 23
-
-             // Table Legs (4 corners + 2 middle supports)
-             // Front Left Leg
-             -1.9f, -0.2f,  0.9f,   0.0f,  1.0f,  0.0f,  // 24
-             -1.8f, -0.2f,  0.9f,   0.0f,  1.0f,  0.0f,  // 25
-             -1.8f, -0.2f,  0.8f,   0.0f,  1.0f,  0.0f,  // 26
-             -1.9f, -0.2f,  0.8f,   0.0f,  1.0f,  0.0f,  // 27
-             -1.9f, -legHeight,  0.9f,   0.0f,  1.0f,  0.0f,  // 28
-             -1.8f, -legHeight,  0.9f,   0.0f,  1.0f,  0.0f,  // 29
-             -1.8f, -legHeight,  0.8f,   0.0f,  1.0f,  0.0f,  // 30
-             -1.9f, -legHeight,  0.8f,   0.0f,  1.0f,  0.0f,  // 31
-
-             // Front Right Leg
-              1.9f, -0.2f,  0.9f,   0.0f,  1.0f,  0.0f,  // 32
-              1.8f, -0.2f,  0.9f,   0.0f,  1.0f,  0.0f,  // 33
-              1.8f, -0.2f,  0.8f,   0.0f,  1.0f,  0.0f,  // 34
-              1.9f, -0.2f,  0.8f,   0.0f,  1.0f,  0.0f,  // 35
-              1.9f, -legHeight,  0.9f,   0.0f,  1.0f,  0.0f,  // 36
-              1.8f, -legHeight,  0.9f,   0.0f,  1.0f,  0.0f,  // 37
-              1.8f, -legHeight,  0.8f,   0.0f,  1.0f,  0.0f,  // 38
-              1.9f, -legHeight,  0.8f,   0.0f,  1.0f,  0.0f,  // 39
-
-              // Back Left Leg
-              -1.9f, -0.2f, -0.9f,   0.0f,  1.0f,  0.0f,  // 40
-              -1.8f, -0.2f, -0.9f,   0.0f,  1.0f,  0.0f,  // 41
-              -1.8f, -0.2f, -0.8f,   0.0f,  1.0f,  0.0f,  // 42
-              -1.9f, -0.2f, -0.8f,   0.0f,  1.0f,  0.0f,  // 43
-              -1.9f, -legHeight, -0.9f,   0.0f,  1.0f,  0.0f,  // 44
-              -1.8f, -legHeight, -0.9f,   0.0f,  1.0f,  0.0f,  // 45
-              -1.8f, -legHeight, -0.8f,   0.0f,  1.0f,  0.0f,  // 46
-              -1.9f, -legHeight, -0.8f,   0.0f,  1.0f,  0.0f,  // 47
-
-              // Back Right Leg
-               1.9f, -0.2f, -0.9f,   0.0f,  1.0f,  0.0f,  // 48
-               1.8f, -0.2f, -0.9f,   0.0f,  1.0f,  0.0f,  // 49
-               1.8f, -0.2f, -0.8f,   0.0f,  1.0f,  0.0f,  // 50
-               1.9f, -0.2f, -0.8f,   0.0f,  1.0f,  0.0f,  // 51
-               1.9f, -legHeight, -0.9f,   0.0f,  1.0f,  0.0f,  // 52
-               1.8f, -legHeight, -0.9f,   0.0f,  1.0f,  0.0f,  // 53
-               1.8f, -legHeight, -0.8f,   0.0f,  1.0f,  0.0f,  // 54
-               1.9f, -legHeight, -0.8f,   0.0f,  1.0f,  0.0f,  // 55
-
-               // Middle Support Legs
-               // Front Middle
-                0.1f, -0.2f,  0.9f,   0.0f,  1.0f,  0.0f,  // 56
-               -0.1f, -0.2f,  0.9f,   0.0f,  1.0f,  0.0f,  // 57
-               -0.1f, -0.2f,  0.8f,   0.0f,  1.0f,  0.0f,  // 58
-                0.1f, -0.2f,  0.8f,   0.0f,  1.0f,  0.0f,  // 59
-                0.1f, -legHeight,  0.9f,   0.0f,  1.0f,  0.0f,  // 60
-               -0.1f, -legHeight,  0.9f,   0.0f,  1.0f,  0.0f,  // 61
-               -0.1f, -legHeight,  0.8f,   0.0f,  1.0f,  0.0f,  // 62
-                0.1f, -legHeight,  0.8f,   0.0f,  1.0f,  0.0f,  // 63
-
-                // Back Middle
-                 0.1f, -0.2f, -0.9f,   0.0f,  1.0f,  0.0f,  // 64
-                -0.1f, -0.2f, -0.9f,   0.0f,  1.0f,  0.0f,  // 65
-                -0.1f, -0.2f, -0.8f,   0.0f,  1.0f,  0.0f,  // 66
-                 0.1f, -0.2f, -0.8f,   0.0f,  1.0f,  0.0f,  // 67
-                 0.1f, -legHeight, -0.9f,   0.0f,  1.0f,  0.0f,  // 68
-                -0.1f, -legHeight, -0.9f,   0.0f,  1.0f,  0.0f,  // 69
-                -0.1f, -legHeight, -0.8f,   0.0f,  1.0f,  0.0f,  // 70
-                 0.1f, -legHeight, -0.8f,   0.0f,  1.0f,  0.0f   // 71
+             x,  0.0f,  z,        1.0f,  0.0f,  0.0f,  // 16
+             x,  0.0f, -z,        1.0f,  0.0f,  0.0f,  // 17
+             x,  bottom, -z,      1.0f,  0.0f,  0.0f,  // 18
+             x,  bottom,  z,      1.0f,  0.0f,  0.0f,  // 19
+
+            // Bottom face
+            -x,  bottom,  z,      0.0f, -1.0f,  0.0f,  // 20
+             x,  bottom,  z,      0.0f, -1.0f,  0.0f,  // 21
+             x,  bottom, -z,      0.0f, -1.0f,  0.0f,  // 22
+            -x,  bottom, -z,      0.0f, -1.0f,  0.0f   // 23
         };
 
+        // A leg is a box from x0 to x1 and z0 to z1, hanging from the bottom face
+        auto addLeg = [&](float x0, float x1, float z0, float z1) {
+            const float corners[4][2] = { { x0, z0 }, { x1, z0 }, { x1, z1 }, { x0, z1 } };
+            for (float y : { bottom, legBottom }) {
+                for (const auto& corner : corners) {
+                    vertices.insert(vertices.end(), { corner[0], y, corner[1], 0.0f, 1.0f, 0.0f });
+                }
+            }
+        };
+
+        // Four corner legs, then a middle support on each long side
+        const float outer = legInset;
+        const float inner = legInset + legWidth;
+        for (float side : { 1.0f, -1.0f }) {
+            addLeg(-x + outer, -x + inner, side * (z - outer), side * (z - inner));
+            addLeg(x - outer, x - inner, side * (z - outer), side * (z - inner));
+        }
+        for (float side : { 1.0f, -1.0f }) {
+            addLeg(legWidth, -legWidth, side * (z - outer), side * (z - inner));
+        }
+
         // Indices for the table
         std::vector<unsigned int> indices = {
             // Original table indices
@@ -637,13 +626,10 @@ private:
             indices.push_back(baseIndex + 7);
             };
 
-        // Add indices for all legs
-        addLegIndices(24);  // Front Left Leg
-        addLegIndices(32);  // Front Right Leg
-        addLegIndices(40);  // Back Left Leg
-        addLegIndices(48);  // Back Right Leg
-        addLegIndices(56);  // Front Middle Support
-        addLegIndices(64);  // Back Middle Support
+        // Add indices for all legs, 8 vertices each after the 24 of the table
+        for (unsigned int baseIndex = 24; baseIndex < vertices.size() / 6; baseIndex += 8) {
+            addLegIndices(baseIndex);
+        }
 
         glGenVertexArrays(1, &tableVAO);
         glGenBuffers(1, &tableVBO);
@@ -668,58 +654,18 @@ private:
     }
 
     void setupEdges() {
-        const float cushionWidth = 0.125f;
-        const float cushionHeight = 0.02f;
-        const float holeRadius = 0.15f;
-
-        // Hole positions
-        std::vector<glm::vec2> holePositions = {
-            glm::vec2(-2.0f, 1.0f),    // Top-left (0)
-            glm::vec2(0.0f, 1.0f),     // Top-middle (1)
-            glm::vec2(2.0f, 1.0f),     // Top-right (2)
-            glm::vec2(-2.0f, -1.0f),   // Bottom-left (3)
-            glm::vec2(0.0f, -1.0f),    // Bottom-middle (4)
-            glm::vec2(2.0f, -1.0f)     // Bottom-right (5)
-        };
-
-        // Define edge segments (start and end positions)
-        std::vector<std::pair<glm::vec2, glm::vec2>> edgeSegments = {
-            // Top cushions
-            {glm::vec2(-2.0f + holeRadius, 1.0f), glm::vec2(-holeRadius, 1.0f)},      // Top-left to top-middle
-            {glm::vec2(holeRadius, 1.0f), glm::vec2(2.0f - holeRadius, 1.0f)},        // Top-middle to top-right
-
-            // Bottom cushions
-            {glm::vec2(-2.0f + holeRadius, -1.0f), glm::vec2(-holeRadius, -1.0f)},    // Bottom-left to bottom-middle
-            {glm::vec2(holeRadius, -1.0f), glm::vec2(2.0f - holeRadius, -1.0f)},      // Bottom-middle to bottom-right
-
-            // Side cushions
-            {glm::vec2(-2.0f, 1.0f - holeRadius), glm::vec2(-2.0f, -1.0f + holeRadius)},  // Left side
-            {glm::vec2(2.0f, 1.0f - holeRadius), glm::vec2(2.0f, -1.0f + holeRadius)}     // Right side
-        };
+        const float cushionHeight = table.cushionHeight;
 
         std::vector<float> vertices;
         std::vector<int> indices;
         int vertexCount = 0;
 
-        // Generate vertices and indices for each edge segment
-        for (int i = 0; i < edgeSegments.size(); i++) {
-            const auto& segment = edgeSegments[i];
-            glm::vec2 start = segment.first;
-            glm::vec2 end = segment.second;
-            glm::vec2 direction = glm::normalize(end - start);
-            glm::vec2 normal(-direction.y, direction.x);
-
-            // Calculate inner points
-            glm::vec2 startInner, endInner;
-
-            if (i == 4 || i == 2 || i == 3) { // Left side cushion OR top cushion - invert normal direction
-                startInner = start - normal * cushionWidth;
-                endInner = end - normal * cushionWidth;
-            }
-            else {
-                startInner = start + normal * cushionWidth;
-                endInner = end + normal * cushionWidth;
-            }
+        // Generate vertices and indices for each cushion, from the table edge outwards
+        for (const CushionRail& rail : table.rails) {
+            glm::vec2 start = rail.innerStart;
+            glm::vec2 end = rail.innerEnd;
+            glm::vec2 startInner = rail.outerStart;
+            glm::vec2 endInner = rail.outerEnd;
 
             // Outer face
             vertices.insert(vertices.end(), {
@@ -757,6 +703,35 @@ private:
             vertexCount += 8;
         }
 
+        // Jaws as cushion-high cylinders: a side quad and a top triangle per segment
+        const int jawSegments = 16;
+        for (const CushionJaw& jaw : table.jaws) {
+            int centre = vertexCount;
+            vertices.insert(vertices.end(), { jaw.centre.x, cushionHeight, jaw.centre.y, 0.0f, 1.0f, 0.0f });
+            vertexCount++;
+
+            for (int i = 0; i <= jawSegments; i++) {
+                float angle = 2.0f * M_PI * float(i) / float(jawSegments);
+                glm::vec2 normal(cos(angle), sin(angle));
+                glm::vec2 point = jaw.centre + normal * jaw.radius;
+                vertices.insert(vertices.end(), {
+                    point.x, 0.0f, point.y,             normal.x, 0.0f, normal.y,
+                    point.x, cushionHeight, point.y,    normal.x, 0.0f, normal.y,
+                    point.x, cushionHeight, point.y,    0.0f, 1.0f, 0.0f
+                    });
+
+                if (i > 0) {
+                    int previous = vertexCount - 3;
+                    indices.insert(indices.end(), {
+                        previous, vertexCount, vertexCount + 1,
+                        previous, vertexCount + 1, previous + 1,
+                        centre, previous + 2, vertexCount + 2
+                        });
+                }
+                vertexCount += 3;
+            }
+        }
+
         edgeIndicesCount = indices.size();
 
         // Create and bind buffers
@@ -798,7 +773,9 @@ private:
         glm::mat4 model = glm::mat4(1.0f);
 
         // Position the cue at the cue ball
-        model = glm::translate(model, cueBall->position);
+        glm::vec3 cueBallPosition;
+        if (!shownBall(cueBallNumber, cueBallPosition)) return;
+        model = glm::translate(model, cueBallPosition);
 
         // Rotate around the cue ball
         model = glm::rotate(model, cueAngle, glm::vec3(0.0f, 1.0f, 0.0f));
@@ -806,84 +783,79 @@ private:
         // Move the cue back so it doesn't intersect with the ball
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, -0.15f));
 
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        shader->setMat4(modelLocation, model);
 
         // Set cue color (wooden brown)
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.545f, 0.271f, 0.075f);
+        shader->setVec3(objectColorLocation, glm::vec3(0.545f, 0.271f, 0.075f));
 
         glBindVertexArray(cue->VAO);
         glDrawElements(GL_TRIANGLES, cue->indices.size(), GL_UNSIGNED_INT, 0);
+        renderCounts.drawCalls++;
     }
 
-    void renderTable() {
-        glUseProgram(shaderProgram);
-
-        // Enhanced lighting setup
-        glm::vec3 lightPos(2.0f, 5.0f, 2.0f);
-        glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
+    // Camera and light for every 3D shader, in one upload per frame
+    void updateFrameUniforms() {
+        FrameUniforms frame;
+        frame.view = camera.getViewMatrix();
+        frame.projection = projection;
+        frame.lightPos = glm::vec4(2.0f, 5.0f, 2.0f, 1.0f);
+        frame.lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        frame.viewPos = glm::vec4(camera.position, 1.0f);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frame), &frame);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        renderCounts.bufferUploads++;
+    }
 
-        // Set lighting uniforms
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, glm::value_ptr(lightPos));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(lightColor));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(camera.position));
+    void renderTable() {
+        shader->use();
 
-        // Set transformation matrices
-        glm::mat4 model = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(camera.getViewMatrix()));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        // The table does not move
+        shader->setMat4(modelLocation, glm::mat4(1.0f));
 
         glBindVertexArray(tableVAO);
 
         // Draw table top (green felt)
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.0f, 0.5f, 0.0f);
+        shader->setVec3(objectColorLocation, glm::vec3(0.0f, 0.5f, 0.0f));
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);  // Original table surface indices
+        renderCounts.drawCalls++;
 
         // Draw table legs (dark brown)
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.2f, 0.1f, 0.05f);
+        shader->setVec3(objectColorLocation, glm::vec3(0.2f, 0.1f, 0.05f));
         glDrawElements(GL_TRIANGLES, totalTableIndices - 36, GL_UNSIGNED_INT, (void*)(36 * sizeof(unsigned int)));
+        renderCounts.drawCalls++;
 
         // Draw edges (brown)
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.545f, 0.271f, 0.075f);
+        shader->setVec3(objectColorLocation, glm::vec3(0.545f, 0.271f, 0.075f));
         glBindVertexArray(edgesVAO);
         glDrawElements(GL_TRIANGLES, edgeIndicesCount, GL_UNSIGNED_INT, 0);
+        renderCounts.drawCalls++;
 
         // Draw holes (black)
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.0f, 0.0f, 0.0f);
+        shader->setVec3(objectColorLocation, glm::vec3(0.0f, 0.0f, 0.0f));
         glBindVertexArray(holesVAO);
-        glDrawElements(GL_TRIANGLES, 6 * 32 * 6 * 2, GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, holeIndicesCount, GL_UNSIGNED_INT, 0);
+        renderCounts.drawCalls++;
     }
 
+    // The cue ball and every ball on the table, plus any stress balls, in one draw
     void renderBalls() {
-        for (const auto& ball : balls) {
-            if(ball->pocketed) continue;
-
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, ball->position);
-            model = glm::scale(model, glm::vec3(ball->radius));
-
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-            glUniform3fv(glGetUniformLocation(shaderProgram, "objectColor"), 1, glm::value_ptr(ball->color));
-
-            glBindVertexArray(ball->VAO);
-            glDrawElements(GL_TRIANGLES, ball->indices.size(), GL_UNSIGNED_INT, 0);
+        ballInstances.clear();
+        for (int number = 0; number < (int)ballMeshes.size(); number++) {
+            glm::vec3 position;
+            if (!shownBall(number, position)) continue;
+            ballInstances.push_back({ position, ballRadius, ballMeshes[number]->color });
         }
-    }
-
-    void renderCueBall() {
-        if(cueBall->pocketed) return;
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, cueBall->position);
-        model = glm::scale(model, glm::vec3(cueBall->radius));
+        ballInstances.insert(ballInstances.end(), stressBalls.begin(), stressBalls.end());
 
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        // Camera and light come from the Frame block; the rest is per instance
+        ballShader->use();
+        if (!ballInstances.empty()) renderCounts.bufferUploads++;
+        renderCounts.drawCalls += ballMesh->draw(ballInstances);
 
-        // Set white color for cue ball
-        glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 1.0f, 1.0f, 1.0f);
-
-        glBindVertexArray(cueBall->VAO);
-        glDrawElements(GL_TRIANGLES, cueBall->indices.size(), GL_UNSIGNED_INT, 0);
+        // The cue is drawn with the basic shader after this
+        shader->use();
     }
 
     void renderPauseOverlay() {
@@ -927,7 +899,7 @@ private:
             			glm::vec3(1.0f, 1.0f, 1.0f));
 
 		// Render winner text
-		textRender->RenderText("Player " + std::to_string(playerWon) + " wins!",
+		textRender->RenderText("Player " + std::to_string(view().rules.playerWon) + " wins!",
             			500.0f,
             			500.0f,
             			1.5f,
@@ -964,42 +936,101 @@ private:
         // Draw full screen quad
         glBindVertexArray(overlayVAO);
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        renderCounts.drawCalls++;
         glBindVertexArray(0);
     }
 
+    // HUD lines are retained labels, kept in the order they are drawn each frame, so
+    // only a line whose text changed is laid out again
+    void hudLine(size_t& slot, std::string_view text, float x, float y, float scale) {
+        if (slot == hudLabels.size()) hudLabels.emplace_back();
+        textRender->RenderLabel(hudLabels[slot++], text, x, y, scale, glm::vec3(1.0f, 1.0f, 1.0f));
+    }
+
     void renderText() {
-        textRender->RenderText("Nenad Gvozdenac", 980.0f, 825.0f, 1.25f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("RA 133/2021", 980.0f, 800.0f, 1.25f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-        textRender->RenderText("Current player: Player " + std::to_string(currentPlayer), 5.0f, 825.0f, 1.25f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("Next ball: " + std::to_string(lowestBallNumber) + " [" + ballNames[lowestBallNumber] + "]", 5.0f, 790.0f, 1.25f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("Controls: ", 5.0f, 755.0f, 1.25f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("CTRL + 1, 2, 3, 4, 5 - Switch camera", 5.0f, 730.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("ALT + 1, 2, 3 - Zoom camera", 5.0f, 705.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("Mouse - Rotate cue", 5.0f, 680.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("1, 2, 3, 4, 5 - Switch hit strength", 5.0f, 655.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-        textRender->RenderText("Space - Hit cue ball", 5.0f, 630.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-        textRender->RenderText("Current camera: " + getCurrentCamera(), 5.0f, 30.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-
-        if (foulThisTurn) {
-            textRender->RenderText("Foul committed! Opponent's turn!", 450.0f, 630.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+        size_t slot = 0;
+        hudLine(slot, "Nenad Gvozdenac", 980.0f, 825.0f, 1.25f);
+        hudLine(slot, "RA 133/2021", 980.0f, 800.0f, 1.25f);
+
+        // Changing lines are formatted on the stack, not concatenated on the heap
+        const NineBallRules& rules = view().rules;
+        char line[160];
+        std::snprintf(line, sizeof(line), "Current player: Player %d%s", rules.currentPlayer,
+            cpuOpponent && rules.currentPlayer == 2 ? " (CPU)" : "");
+        hudLine(slot, line, 5.0f, 825.0f, 1.25f);
+        std::snprintf(line, sizeof(line), "Next ball: %d [%s]", rules.lowestBallNumber, ballNames[rules.lowestBallNumber].c_str());
+        hudLine(slot, line, 5.0f, 790.0f, 1.25f);
+        hudLine(slot, "Controls: ", 5.0f, 755.0f, 1.25f);
+        hudLine(slot, "CTRL + 1, 2, 3, 4, 5 - Switch camera", 5.0f, 730.0f, 1.0f);
+        hudLine(slot, "ALT + 1, 2, 3 - Zoom camera", 5.0f, 705.0f, 1.0f);
+        hudLine(slot, "Mouse - Rotate cue", 5.0f, 680.0f, 1.0f);
+        hudLine(slot, "1, 2, 3, 4, 5 - Switch hit strength", 5.0f, 655.0f, 1.0f);
+        hudLine(slot, "Space - Hit cue ball", 5.0f, 630.0f, 1.0f);
+        hudLine(slot, "F1, F2, F3 - CPU opponent, F4 - Human opponent", 5.0f, 605.0f, 1.0f);
+        hudLine(slot, "F5 - Replay, F6 - Physics stats", 5.0f, 580.0f, 1.0f);
+
+        std::snprintf(line, sizeof(line), "Arrows - Cue tip: %.1f %s, %.1f %s", std::abs(cueTip.x), cueTip.x < 0.0f ? "left" : "right",
+            std::abs(cueTip.y), cueTip.y < 0.0f ? "draw" : "follow");
+        hudLine(slot, line, 5.0f, 555.0f, 1.0f);
+
+        std::snprintf(line, sizeof(line), "Current camera: %s", getCurrentCamera().c_str());
+        hudLine(slot, line, 5.0f, 30.0f, 1.0f);
+
+        if (rules.foulThisTurn) {
+            hudLine(slot, "Foul committed! Opponent's turn!", 450.0f, 630.0f, 1.0f);
         }
+
+        if (showPhysicsStats) {
+            std::snprintf(line, sizeof(line), "Physics%s: %d steps last tick, at most %d, %d resting, %.0f ms dropped, shot shown %.0f ms after the key",
+                physics->running() ? " thread" : "", view().frame.steps, view().mostStepsPerFrame,
+                view().total.restingSteps, view().total.droppedTime * 1000.0, inputLatency * 1000.0);
+            hudLine(slot, line, 5.0f, 55.0f, 1.0f);
+
+            std::snprintf(line, sizeof(line), "Render: %zu balls in %d draw calls, %d uniform and %d buffer uploads, %.2f ms CPU; text %d kept, %d laid out",
+                ballInstances.size(), lastRenderCounts.drawCalls, lastRenderCounts.uniformUploads,
+                lastRenderCounts.bufferUploads, lastRenderCounts.cpuTime * 1000.0, lastRenderCounts.labelHits,
+                lastRenderCounts.layouts);
+            hudLine(slot, line, 5.0f, 80.0f, 1.0f);
+        }
+    }
+
+    void renderReplayText() {
+        size_t slot = 0;
+        char status[128];
+        std::snprintf(status, sizeof(status), "Replay: shot %d/%zu, %.1f/%.1f s, speed %gx%s",
+            replay.currentShot() + 1, replay.shotCount(), replay.currentTime(), replay.duration(),
+            replay.speed, replay.paused ? " (paused)" : "");
+
+        hudLine(slot, status, 5.0f, 825.0f, 1.25f);
+        hudLine(slot, "Left, Right - Seek 5 seconds", 5.0f, 790.0f, 1.0f);
+        hudLine(slot, "1, 2, 3, 4, 5 - Speed 0.25x to 4x", 5.0f, 765.0f, 1.0f);
+        hudLine(slot, "Space - Pause, F5 - Back to the game", 5.0f, 740.0f, 1.0f);
     }
 
     void render() {
+        double start = glfwGetTime();
+        renderCounts = RenderCounts();
+        textRender->drawCalls = 0;
+        textRender->bufferUploads = 0;
+        textRender->labelHits = 0;
+        textRender->layouts = 0;
+        Shader::uniformUploads = 0;
+
         glClearColor(0.1f, 0.3f, 0.3f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        updateFrameUniforms();
         renderTable();
-        renderCueBall();
         renderBalls();
 
-        if (canShoot && !cueBall->pocketed) {
+        if (!replaying && canShootNow() && cueBallOnTable()) {
             renderCue();
         }
 
-        if (gameStatus == GameStatus::PLAYING || gameStatus == GameStatus::NOT_STARTED) {
+        if (replaying) {
+            renderReplayText();
+        }
+        else if (gameStatus == GameStatus::PLAYING || gameStatus == GameStatus::NOT_STARTED) {
             renderText();
         }
 
@@ -1012,6 +1043,17 @@ private:
             renderOverlayBackground();
 			renderEndScreen();
         }
+
+        // Every string of the frame in one draw, over everything else
+        textRender->flush();
+
+        renderCounts.drawCalls += textRender->drawCalls;
+        renderCounts.bufferUploads += textRender->bufferUploads;
+        renderCounts.labelHits = textRender->labelHits;
+        renderCounts.layouts = textRender->layouts;
+        renderCounts.uniformUploads = Shader::uniformUploads;
+        renderCounts.cpuTime = glfwGetTime() - start;
+        lastRenderCounts = renderCounts;
     }
 
     std::string getCurrentCamera() {
@@ -1036,121 +1078,120 @@ private:
 
     void resetCue() {
 		cueAngle = 1.5708f;
+        cueTip = glm::vec2(0.0f);
         cue->setShotPower(2.0f);
         cue->updateGeometry();
 	}
 
+    // Physics side; the cue is reset once the snapshot shows the respot
     void resetCueBall() {
         // Reset cue ball position to starting position
-        cueBall->position = glm::vec3(-1.0f, tableHeight, 0.0f);
-        cueBall->velocity = glm::vec3(0.0f);
-        cueBall->pocketed = false;
-        resetCue();
+        size_t ball = cueBall();
+        world.balls.setPosition(ball, rules.foulPosition);
+        world.balls.setVelocity(ball, glm::vec2(0.0f));
+        world.balls.setSpin(ball, glm::vec3(0.0f));
+        world.balls.setPocketed(ball, false);
     }
 
+    // Physics side, once per step
     void updatePhysics(float frameTime) {
-        float deltaTime = frameTime;
-        bool allBallsStopped = true;
+        world.step(frameTime);
+        recorder.recordStep(world);
 
-        if (!cueBall->pocketed) {
-            cueBall->update(deltaTime);
-            if (glm::length(cueBall->velocity) > 0.01f) {
-                allBallsStopped = false;
-            }
-        }
+        rules.processEvents(world, world.events);
+        world.events.clear();
 
-        for (const auto& ball : balls) {
-            if (!ball->pocketed) {
-                ball->update(deltaTime);
-                if (glm::length(ball->velocity) > 0.01f) {
-                    allBallsStopped = false;
-                }
+        // When all balls stop, evaluate the turn
+        if (world.isAtRest() && !canShoot) {
+            recorder.endShot(world);
+            TurnResult result = rules.evaluateTurn(world);
+            turns++;
+            gameOver = result.gameOver;
+            respotted = result.respotCueBall;
+
+            // If there was a foul this turn, reset the cue ball position
+            if (result.respotCueBall) {
+                resetCueBall();
             }
         }
 
-        // Only check for pocketed balls while balls are in motion
-        if (!allBallsStopped) {
-            checkBallsPocketed();
+        // Allow shooting again if all balls have stopped
+        if (world.isAtRest()) {
+            canShoot = true;
         }
+    }
 
-        // When all balls stop, evaluate the turn
-        if (allBallsStopped && !canShoot) {
-            evaluateTurn();
-        }
+    // Physics side, after the steps of each tick
+    void publishState(SimulationSnapshot& snapshot) {
+        snapshot.rules = rules;
+        snapshot.canShoot = canShoot;
+        snapshot.gameOver = gameOver;
+        snapshot.turns = turns;
+        snapshot.respotted = respotted;
+    }
 
-        // Ball collision physics
-        if (!cueBall->pocketed) {
-            for (const auto& ball : balls) {
-                if (!ball->pocketed && cueBall->checkCollision(ball.get())) {
-                    handleBallCollision(cueBall.get(), ball.get());
-                    cueBall->resolveCollision(ball.get());
-                }
-            }
-        }
+    // Game side: acts on turns that finished since the last frame
+    void followTurns() {
+        if (view().turns == turnsSeen) return;
+        turnsSeen = view().turns;
 
-        // Rest of the existing physics code...
-        for (size_t i = 0; i < balls.size(); i++) {
-            if (balls[i]->pocketed) continue;
-            for (size_t j = i + 1; j < balls.size(); j++) {
-                if (balls[j]->pocketed) continue;
-                if (balls[i]->checkCollision(balls[j].get())) {
-                    balls[i]->resolveCollision(balls[j].get());
-                }
-            }
-        }
+        if (view().respotted) resetCue();
+        if (view().gameOver) gameStatus = GameStatus::FINISHED;
+    }
 
-        // Allow shooting again if all balls have stopped
-        if (allBallsStopped) {
-            canShoot = true;
-        }
+    // A snapshot taken before the last strike still offers the shot
+    bool canShootNow() const {
+        return view().canShoot && view().sequence != shotSequence;
+    }
 
-        if (!cueBall->pocketed) {
-            for (const Edge& edge : tableEdges) {
-                if (cueBall->checkEdgeCollision(edge)) {
-                    cueBall->resolveEdgeCollision(edge);
-                }
-            }
-        }
+    bool cpuTurn() const {
+        return cpuOpponent && !replaying && view().rules.currentPlayer == 2 && canShootNow() && cueBallOnTable() &&
+            (gameStatus == GameStatus::PLAYING || gameStatus == GameStatus::NOT_STARTED);
+    }
 
-        for (const auto& ball : balls) {
-            if (!ball->pocketed) {
-                for (const Edge& edge : tableEdges) {
-                    if (ball->checkEdgeCollision(edge)) {
-                        ball->resolveEdgeCollision(edge);
-                    }
-                }
-            }
+    void updateComputer() {
+        if (!cpuTurn()) return;
+
+        if (!cpuSearch) {
+            World table;
+            NineBallRules state;
+            physics->withState([this, &table, &state]() {
+                table = world;
+                state = rules;
+            });
+            cpuSearch = jobs.submit([this, table, state]() {
+                cpuDecision = ai.chooseShot(table, state);
+            });
+            return;
         }
+
+        if (!JobSystem::finished(cpuSearch)) return;
+
+        cpuSearch.reset();
+        AIDecision decision = cpuDecision;
+        cueAngle = decision.shot.angle;
+        cueTip = decision.shot.tipOffset;
+        cue->setShotPower(decision.shot.power);
+        cue->updateGeometry();
+        executeShot(glfwGetTime());
     }
 
-    void evaluateTurn() {
-        // If wrong ball was hit first, it's a foul
-        if (!firstBallHitCorrect) {
-            handleFoul();
-        }
-        
-        // If no balls were pocketed, switch players
-        if (!ballsPocketedThisTurn && firstBallHitCorrect) {
-            currentPlayer = (currentPlayer == 1) ? 2 : 1;
-        }
+    // Waits for a search still running, which uses ai and this, and forgets its result
+    void dropComputerSearch() {
+        if (!cpuSearch) return;
+        jobs.wait(cpuSearch);
+        cpuSearch.reset();
+    }
 
-        // If 9-ball was pocketed, its a win
-        if (balls.at(8)->pocketed && foulThisTurn) {
-            handleLose();
-        }
-        else if (balls.at(8)->pocketed) {
-			handleWin();
-		}
+    void setOpponent(bool computer, AIDifficulty difficulty) {
+        if (computer == cpuOpponent && difficulty == cpuDifficulty) return;
 
-        // If there was a foul this turn, reset the cue ball position
-        if (foulThisTurn || cueBall->pocketed) {
-            resetCueBall();
-        }
+        // A search still running was made for the old settings
+        dropComputerSearch();
 
-        // Reset turn tracking variables
-        firstBallHit = -1;
-        firstBallHitCorrect = false;
-        ballsPocketedThisTurn = false;
+        cpuOpponent = computer;
+        cpuDifficulty = difficulty;
+        ai.setDifficulty(difficulty);
     }
 
     void openPauseOverlay() {
@@ -1163,207 +1204,247 @@ private:
 	}
     
     void restartGame() {
+        // Drop a computer shot searched for the old table
+        dropComputerSearch();
+
         // Reset game state
-        currentPlayer = 1;
-        lowestBallNumber = 1;
-        firstBallHit = -1;
-        firstBallHitCorrect = false;
-        ballsPocketedThisTurn = false;
-        foulThisTurn = false;
-        playerWon = 0;
-
-        initializeBalls();
-        resetCueBall();
+        physics->withState([this]() {
+            rules.reset();
+            initializeBalls();
+            resetCueBall();
+            gameOver = false;
+        });
         resetCue();
 
         gameStatus = GameStatus::NOT_STARTED;
     }
 
-    void handleInput() {
+    void toggleReplay() {
+        if (replaying) {
+            replay.close();
+            replaying = false;
+            return;
+        }
+
+        bool saved = false;
+        physics->withState([this, &saved]() {
+            saved = recorder.shotCount() > 0 && recorder.save("replay.bin");
+        });
+        if (!saved || !replay.open("replay.bin")) return;
+        replay.speed = 1.0f;
+        replay.paused = false;
+        replaying = true;
+    }
+
+    void handleReplayInput(int key) {
+        const float speeds[] = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+        const int speedKeys[] = { GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_5 };
+        for (int i = 0; i < 5; i++) {
+            if (key == speedKeys[i]) replay.speed = speeds[i];
+        }
+
+        if (key == GLFW_KEY_SPACE) replay.paused = !replay.paused;
+        if (key == GLFW_KEY_LEFT) replay.seek(replay.currentTime() - 5.0);
+        if (key == GLFW_KEY_RIGHT) replay.seek(replay.currentTime() + 5.0);
+    }
+
+    // A key press while playing; time is when it arrived
+    void handleInput(int key, int mods, double time) {
         if(gameStatus != GameStatus::PLAYING && gameStatus != GameStatus::NOT_STARTED) return;
 
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        if (key == GLFW_KEY_F5) toggleReplay();
+        if (key == GLFW_KEY_F6) showPhysicsStats = !showPhysicsStats;
+        if (replaying) {
+            handleReplayInput(key);
+            return;
+        }
+
+        if (key == GLFW_KEY_ESCAPE)
             openPauseOverlay();
 
         // Check for CTRL + number combinations
-        bool ctrlPressed = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS ||
-            glfwGetKey(window, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS;
+        bool ctrlPressed = (mods & GLFW_MOD_CONTROL) != 0;
 
         if (ctrlPressed) {
-            if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) camera.setView(1);
-            if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) camera.setView(2);
-            if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) camera.setView(3);
-            if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS) camera.setView(4);
-            if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS) camera.setView(5);
+            if (key == GLFW_KEY_1) camera.setView(1);
+            if (key == GLFW_KEY_2) camera.setView(2);
+            if (key == GLFW_KEY_3) camera.setView(3);
+            if (key == GLFW_KEY_4) camera.setView(4);
+            if (key == GLFW_KEY_5) camera.setView(5);
 
-            if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) resetCue();
+            if (key == GLFW_KEY_R) resetCue();
         }
 
-        bool altPressed = glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS ||
-			glfwGetKey(window, GLFW_KEY_RIGHT_ALT) == GLFW_PRESS;
+        bool altPressed = (mods & GLFW_MOD_ALT) != 0;
 
         if (altPressed) {
-            if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS) camera.setZoom(0);
-            if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS) camera.setZoom(1);
-            if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS) camera.setZoom(2);
+            if (key == GLFW_KEY_1) camera.setZoom(0);
+            if (key == GLFW_KEY_2) camera.setZoom(1);
+            if (key == GLFW_KEY_3) camera.setZoom(2);
         }
 
+        // F1-F3 make player 2 the computer (easy, medium, hard), F4 a human again
+        if (key == GLFW_KEY_F1) setOpponent(true, AI_EASY);
+        if (key == GLFW_KEY_F2) setOpponent(true, AI_MEDIUM);
+        if (key == GLFW_KEY_F3) setOpponent(true, AI_HARD);
+        if (key == GLFW_KEY_F4) setOpponent(false, cpuDifficulty);
+
         // Check for shot power input
-        if (canShoot) {
-            if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS && !altPressed && !ctrlPressed) {
-                cue->setShotPower(2.0f);
-                cue->updateGeometry();
-            }
-            if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS && !altPressed && !ctrlPressed) {
-				cue->setShotPower(4.0f);
-				cue->updateGeometry();
-			}
-            if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && !altPressed && !ctrlPressed) {
-                cue->setShotPower(6.0f);
-                cue->updateGeometry();
+        if (canShootNow() && !cpuTurn()) {
+            const float powers[] = { 2.0f, 4.0f, 6.0f, 8.0f, 10.0f };
+            const int powerKeys[] = { GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_5 };
+            for (int i = 0; i < 5; i++) {
+                if (key == powerKeys[i] && !altPressed && !ctrlPressed) {
+                    cue->setShotPower(powers[i]);
+                    cue->updateGeometry();
+                }
             }
-            if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS && !altPressed && !ctrlPressed) {
-				cue->setShotPower(8.0f);
-				cue->updateGeometry();
-			}
-            if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS && !altPressed && !ctrlPressed) {
-				cue->setShotPower(10.0f);
-				cue->updateGeometry();
-			}
+
+            // Arrows move the cue tip across the ball in tenths of its radius
+            glm::vec2 tipStep(0.0f);
+            if (key == GLFW_KEY_LEFT) tipStep.x = -0.1f;
+            if (key == GLFW_KEY_RIGHT) tipStep.x = 0.1f;
+            if (key == GLFW_KEY_UP) tipStep.y = 0.1f;
+            if (key == GLFW_KEY_DOWN) tipStep.y = -0.1f;
+            cueTip = glm::clamp(cueTip + tipStep, -maxTipOffset, maxTipOffset);
 
             // Execute shot on spacebar press
-            if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-                executeShot();
+            if (key == GLFW_KEY_SPACE) {
+                executeShot(time);
             }
         }
     }
 
-    void handlePauseInput(GLFWwindow* window) {
-        if (gameStatus != GameStatus::PAUSED) return;
-
-        // Get mouse position
-        double mouseX, mouseY;
-        glfwGetCursorPos(window, &mouseX, &mouseY);
-
+    // Index of the menu button under the cursor, or -1
+    int hoveredButton(const std::vector<Button>& buttons) const {
         // Convert screen coordinates if necessary
-        // You might need to adjust this based on your coordinate system
         int windowHeight;
         glfwGetWindowSize(window, nullptr, &windowHeight);
-        mouseY = windowHeight - mouseY - 75; // Flip Y coordinate if needed
+        double mouseX = cursorX;
+        double mouseY = windowHeight - cursorY - 75; // Flip Y coordinate if needed
 
-        // Check button hover
-        for (size_t i = 0; i < pauseButtons.size(); i++) {
-            if (pauseButtons[i].isHovered(mouseX, mouseY)) {
-                selectedButton = i;
-
-                // Handle click
-                if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-                    if (i == 0) { // Continue
-                        closePauseOverlay();
-                    }
-                    else if (i == 1) { // Exit
-                        glfwSetWindowShouldClose(window, true);
-                    }
-                }
-            }
-        }
-
-        if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
-            if (selectedButton == 0) {
-                closePauseOverlay();
-            }
-            else if (selectedButton == 1) {
-                glfwSetWindowShouldClose(window, true);
-            }
+        for (size_t i = 0; i < buttons.size(); i++) {
+            if (buttons[i].isHovered(mouseX, mouseY)) return (int)i;
         }
+        return -1;
     }
 
-    void handleEndInput(GLFWwindow* window) {
-		if (gameStatus != GameStatus::FINISHED) return;
+    // Menus: hovering selects a button; a click on it or Enter presses the selected one.
+    // Returns true if a button was pressed.
+    bool menuPressed(const std::vector<Button>& buttons, const InputEvent& event) {
+        int hovered = hoveredButton(buttons);
+        if (event.type == INPUT_CURSOR && hovered >= 0) selectedButton = hovered;
 
-		// Get mouse position
-		double mouseX, mouseY;
-		glfwGetCursorPos(window, &mouseX, &mouseY);
+        bool clicked = event.type == INPUT_BUTTON_DOWN && event.code == GLFW_MOUSE_BUTTON_LEFT && hovered >= 0;
+        if (clicked) selectedButton = hovered;
+        return clicked || (event.type == INPUT_KEY_DOWN && event.code == GLFW_KEY_ENTER);
+    }
 
-		// Convert screen coordinates if necessary
-		int windowHeight;
-		glfwGetWindowSize(window, nullptr, &windowHeight);
-		mouseY = windowHeight - mouseY - 75; // Flip Y coordinate if needed
+    void handlePauseInput(const InputEvent& event) {
+        if (gameStatus != GameStatus::PAUSED) return;
+        if (!menuPressed(pauseButtons, event)) return;
 
-		// Check button hover
-        for (size_t i = 0; i < endButtons.size(); i++) {
-            if (endButtons[i].isHovered(mouseX, mouseY)) {
-				selectedButton = i;
-
-				// Handle click
-                if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-					if (i == 0) { // Restart
-                        restartGame();
-                    }
-					else if (i == 1) { // Exit
-                        glfwSetWindowShouldClose(window, true);
-                    }
-				}
-			}
-		}
+        if (selectedButton == 0) { // Continue
+            closePauseOverlay();
+        }
+        else if (selectedButton == 1) { // Exit
+            glfwSetWindowShouldClose(window, true);
+        }
+    }
 
-        if (glfwGetKey(window, GLFW_KEY_ENTER) == GLFW_PRESS) {
-            if (selectedButton == 0) {
-				restartGame();
-			}
-            else if (selectedButton == 1) {
-				glfwSetWindowShouldClose(window, true);
-			}
-		}
-	}
+    void handleEndInput(const InputEvent& event) {
+        if (gameStatus != GameStatus::FINISHED) return;
+        if (!menuPressed(endButtons, event)) return;
+
+        if (selectedButton == 0) { // Restart
+            restartGame();
+        }
+        else if (selectedButton == 1) { // Exit
+            glfwSetWindowShouldClose(window, true);
+        }
+    }
 
     void createShaders() {
         shader = std::make_unique<Shader>("basic.vert", "basic.frag");
         shaderProgram = shader->shaderProgram;
+        modelLocation = shader->uniformLocation("model");
+        objectColorLocation = shader->uniformLocation("objectColor");
+        ballShader = std::make_unique<Shader>("ball.vert", "ball.frag");
+
+        // Filled by updateFrameUniforms(); every program's Frame block reads from it
+        glGenBuffers(1, &frameUniformBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformBinding, frameUniformBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
 
 public:
-    BilliardsGame() {
+    BilliardsGame(const std::string& tablePath, bool physicsThread, const std::string& recordInput, int renderBalls)
+        : table(standardTableGeometry()), inputLogPath(recordInput) {
+        // The table file is read, and its boundary field built, on a worker while the
+        // window and text renderer come up
+        JobHandle tableLoaded = jobs.submit([this, tablePath]() {
+            if (!tablePath.empty()) {
+                std::string error;
+                if (!loadTableGeometry(tablePath, table, error)) {
+                    std::cerr << "Failed to load table, using the standard one: " << error << std::endl;
+                }
+            }
+            applyTableGeometry(world, table);
+        });
+
         initOpenGL();
         initTextRender();
         initOverlay();
         initOverlays();
 
-        // Initialize player-related variables
-        currentPlayer = 1;  // Player 1 starts
-        lowestBallNumber = 1;  // Start with ball 1
-        firstBallHit = -1;
-        firstBallHitCorrect = false;
-        ballsPocketedThisTurn = false;
-        foulPosition = glm::vec3(-1.0f, tableHeight, 0.0f);
-
         gameStatus = GameStatus::NOT_STARTED;
-
-        initializeEdges();
         lastFrameTime = glfwGetTime();
+        startupTime = lastFrameTime;
 
         // Set the user pointer for the window to this instance
         glfwSetWindowUserPointer(window, this);
 
-        // Set mouse callback function
+        // Input callbacks only queue events for the game loop
         glfwSetCursorPosCallback(window, mouseCallback);
+        glfwSetMouseButtonCallback(window, mouseButtonCallback);
+        glfwSetKeyCallback(window, keyCallback);
 
         createShaders();
-        setupTable();
-        setupEdges();
-        setupHoles();
+
+        // The table meshes need the geometry and the GL context, so they are built on
+        // this thread once the table is in
+        jobs.wait(jobs.submitMain([this]() {
+            setupTable();
+            setupEdges();
+            setupHoles();
+        }, { tableLoaded }));
+
+        // Fixed steps and per-step state hashes, so a shot can be reproduced exactly, and
+        // fixed-point state so the replay keyframes store it compactly
+        world.deterministic = true;
+        world.fixedPoint = true;
+        // Sliding, rolling and spin, so the cue tip offset gives follow, draw and english
+        world.motionModel = MOTION_SPIN;
 
         // Initialize projection matrix with new window dimensions
         projection = glm::perspective(glm::radians(45.0f), 1200.0f / 1000.0f, 0.1f, 100.0f);
 
-        // Initialize cue ball
-
-        // Create cue ball (white)
-        cueBall = std::make_unique<Ball>(-1.2f, tableHeight, 0.0f, ballRadius, glm::vec3(1.0f, 1.0f, 1.0f), 0);
         cue = std::make_unique<Cue>(2.5f, 0.025f);
 
-        // Initialize balls
-        initializeBalls();
+        physics = std::make_unique<PhysicsThread>(world,
+            [this](float deltaTime) { updatePhysics(deltaTime); },
+            [this](SimulationSnapshot& snapshot) { publishState(snapshot); });
+
+        // Initialize balls (the cue ball starts at -1.2 on the first rack)
+        initializeBallMeshes();
+        addStressBalls(renderBalls);
+        physics->withState([this]() { initializeBalls(); });
+
+        if (physicsThread) {
+            physics->start();
+        }
     }
 
     void run() {
@@ -1371,20 +1452,27 @@ public:
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         double lastTime = glfwGetTime();
-        double accumulator = 0.0;
 
         while (!glfwWindowShouldClose(window)) {
             double currentTime = glfwGetTime();
-            accumulator += currentTime - lastTime;
+            double elapsed = currentTime - lastTime;
             lastTime = currentTime;
 
-            handleInput();
-            handlePauseInput(window);
-            handleEndInput(window);
+            // The physics thread steps on its own; otherwise the game steps it here
+            if (!physics->running() && !replaying) {
+                physics->update(elapsed);
+            }
+            physics->acquire();
+            followTurns();
+            measureInputLatency();
+
+            processInput();
+            updateComputer();
+            // GL work that jobs handed back to this thread
+            jobs.runMainThreadJobs();
 
-            while (accumulator >= frameTime) {
-                updatePhysics(frameTime);
-                accumulator -= frameTime;
+            if (replaying) {
+                replay.advance(elapsed);
             }
 
             render();
@@ -1394,16 +1482,53 @@ public:
         cleanup();
     }
 
+    // Lays out and draws the full HUD, F6 lines included, for a number of frames and
+    // prints the time per frame. glFinish() holds each frame until the GPU is done, so
+    // the time covers the draw as well as the calls that issue it. Startup and font
+    // atlas times follow, to compare a cold start (no atlas cache file) with a warm one.
+    void benchmarkText(int frames) {
+        physics->update(frameTime);
+        physics->acquire();
+        showPhysicsStats = true;
+        textRender->drawCalls = 0;
+        textRender->bufferUploads = 0;
+        textRender->labelHits = 0;
+        textRender->layouts = 0;
+
+        // The blend state run() draws with, so the frames cost what they do in the game
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        double start = glfwGetTime();
+        for (int i = 0; i < frames; i++) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderText();
+            textRender->flush();
+            glFinish();
+        }
+        double elapsed = glfwGetTime() - start;
+
+        std::printf("HUD text: %.3f ms per frame over %d frames, %.1f draw calls and %.1f buffer uploads per frame\n",
+            elapsed * 1000.0 / frames, frames, (double)textRender->drawCalls / frames, (double)textRender->bufferUploads / frames);
+        std::printf("Labels: %d drawn as kept, %d laid out\n", textRender->labelHits, textRender->layouts);
+        std::printf("Startup: %.1f ms, font atlas %.1f ms %s\n", startupTime * 1000.0, textRender->atlasLoadTime,
+            textRender->atlasFromCache ? "read from its cache file" : "baked and cached");
+    }
+
     void cleanup() {
-        for (const auto& ball : balls) {
-            ball->cleanup();
+        physics->stop();
+        dropComputerSearch();
+
+        std::string error;
+        if (!inputLogPath.empty() && !saveInputLog(inputLogPath, inputLog, error)) {
+            std::cerr << error << std::endl;
         }
 
-        cueBall->cleanup();
+        ballMesh->cleanup();
 
         cue->cleanup();
 
-        balls.clear();
+        ballMeshes.clear();
 
         glDeleteVertexArrays(1, &tableVAO);
         glDeleteBuffers(1, &tableVBO);
@@ -1411,13 +1536,38 @@ public:
         glDeleteVertexArrays(1, &edgesVAO);
         glDeleteBuffers(1, &edgesVBO);
         glDeleteBuffers(1, &edgesEBO);
+        glDeleteBuffers(1, &frameUniformBuffer);
         glDeleteProgram(shaderProgram);
         glfwTerminate();
     }
 };
 
-int main() {
-    BilliardsGame game;
-    game.run();
+int main(int argc, char** argv) {
+    // Optional table file, e.g. tables/7ft.table, --physics-thread to step the physics
+    // on a thread of its own, --record-input <file> to save the input events, and
+    // --render-balls <count> to draw that many extra balls over the cloth, and
+    // --benchmark-text <frames> to time drawing the HUD text and exit
+    std::string tablePath = "tables/standard.table";
+    std::string recordInput;
+    bool physicsThread = false;
+    int renderBalls = 0;
+    int benchmarkTextFrames = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--physics-thread") physicsThread = true;
+        else if (arg == "--record-input" && i + 1 < argc) recordInput = argv[++i];
+        else if (arg == "--render-balls" && i + 1 < argc) renderBalls = std::atoi(argv[++i]);
+        else if (arg == "--benchmark-text" && i + 1 < argc) benchmarkTextFrames = std::atoi(argv[++i]);
+        else tablePath = arg;
+    }
+
+    BilliardsGame game(tablePath, physicsThread, recordInput, renderBalls);
+    if (benchmarkTextFrames > 0) {
+        game.benchmarkText(benchmarkTextFrames);
+        game.cleanup();
+    }
+    else {
+        game.run();
+    }
     return 0;
 }
\ No newline at end of file
@@ -1,12 +1,16 @@
 #version 330 core
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
 uniform sampler2D text;
-uniform vec3 textColor;
 
 void main()
 {    
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+    // The atlas holds distance to the outline, 0.5 on it; fading over about a screen
+    // pixel keeps the edge sharp and smooth at any scale
+    float field = texture(text, TexCoords).r;
+    float edge = fwidth(field) * 0.7;
+    float alpha = smoothstep(0.5 - edge, 0.5 + edge, field);
+    color = vec4(TextColor, alpha);
 } 
\ No newline at end of file